@@ -8,11 +8,13 @@ mostrar_menu() {
     echo "3. MPI"
     echo "4. CUDA"
     echo "5. OpenMP + MPI"
+    echo "6. Conversor a librería binaria (bslib_convert)"
+    echo "7. Benchmarks (bioscreening_bench)"
     read -p "Ingrese el número de su elección: " choice
 }
 
 # Verifica si se pasó un argumento y si es válido (1, 2, 3 o 4)
-if [ $# -eq 0 ] || [[ "$1" != "1" && "$1" != "2" && "$1" != "3" && "$1" != "4" && "$1" != "5" ]]; then
+if [ $# -eq 0 ] || [[ "$1" != "1" && "$1" != "2" && "$1" != "3" && "$1" != "4" && "$1" != "5" && "$1" != "6" && "$1" != "7" ]]; then
     # Si no hay parámetro o es inválido, se muestra el menú interactivo
     mostrar_menu
 else
@@ -24,7 +26,7 @@ fi
 case $choice in
     1)
         echo "Compilando versión Secuencial..."
-        g++ -std=c++14 -Iinclude -o bioscreening src/seq/*.cpp src/*.cpp -O3
+        g++ -std=c++14 -Iinclude -o bioscreening src/seq/*.cpp src/*.cpp -O3 -pthread
         ;;
     2)
         echo "Compilando versión OpenMP..."
@@ -32,15 +34,23 @@ case $choice in
         ;;
     3)
         echo "Compilando versión MPI..."
-        mpic++ -std=c++14 -Iinclude -o bioscreening src/parallel/single/mpi/*.cpp src/*.cpp -O3
+        mpic++ -std=c++14 -Iinclude -o bioscreening src/parallel/single/mpi/*.cpp src/parallel/mpi_common/*.cpp src/*.cpp -O3 -pthread
         ;;
     4)
         echo "Compilando versión CUDA..."
-        /usr/local/cuda-12/bin/nvcc -std=c++14 -Iinclude -o bioscreening src/*.cpp src/parallel/single/cuda/*
+        /usr/local/cuda-12/bin/nvcc -std=c++14 -Iinclude -o bioscreening src/*.cpp src/parallel/single/cuda/* -lpthread
         ;;
     5)
         echo "Compilando versión OpenMP + MPI..."
-        mpic++ -std=c++14 -Iinclude -o bioscreening src/parallel/hibrid/omp_mpi/*.cpp src/*.cpp -O3 -lm -fopenmp
+        mpic++ -std=c++14 -Iinclude -o bioscreening src/parallel/hibrid/omp_mpi/*.cpp src/parallel/mpi_common/*.cpp src/*.cpp -O3 -lm -fopenmp
+        ;;
+    6)
+        echo "Compilando conversor de librerías..."
+        g++ -std=c++14 -Iinclude -o bslib_convert src/tools/convert/*.cpp src/*.cpp -lm -fopenmp -O3
+        ;;
+    7)
+        echo "Compilando benchmarks..."
+        g++ -std=c++14 -Iinclude -o bioscreening_bench src/tools/bench/*.cpp src/*.cpp -lm -fopenmp -O3 -pthread
         ;;
     *)
         echo "Opción no válida. Por favor, seleccione 1, 2, 3 o 4."
@@ -0,0 +1,65 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Measurement harness of the bioscreening_bench tool (src/tools/bench): warmup,
+// repeated samples, statistical summaries and JSON output.
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Summary of a set of samples. 'ci95' is the half-width of the 95% confidence interval
+// of the mean (Student's t), so the mean is mean +- ci95.
+struct BenchStats {
+    std::size_t samples = 0;
+    double mean = 0.0;
+    double median = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double stddev = 0.0;
+    double ci95 = 0.0;
+};
+
+BenchStats summarizeSamples(std::vector<double> samples);
+
+struct BenchConfig {
+    int warmup = 2;                  // Discarded samples before measuring
+    int repetitions = 10;            // Measured samples
+    double minSampleSeconds = 0.05;  // Micro-benchmarks repeat the body until a sample lasts this long
+};
+
+// One measured quantity of a benchmark (time per iteration, throughput...).
+struct BenchMetric {
+    std::string name;
+    std::string unit;
+    BenchStats stats;
+};
+
+struct BenchResult {
+    std::string group;               // Function or backend measured, e.g. "performDocking"
+    std::string name;                // Case within the group, e.g. "p1024_l32"
+    std::vector<std::pair<std::string, double>> params;
+    std::size_t iterationsPerSample = 1;
+    std::vector<BenchMetric> metrics;
+};
+
+// Micro-benchmark: 'body' is one iteration that processes 'work' units of 'workUnit'
+// (bytes, atom pairs...). Reports the time per iteration and the throughput.
+BenchResult runBenchmark(const BenchConfig& config, const std::string& group, const std::string& name,
+                         double work, const std::string& workUnit, const std::function<void()>& body);
+
+// End-to-end benchmark: every sample is one run of the shell 'command'. Reports the wall
+// time and, if the command prints "Execution time: X ms", that time as well.
+bool runCommandBenchmark(const BenchConfig& config, const std::string& group, const std::string& name,
+                         const std::string& command, BenchResult& result);
+
+void printBenchResult(const BenchResult& result);
+
+// Writes the results with the run metadata ('metadata' are string key/value pairs).
+bool writeBenchJson(const std::string& filename, const BenchConfig& config,
+                    const std::vector<std::pair<std::string, std::string>>& metadata,
+                    const std::vector<BenchResult>& results);
+
+#endif // BENCHMARK_H
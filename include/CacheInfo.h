@@ -0,0 +1,33 @@
+#ifndef CACHEINFO_H
+#define CACHEINFO_H
+
+#include <cstddef>
+#include <string>
+
+// Tamaños (en bytes) de la jerarquía de caché de la CPU en la que se ejecuta.
+struct CacheSizes {
+    std::size_t l1d;
+    std::size_t l2;
+    std::size_t l3;
+};
+
+// Detecta los tamaños de caché en tiempo de ejecución: sysconf (glibc) y, si no lo
+// ofrece, /sys/devices/system/cpu/cpu0/cache. Los niveles que no se puedan detectar
+// toman valores por defecto conservadores (32 KB, 1 MB, 8 MB). El resultado se calcula
+// una sola vez.
+const CacheSizes& getCacheSizes();
+
+// Tamaños de bloque para la ejecución por teselas proteína x ligando.
+struct TileSizes {
+    std::size_t proteinAtoms;   // Átomos de proteína por bloque (residentes en L1)
+    std::size_t ligands;        // Ligandos por lote (sus coordenadas caben en L2)
+};
+
+// Elige los bloques para que un bloque de coordenadas de proteína ocupe la mitad de L1
+// y un lote de ligandos de 'averageLigandAtoms' átomos la mitad de L2.
+TileSizes chooseTileSizes(const CacheSizes& caches, std::size_t averageLigandAtoms);
+
+// Descripción legible ("L1d 48 KB, L2 2048 KB, L3 307200 KB").
+std::string describeCacheSizes(const CacheSizes& caches);
+
+#endif // CACHEINFO_H
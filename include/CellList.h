@@ -0,0 +1,46 @@
+#ifndef CELLLIST_H
+#define CELLLIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Molecule.h"
+
+// Lista de celdas uniforme sobre los átomos de una proteína. Se construye una vez por
+// proteína con un tamaño de celda >= radio de corte, de modo que todos los vecinos de un
+// punto están en las 27 celdas que lo rodean. Los átomos se reordenan por celda (SoA),
+// así que las 3 celdas consecutivas en x de cada fila forman un único rango contiguo.
+class CellList {
+public:
+    CellList();
+
+    // Construye la lista para 'protein' con celdas de al menos 'cellSize' Å de lado.
+    void build(const Molecule& protein, float cellSize);
+
+    bool empty() const;
+    std::size_t getAtomCount() const;
+
+    // Rangos contiguos [begin, end) de átomos que pueden estar a menos de cellSize del
+    // punto (x, y, z). Devuelve el número de rangos escritos en 'begins'/'ends' (máx. 9).
+    int neighborRanges(float x, float y, float z, std::size_t* begins, std::size_t* ends) const;
+
+    // Coordenadas y elementos de los átomos ordenados por celda.
+    const float* getX() const;
+    const float* getY() const;
+    const float* getZ() const;
+    const uint8_t* getElements() const;
+
+private:
+    float cellSize;
+    float invCellSize;
+    float originX, originY, originZ;
+    int dimX, dimY, dimZ;
+    std::vector<uint32_t> cellStart;   // tamaño dimX * dimY * dimZ + 1
+    AlignedVector<float> xs;
+    AlignedVector<float> ys;
+    AlignedVector<float> zs;
+    AlignedVector<uint8_t> elements;
+};
+
+#endif // CELLLIST_H
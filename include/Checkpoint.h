@@ -0,0 +1,115 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Docking.h"
+#include "HitCollector.h"
+#include "Molecule.h"
+#include "Partition.h"
+
+// El trabajo pendiente se divide en al menos CHECKPOINT_MIN_UNITS unidades (y
+// CHECKPOINT_UNITS_PER_WORKER por hilo/proceso): cada unidad terminada es un registro
+// del checkpoint, así que una caída pierde como mucho las unidades en curso.
+const std::size_t CHECKPOINT_MIN_UNITS = 1024;
+const std::size_t CHECKPOINT_UNITS_PER_WORKER = 16;
+
+// Intervalo mínimo entre sincronizaciones (fdatasync) del fichero de checkpoint.
+const double CHECKPOINT_SYNC_SECONDS = 30.0;
+
+// Número de unidades de trabajo con checkpoint para 'workers' hilos/procesos.
+std::size_t checkpointUnits(std::size_t workers);
+
+// Hash de los parámetros que afectan a los scores, encadenado a 'seed'.
+uint64_t dockingParamsKey(const DockingParams& params, uint64_t seed);
+
+// Identifica el cálculo: moléculas, parámetros y criterio de hits. Sólo se reanudan
+// checkpoints con la misma clave.
+uint64_t checkpointKey(const std::vector<Molecule>& proteins, const std::vector<Molecule>& ligands,
+                       const DockingParams& params, const HitCriteria& criteria);
+
+// Rangos de [0, total) que no están en 'completed' (ordenados y disjuntos).
+std::vector<PairRange> pendingRanges(const std::vector<PairRange>& completed, std::size_t total);
+
+// Checkpoint de una ejecución en el directorio 'dir'. Cada escritor (hilo principal de
+// un proceso; 'writer' es su rank) añade registros a su propio fichero
+// "checkpoint-<writer>.bsck", que sólo crece:
+//
+//   CheckpointFileHeader
+//   { CheckpointRecord, scores[count] (float) o hits[count] (DockingResult) }...
+//
+// Cada registro es un rango de pares terminado con sus scores o, en modo de hits, con
+// los hits de ese rango; lleva un hash que permite descartar un final a medio escribir.
+// Los registros se escriben en un hilo aparte: recordScores()/recordHits() sólo copian
+// los datos a una cola, de modo que el cálculo nunca espera a la E/S.
+class Checkpoint {
+public:
+    Checkpoint();
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    // Abre el checkpoint. Con 'restore' (un único escritor, el que recoge los resultados)
+    // y 'resume' se leen todos los ficheros del directorio con la misma clave; con
+    // 'restore' y sin 'resume' se borran. El fichero propio se continúa al reanudar
+    // (recortando un posible final incompleto) y se empieza de cero en otro caso.
+    bool open(const std::string& dir, int writer, uint64_t key, bool resume, bool restore);
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Rangos restaurados (ordenados y disjuntos) y número de pares que cubren.
+    const std::vector<PairRange>& getCompleted() const { return completed; }
+    std::size_t getRestoredPairs() const;
+
+    // Copia a 'scores' (si no es nulo) los scores restaurados y mezcla en 'hits' (si no
+    // es nulo) los hits restaurados. Libera después los datos leídos.
+    void restore(float* scores, HitCollector* hits);
+
+    // Añade a los restaurados rangos ya calculados fuera del checkpoint (ordenados y
+    // disjuntos, con sus scores concatenados en 'scores'); no se escriben en el fichero.
+    void addRestored(const std::vector<PairRange>& ranges, const std::vector<float>& scores);
+
+    // Añaden un rango terminado a la cola de escritura. Se pueden llamar desde varios
+    // hilos a la vez.
+    void recordScores(const PairRange& range, const float* scores);
+    void recordHits(const PairRange& range, const HitCollector& hits);
+
+    // Escribe lo pendiente, sincroniza y cierra el fichero.
+    void close();
+
+private:
+    struct Restored {
+        PairRange range;
+        uint64_t scored;
+        bool hasScores;                    // Registro de scores (o de hits)
+        std::vector<float> scores;
+        std::vector<DockingResult> hits;
+    };
+
+    void acceptRecords(std::vector<Restored>& records);
+    bool readFile(const std::string& filename, bool keepData, std::vector<Restored>& records,
+                  long& validBytes) const;
+    void enqueue(const PairRange& range, uint64_t scored, uint32_t kind, const void* data,
+                 std::size_t count, std::size_t itemSize);
+    void writerLoop();
+
+    uint64_t key;
+    std::vector<PairRange> completed;
+    std::vector<Restored> restored;
+
+    FILE* file;
+    std::thread writerThread;
+    std::mutex mutex;
+    std::condition_variable pending;
+    std::vector<std::vector<char>> queue;
+    bool closing;
+};
+
+#endif // CHECKPOINT_H
@@ -1,20 +1,161 @@
 #ifndef DATAMANAGER_H
 #define DATAMANAGER_H
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "Molecule.h"
+#include "SdfReader.h"
+
+// Resumen de la última carga: ficheros encontrados, origen de cada molécula cargada
+// (en el mismo orden que el vector de salida) y errores agregados por fichero.
+// Las moléculas de un SDF con varios registros se identifican como "fichero@offset".
+struct LoadReport {
+    std::size_t filesFound = 0;
+    std::vector<std::string> sources;
+    std::vector<std::string> errors;
+};
 
 class DataManager {
 public:
     DataManager();
     ~DataManager();
 
-    // Carga proteínas desde un directorio o fichero
+    // Carga proteínas desde un directorio o fichero. Si 'path' es una librería binaria
+    // (.bslib, ver MoleculeLibrary.h) las moléculas son vistas sobre el fichero proyectado.
     bool loadProteins(const std::string& path, std::vector<Molecule>& proteins);
 
-    // Carga ligandos desde un directorio o fichero
+    // Carga ligandos desde un directorio o fichero (o una librería .bslib). Los SDF se
+    // leen en flujo y se cargan todos sus registros; los SDF mayores que el tamaño de
+    // fragmento se dividen en rangos de bytes que se parsean en paralelo.
     bool loadLigands(const std::string& path, std::vector<Molecule>& ligands);
+
+    // Informe de la última llamada a loadProteins/loadLigands.
+    const LoadReport& getLastReport() const;
+
+    // Tamaño de los fragmentos en que se dividen los SDF grandes (0: no dividir).
+    void setSDFChunkBytes(uint64_t bytes) { sdfChunkBytes = bytes; }
+
+    // Reparto de la carga entre varios procesos. Con 'count' > 1 sólo se parsea el
+    // fragmento 'index': un bloque contiguo de unidades de trabajo (ficheros o rangos de
+    // un SDF) de tamaño similar en bytes, así que concatenar los fragmentos 0..count-1
+    // reproduce la carga completa en el mismo orden. Un fragmento puede quedar vacío y
+    // la carga sólo falla si no se pudo enumerar 'path'. Una librería .bslib la carga
+    // entera el fragmento 0.
+    void setShard(std::size_t index, std::size_t count) { shardIndex = index; shardCount = count; }
+
+    // Lista ordenada de los ficheros de 'path' (o el propio fichero) con alguna de las
+    // extensiones dadas (en minúsculas, con punto).
+    static bool listFiles(const std::string& path, const std::vector<std::string>& extensions,
+                          std::vector<std::string>& files);
+
+    // Extensiones de los ficheros que cargan loadProteins y loadLigands.
+    static const std::vector<std::string>& proteinExtensions();
+    static const std::vector<std::string>& ligandExtensions();
+
+private:
+    bool loadFiles(const std::string& path, const std::vector<std::string>& extensions,
+                   std::vector<Molecule>& molecules);
+    bool loadLibrary(const std::string& path, std::vector<Molecule>& molecules);
+
+    LoadReport lastReport;
+    uint64_t sdfChunkBytes;
+    std::size_t shardIndex;
+    std::size_t shardCount;
+};
+
+// Carga en flujo: ficheros pequeños consecutivos que forman como mucho una unidad y
+// tamaño de los rangos en que se dividen los SDF grandes (más pequeños que en la carga
+// completa: cada unidad es un lote que se tiene entero en memoria).
+const std::size_t STREAM_UNIT_FILES = 64;
+const uint64_t STREAM_SDF_CHUNK_BYTES = 4ull << 20;
+
+// Hilos de carga y lotes parseados que pueden esperar en la cola por defecto.
+const std::size_t DEFAULT_STREAM_LOADERS = 2;
+const std::size_t DEFAULT_STREAM_QUEUE_BATCHES = 8;
+
+// Lote de la carga en flujo: moléculas consecutivas, en el orden de loadLigands, a partir
+// de la posición 'first'.
+struct MoleculeBatch {
+    std::size_t first = 0;
+    std::vector<Molecule> molecules;
+};
+
+// Carga de ligandos en flujo, para librerías que no caben en memoria. Unos hilos de
+// carga parsean las unidades (grupos de ficheros o rangos de un SDF) y las dejan en una
+// cola acotada; next() entrega los lotes en el orden de la lista de ficheros. La carga
+// no se adelanta más de 'capacity' unidades al consumo y cada lote se libera cuando el
+// consumidor lo descarta, así que la memoria no depende del tamaño de la librería y el
+// parseo se solapa con el cálculo. Una librería .bslib ya se sirve proyectada: sus lotes
+// son vistas sobre el fichero.
+class LigandStream {
+public:
+    LigandStream();
+    ~LigandStream();
+
+    LigandStream(const LigandStream&) = delete;
+    LigandStream& operator=(const LigandStream&) = delete;
+
+    // Empieza a cargar 'path'. Con 'shardCount' > 1 sólo se cargan las unidades del
+    // fragmento 'shardIndex' (ver DataManager::setShard).
+    bool open(const std::string& path, std::size_t loaders, std::size_t capacity,
+              std::size_t shardIndex = 0, std::size_t shardCount = 1);
+
+    // Siguiente lote (false cuando no quedan). Se puede llamar desde varios hilos.
+    bool next(MoleculeBatch& batch);
+
+    // Espera a los hilos de carga y muestra el resumen de errores.
+    void close();
+
+    // Moléculas y lotes entregados, máximo de unidades parseadas en espera y tiempo que
+    // los consumidores esperaron a la carga.
+    std::size_t getMolecules() const { return delivered; }
+    std::size_t getBatches() const { return batches; }
+    std::size_t getPeakQueued() const { return peakQueued; }
+    double getWaitSeconds() const { return waitSeconds; }
+
+private:
+    struct Unit {
+        std::size_t firstFile;
+        std::size_t lastFile;              // Exclusivo
+        bool split;                        // Rango de un SDF grande (si no, ficheros completos)
+        ByteRange range;
+        uint64_t bytes;                    // Tamaño estimado (sólo para repartir fragmentos)
+    };
+    struct Parsed {
+        std::vector<Molecule> molecules;
+        std::vector<std::string> errors;
+    };
+
+    void loaderLoop();
+
+    std::string path;
+    std::vector<std::string> files;
+    std::vector<uint64_t> sizes;
+    std::vector<Unit> units;
+    std::vector<Molecule> library;         // Vistas de una librería .bslib
+    std::vector<std::unique_ptr<Parsed>> ready;
+    std::vector<std::string> errors;
+
+    std::vector<std::thread> loaders;
+    std::mutex mutex;
+    std::condition_variable parsed;        // Hay una unidad más parseada
+    std::condition_variable consumed;      // Hay sitio en la cola
+    std::size_t capacity;
+    std::size_t nextUnit;                  // Siguiente unidad a parsear
+    std::size_t nextBatch;                 // Siguiente unidad a entregar
+    std::size_t queued;
+    bool closing;
+
+    std::size_t delivered;
+    std::size_t batches;
+    std::size_t peakQueued;
+    double waitSeconds;
 };
 
-#endif // DATAMANAGER_H
\ No newline at end of file
+#endif // DATAMANAGER_H
@@ -1,11 +1,147 @@
 #ifndef DOCKING_H
 #define DOCKING_H
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include "Molecule.h"
+#include "CellList.h"
+#include "ForceField.h"
+#include "Funnel.h"
+#include "GridMap.h"
+#include "Octree.h"
+#include "ScoreCache.h"
+
+// Anchura por defecto (Å) de la zona de suavizado antes del radio de corte.
+const float DEFAULT_SWITCH_WIDTH = 2.0f;
+
+// Parámetros del cálculo de energía.
+// cutoff <= 0 desactiva el corte (se evalúan todas las parejas de átomos).
+// Con corte, la energía se multiplica por una función de conmutación (switching)
+// entre switchDistance y cutoff para que sea continua y suave en el radio de corte.
+// Con grid.enabled, cada proteína se precalcula como rejillas de afinidad (GridMap.h).
+// forceField elige los parámetros LJ: uniformes o por pareja de elementos (ForceField.h).
+// Con funnel.enabled(), una etapa de grano grueso descarta antes la mayoría de pares.
+// Con octree.enabled, los átomos lejanos de la proteína se agrupan en un octree (Octree.h).
+// Con scoreCacheDir, los scores se reutilizan entre ejecuciones (ScoreCache.h).
+struct DockingParams {
+    float cutoff = 0.0f;
+    float switchDistance = -1.0f;   // < 0: cutoff - DEFAULT_SWITCH_WIDTH
+    ForceField forceField = FORCEFIELD_UNIFORM;
+    GridMapParams grid;
+    FunnelParams funnel;
+    OctreeParams octree;
+    std::string scoreCacheDir;      // vacío: sin caché de scores
+
+    bool useCutoff() const { return cutoff > 0.0f; }
+    float effectiveSwitchDistance() const;
+};
 
 // Función básica de docking que compara una proteína y un ligando.
 // Devuelve un score numérico (se usa el dummy implementado en performDocking)
-float performDocking(const Molecule& protein, const Molecule& ligand);
+float performDocking(const Molecule& protein, const Molecule& ligand,
+                     ForceField forceField = FORCEFIELD_UNIFORM);
+
+// Variante con radio de corte: sólo visita los átomos de la proteína en las celdas
+// vecinas de cada átomo del ligando. 'cells' debe haberse construido con un tamaño
+// de celda >= params.cutoff. Si 'interactions' no es nulo, recibe las parejas de átomos
+// calculadas.
+float performDocking(const CellList& cells, const Molecule& ligand, const DockingParams& params,
+                     std::size_t* interactions = nullptr);
+
+// Variante con rejillas precalculadas: una interpolación trilineal por átomo del
+// ligando. Los átomos fuera de la rejilla se evalúan de forma exacta frente a la
+// proteína (o a su lista de celdas si hay corte). 'interactions' recibe las consultas
+// a la rejilla más las parejas calculadas de forma exacta.
+float performDocking(const GridMapSet& maps, const Molecule& protein, const CellList* cells,
+                     const Molecule& ligand, const DockingParams& params, std::size_t* interactions = nullptr);
+
+// Precálculos de un lote de ligandos que no se dieron al construir el evaluador: el
+// modelo de grano grueso del embudo y el hash de la caché de scores de cada ligando se
+// calculan una vez por lote y no una vez por par.
+struct LigandBatch {
+    const std::vector<Molecule>* ligands = nullptr;
+    CoarseModels coarse;
+    std::vector<uint64_t> hashes;
+};
+
+// Evaluador de docking reutilizable: prepara una vez por proteína las estructuras
+// auxiliares (la lista de celdas cuando hay radio de corte, las rejillas de afinidad
+// en modo grid, el modelo de grano grueso con embudo, el octree en modo aproximado) y
+// las comparte entre todos los ligandos evaluados contra esa proteína. Si se conocen los
+// ligandos, las rejillas cubren sólo su caja envolvente y, con embudo, sus modelos de
+// grano grueso se precalculan (los ligandos de fuera de ese vector se modelan al vuelo)
+// y el corte de la fracción conservada sale de una muestra de ellos; en modo octree, el
+// error de la aproximación se mide sobre una muestra de pares. Con caché de scores, cada
+// par se busca antes de calcularlo y los scores nuevos se guardan al destruir el evaluador.
+class DockingScorer {
+public:
+    DockingScorer(const std::vector<Molecule>& proteins, const DockingParams& params);
+    DockingScorer(const std::vector<Molecule>& proteins, const DockingParams& params,
+                  const std::vector<Molecule>& ligands);
+
+    // Score de un par, o FUNNEL_REJECTED (NaN) si el embudo lo descarta.
+    float score(std::size_t proteinIndex, const Molecule& ligand) const;
+
+    // Prepara 'batch' para puntuar 'ligands' (que deben seguir vivos mientras se use) y
+    // puntúa su ligando k-ésimo con los precálculos del lote.
+    void prepareBatch(const std::vector<Molecule>& ligands, LigandBatch& batch) const;
+    float score(std::size_t proteinIndex, const LigandBatch& batch, std::size_t ligandIndex) const;
+
+    // Evalúa un lote de ligandos [first, last) contra una proteína y escribe los scores en
+    // 'out' (out[k] corresponde a ligands[first + k]). Sin corte ni rejillas, la proteína
+    // se recorre en bloques de 'proteinBlock' átomos y cada bloque se evalúa contra todo
+    // el lote antes de pasar al siguiente, de modo que permanece en caché. Los scores
+    // pueden diferir de score() en el redondeo por el distinto orden de las sumas.
+    void scoreBatch(std::size_t proteinIndex, const std::vector<Molecule>& ligands, std::size_t first,
+                    std::size_t last, std::size_t proteinBlock, float* out) const;
+
+    const DockingParams& getParams() const { return params; }
+
+    // Escribe en disco los scores nuevos de la caché (se hace también al destruir el
+    // evaluador; hace falta antes de un exit()).
+    void flushScoreCache() const { scoreCache.close(); }
+
+    // Número de rejillas leídas de la caché en disco, puntos y memoria total que ocupan y
+    // mayor separación usada (la por defecto crece con las cajas grandes).
+    std::size_t getGridMapsFromCache() const { return gridMapsFromCache; }
+    std::size_t getGridPointCount() const;
+    std::size_t getGridBytes() const;
+    float getGridMaxSpacing() const;
+
+    // Octrees (nodos y memoria) y error medido de la aproximación, de las rejillas o del
+    // octree (samples = 0 si no hay).
+    std::size_t getOctreeNodeCount() const;
+    std::size_t getOctreeBytes() const;
+    const ApproximationError& getApproximationError() const { return approximationError; }
+
+private:
+    void prepare(const std::vector<Molecule>* ligands);
+    void prepareGridMaps(const std::vector<Molecule>* ligands);
+    void prepareFunnel(const std::vector<Molecule>* ligands);
+    void prepareOctrees(const std::vector<Molecule>* ligands);
+    void prepareScoreCache(const std::vector<Molecule>* ligands);
+    std::size_t knownLigandIndex(const Molecule& ligand) const;
+    bool passesFunnel(std::size_t proteinIndex, const CoarseModels& ligands, std::size_t ligandIndex) const;
+    float cachedScore(std::size_t proteinIndex, const Molecule& ligand, uint64_t ligandHash) const;
+    float computeScore(std::size_t proteinIndex, const Molecule& ligand) const;
+
+    const std::vector<Molecule>& proteins;
+    DockingParams params;
+    std::vector<CellList> cellLists;
+    std::vector<GridMapSet> gridMaps;
+    CoarseModels coarseProteins;
+    CoarseModels coarseLigands;
+    const std::vector<Molecule>* knownLigands;     // Ligandos dados al construir (o nulo)
+    std::vector<float> funnelCutoff;    // Estimación gruesa máxima que pasa, por proteína
+    std::vector<ProteinOctree> octrees;
+    ApproximationError approximationError;
+    mutable ScoreCache scoreCache;
+    std::vector<uint64_t> proteinCacheKeys;      // Proteína y parámetros, por proteína
+    std::vector<uint64_t> ligandHashes;          // Hash de contenido de knownLigands
+    std::size_t gridMapsFromCache;
+};
 
 // Estructura para almacenar el resultado del docking: 
 // índice de proteína, índice de ligando y score de docking.
@@ -15,4 +151,4 @@ struct DockingResult {
     float score;
 };
 
-#endif // DOCKING_H
\ No newline at end of file
+#endif // DOCKING_H
@@ -0,0 +1,28 @@
+#ifndef DOCKINGKERNELS_H
+#define DOCKINGKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "ForceField.h"
+
+// Distancia mínima (al cuadrado) por debajo de la cual se ignora una pareja de átomos.
+const float LJ_MIN_R2 = 1e-6f;
+
+// Firma común de los kernels de Lennard-Jones sobre arreglos SoA: suma la energía de
+// todas las parejas (átomo de ligando, átomo de proteína). 'le' y 'pe' son los códigos
+// de elemento; los kernels con parámetros uniformes no los leen (pueden ser nulos).
+typedef float (*LJKernelFn)(const float* lx, const float* ly, const float* lz, const uint8_t* le,
+                            std::size_t numLigandAtoms, const float* px, const float* py, const float* pz,
+                            const uint8_t* pe, std::size_t numProteinAtoms);
+
+// Hay implementaciones escalar, SSE, AVX2 y AVX-512, cada una especializada en
+// compilación para cada conjunto de parámetros LJ (UniformLJ, UffLJ; ver ForceField.h).
+// Devuelve la mejor soportada por la CPU actual para 'forceField' (detección por CPUID,
+// una sola vez). La variable de entorno BIOSCREENING_SIMD=scalar|sse|avx2|avx512
+// permite forzar uno concreto.
+LJKernelFn getLJKernel(ForceField forceField = FORCEFIELD_UNIFORM);
+
+// Nombre del kernel seleccionado por getLJKernel ("scalar", "sse", "avx2" o "avx512").
+const char* getLJKernelName();
+
+#endif // DOCKINGKERNELS_H
@@ -0,0 +1,114 @@
+#ifndef FORCEFIELD_H
+#define FORCEFIELD_H
+
+// Parámetros de Lennard-Jones por pareja de elementos. Cada átomo lleva su código de
+// elemento compacto (uint8_t, ver Molecule.h), que indexa directamente una tabla
+// NUM_ELEMENT_TYPES x NUM_ELEMENT_TYPES de coeficientes ya combinados:
+//   E(r) = c12 / r^12 - c6 / r^6
+// Las tablas se calculan en compilación (constexpr) con la regla de combinación, así
+// que el bucle interno sólo hace dos cargas indexadas por pareja, sin cadenas ni mapas.
+
+#include <cstddef>
+#include <cstdint>
+#include "Molecule.h"
+
+// Conjuntos de parámetros disponibles.
+enum ForceField : uint8_t {
+    FORCEFIELD_UNIFORM = 0,   // sigma = 1, epsilon = 1 para todos los elementos (por defecto)
+    FORCEFIELD_UFF,           // Universal Force Field (Rappé et al., 1992), por elemento
+    NUM_FORCEFIELDS
+};
+
+// Nombre del conjunto ("uniform", "uff") y conversión inversa (false si no existe).
+const char* forceFieldName(ForceField forceField);
+bool parseForceField(const char* name, ForceField& forceField);
+
+// Parámetros de un elemento con la forma de UFF: distancia del mínimo x (Å) y
+// profundidad del pozo D (kcal/mol), E(r) = D * ((x / r)^12 - 2 (x / r)^6).
+struct LJElementParams {
+    double x;
+    double depth;
+};
+
+// Coeficientes combinados por pareja de elementos. Las filas tienen exactamente 16
+// floats (64 bytes), lo que permite a los kernels vectoriales consultarlas con
+// permutaciones de registro en lugar de accesos dispersos a memoria.
+struct alignas(64) LJPairTable {
+    float c12[NUM_ELEMENT_TYPES][NUM_ELEMENT_TYPES];
+    float c6[NUM_ELEMENT_TYPES][NUM_ELEMENT_TYPES];
+};
+
+static_assert(NUM_ELEMENT_TYPES == 16, "Las filas de LJPairTable deben ocupar un registro AVX-512");
+
+// Raíz cuadrada evaluable en compilación (Newton-Raphson).
+constexpr double constexprSqrt(double v) {
+    if (v <= 0.0)
+        return 0.0;
+    double r = v > 1.0 ? v : 1.0;
+    for (int k = 0; k < 64; ++k)
+        r = 0.5 * (r + v / r);
+    return r;
+}
+
+// Tabla combinada con medias geométricas (la regla de UFF):
+//   x_ij = sqrt(x_i x_j), D_ij = sqrt(D_i D_j), c12 = D_ij x_ij^12, c6 = 2 D_ij x_ij^6.
+constexpr LJPairTable mixGeometric(const LJElementParams (&params)[NUM_ELEMENT_TYPES]) {
+    LJPairTable table{};
+    for (std::size_t a = 0; a < NUM_ELEMENT_TYPES; ++a) {
+        for (std::size_t b = 0; b < NUM_ELEMENT_TYPES; ++b) {
+            const double x = constexprSqrt(params[a].x * params[b].x);
+            const double depth = constexprSqrt(params[a].depth * params[b].depth);
+            const double x6 = x * x * x * x * x * x;
+            table.c12[a][b] = static_cast<float>(depth * x6 * x6);
+            table.c6[a][b] = static_cast<float>(2.0 * depth * x6);
+        }
+    }
+    return table;
+}
+
+// Tablas de cada conjunto (definidas con constexpr en ForceField.cpp).
+extern const LJPairTable UNIFORM_PAIR_TABLE;
+extern const LJPairTable UFF_PAIR_TABLE;
+
+const LJPairTable& pairTable(ForceField forceField);
+
+// Coeficientes separables por elemento: a_e = sqrt(c12_ee), b_e = sqrt(c6_ee). Todas las
+// tablas usan la regla geométrica, así que c12_ij = a_i a_j y c6_ij = b_i b_j, y la
+// interacción con un grupo de átomos lejanos se resume en las sumas de sus a y b.
+struct SeparableLJ {
+    float a[NUM_ELEMENT_TYPES];
+    float b[NUM_ELEMENT_TYPES];
+};
+
+const SeparableLJ& separableCoefficients(ForceField forceField);
+
+// Distancia sigma (Å) a la que se anula la energía de la pareja (a, b): (c12 / c6)^(1/6).
+float pairSigma(ForceField forceField, uint8_t a, uint8_t b);
+
+// Menor y mayor sigma entre todas las parejas de elementos del conjunto.
+float minPairSigma(ForceField forceField);
+float maxPairSigma(ForceField forceField);
+
+// Conjuntos de parámetros como tipos, para especializar los kernels en compilación.
+// Con UniformLJ los coeficientes son constantes (c12 = c6 = 4) y el término se pliega a
+// 4 * (1/r^12 - 1/r^6), sin leer los elementos; con una tabla por elemento, cada átomo
+// del ligando fija una fila de la tabla y cada átomo de la proteína indexa esa fila.
+struct UniformLJ {
+    static constexpr bool PER_ELEMENT = false;
+    static const LJPairTable& table() { return UNIFORM_PAIR_TABLE; }
+};
+
+struct UffLJ {
+    static constexpr bool PER_ELEMENT = true;
+    static const LJPairTable& table() { return UFF_PAIR_TABLE; }
+};
+
+// Energía de una pareja a partir de 1/r^6 y de las filas c12/c6 del átomo del ligando.
+template <class LJ>
+inline float ljPairEnergy(float inv6, const float* c12Row, const float* c6Row, uint8_t element) {
+    if (LJ::PER_ELEMENT)
+        return inv6 * (c12Row[element] * inv6 - c6Row[element]);
+    return 4.0f * (inv6 * inv6 - inv6);
+}
+
+#endif // FORCEFIELD_H
@@ -0,0 +1,63 @@
+#ifndef FUNNEL_H
+#define FUNNEL_H
+
+// Cribado jerárquico (embudo): antes del cálculo completo, cada par se estima con
+// representaciones de grano grueso de la proteína y del ligando, y sólo los pares cuya
+// estimación está entre las mejores (por percentil) o por debajo de un umbral pasan a
+// la puntuación átomo a átomo. Los pares descartados no tienen score (NaN).
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "ForceField.h"
+#include "Molecule.h"
+
+// Arista por defecto (Å) de las celdas que agrupan los átomos de cada pseudo-átomo.
+const float DEFAULT_FUNNEL_CLUSTER_SIZE = 6.0f;
+
+// Ligandos de muestra por proteína para fijar el corte de la fracción conservada.
+const std::size_t FUNNEL_SAMPLE_LIGANDS = 4096;
+
+// Score de los pares descartados por la etapa gruesa (HitCollector nunca los toma como hits).
+const float FUNNEL_REJECTED = std::numeric_limits<float>::quiet_NaN();
+
+// Configuración del embudo. Está activo con keepFraction > 0 o con umbral; con ambos,
+// un par debe cumplir los dos criterios.
+struct FunnelParams {
+    float keepFraction = 0.0f;      // (0, 1]: fracción de ligandos de cada proteína que pasa
+    bool useThreshold = false;
+    float threshold = 0.0f;         // Estimación gruesa máxima que pasa
+    float clusterSize = DEFAULT_FUNNEL_CLUSTER_SIZE;
+
+    bool enabled() const { return keepFraction > 0.0f || useThreshold; }
+};
+
+// Representación de grano grueso de un conjunto de moléculas: los átomos de cada una se
+// agrupan por celdas cúbicas de arista 'clusterSize' y cada celda ocupada da un
+// pseudo-átomo en el centroide de sus átomos. Con la regla de combinación geométrica los
+// coeficientes son separables, c12_ij = a_i a_j y c6_ij = b_i b_j, así que cada
+// pseudo-átomo guarda las sumas A = sum a_i y B = sum b_i de sus átomos, y la energía
+// entre dos pseudo-átomos es A_p A_l / r^12 - B_p B_l / r^6. Los pseudo-átomos de todas
+// las moléculas están en arreglos SoA contiguos (pocas reservas con millones de ligandos).
+class CoarseModels {
+public:
+    // Construye los modelos de 'molecules' (en paralelo con OpenMP) o de una sola molécula.
+    void build(const std::vector<Molecule>& molecules, float clusterSize, ForceField forceField);
+    void build(const Molecule& molecule, float clusterSize, ForceField forceField);
+
+    std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::size_t getPseudoAtomCount() const { return x.size(); }
+    std::size_t getBytes() const;
+
+    // Estimación gruesa de la energía entre proteins[protein] y ligands[ligand].
+    static float energy(const CoarseModels& proteins, std::size_t protein,
+                        const CoarseModels& ligands, std::size_t ligand);
+
+private:
+    std::vector<std::size_t> offsets;      // Pseudo-átomos de la molécula m: [offsets[m], offsets[m + 1])
+    AlignedVector<float> x, y, z;          // Centroides
+    AlignedVector<float> a, b;             // Sumas de coeficientes separables
+};
+
+#endif // FUNNEL_H
@@ -0,0 +1,107 @@
+#ifndef GRIDMAP_H
+#define GRIDMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "ForceField.h"
+#include "Molecule.h"
+
+// Separación por defecto entre puntos de la rejilla, en fracciones de la menor sigma del
+// campo de fuerzas (0.25 Å con los parámetros uniformes, ~0.6 Å con UFF).
+const float GRID_SPACING_PER_SIGMA = 0.25f;
+
+// Máximo de puntos por mapa con la separación por defecto. Si la caja los supera, la
+// separación crece hasta ajustarse y la zona de cálculo exacto (ver GRID_EXACT_SIGMAS)
+// se ensancha con ella.
+const std::size_t GRID_MAX_DEFAULT_POINTS = std::size_t(1) << 22;
+
+// Margen de la caja por defecto alrededor de la proteína, en sigmas (sin --cutoff; con
+// corte el margen es el propio corte, más allá del cual la energía es nula).
+const float GRID_BOX_MARGIN_SIGMAS = 4.0f;
+
+// Cerca de un átomo de la proteína el potencial varía demasiado deprisa para la
+// interpolación trilineal. Los puntos a menos de GRID_EXACT_SIGMAS * sigma + 2 * separación
+// de algún átomo se marcan con GRID_EXACT_MARK, y los átomos del ligando que caen en una
+// celda con algún vértice marcado se evalúan de forma exacta.
+const float GRID_EXACT_SIGMAS = 2.0f;
+const float GRID_EXACT_MARK = 1.0e30f;
+
+// Pares equiespaciados con los que se mide el error de las rejillas frente al cálculo exacto.
+const std::size_t GRID_ERROR_SAMPLES = 32;
+
+// Energía máxima almacenada en un punto de la rejilla. Cerca de un átomo de la proteína
+// el término 1/r^12 diverge; se recorta (como AutoDock) para que la interpolación
+// trilineal no quede dominada por un único vértice.
+const float GRID_ENERGY_CAP = 1.0e5f;
+
+// Configuración de las rejillas de afinidad precalculadas.
+struct GridMapParams {
+    bool enabled = false;
+    float spacing = 0.0f;           // <= 0: la de defaultGridSpacing()
+    bool hasBox = false;            // false: caja de cada proteína más un margen
+    float boxMin[3] = {0.0f, 0.0f, 0.0f};
+    float boxMax[3] = {0.0f, 0.0f, 0.0f};
+    std::string cacheDir;           // vacío: sin caché en disco
+};
+
+// Separación por defecto para 'forceField' (GRID_SPACING_PER_SIGMA de su menor sigma).
+float defaultGridSpacing(ForceField forceField);
+
+// Conjunto de rejillas de potencial de una proteína, una por clase de átomo de ligando
+// (como los mapas de AutoDock). El valor en cada punto es la energía de un átomo de
+// prueba de esa clase frente a toda la proteína; puntuar un ligando se reduce a una
+// interpolación trilineal por átomo.
+class GridMapSet {
+public:
+    GridMapSet();
+
+    // Define la geometría común a todos los mapas.
+    void setGeometry(const float boxMin[3], const float boxMax[3], float spacing);
+
+    // Reserva un mapa por clase y registra qué clase usa cada elemento
+    // ('elementClass[e]' < 0 si el elemento no tiene mapa).
+    void allocate(const std::vector<int>& elementClass, int numClasses);
+
+    bool empty() const;
+    int getNumClasses() const;
+    std::size_t getPointCount() const;
+    std::size_t getBytes() const;
+
+    // Coordenadas del punto (ix, iy, iz) y acceso a los valores de un mapa.
+    float pointX(int ix) const { return originX + ix * spacing; }
+    float pointY(int iy) const { return originY + iy * spacing; }
+    float pointZ(int iz) const { return originZ + iz * spacing; }
+    int getDimX() const { return dimX; }
+    int getDimY() const { return dimY; }
+    int getDimZ() const { return dimZ; }
+    float getSpacing() const { return spacing; }
+    float* mapData(int mapClass);
+    const float* mapData(int mapClass) const;
+    int classForElement(uint8_t element) const;
+
+    // Marca con GRID_EXACT_MARK los puntos del mapa 'mapClass' del plano 'iz' a menos de
+    // 'radius' de (x, y, z).
+    void markExact(int mapClass, int iz, float x, float y, float z, float radius);
+
+    // Interpolación trilineal en el mapa de 'element'. Devuelve false si el punto
+    // queda fuera de la rejilla, en una celda marcada o el elemento no tiene mapa.
+    bool interpolate(uint8_t element, float x, float y, float z, float& energy) const;
+
+    // Persistencia (caché en disco). 'key' identifica proteína y parámetros.
+    bool save(const std::string& filename, uint64_t key) const;
+    bool load(const std::string& filename, uint64_t key);
+
+private:
+    float originX, originY, originZ;
+    float spacing;
+    float invSpacing;
+    int dimX, dimY, dimZ;
+    int numClasses;
+    int elementClass[NUM_ELEMENT_TYPES];
+    AlignedVector<float> values;   // numClasses mapas consecutivos de dimX*dimY*dimZ
+};
+
+#endif // GRIDMAP_H
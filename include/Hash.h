@@ -0,0 +1,27 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Hash FNV-1a de 64 bits. Se usa para identificar contenidos (moléculas, parámetros)
+// en las cachés en disco; no tiene pretensiones criptográficas.
+const uint64_t FNV_OFFSET_BASIS = 1469598103934665603ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline uint64_t hashBytes(const void* data, std::size_t size, uint64_t seed = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+template <typename T>
+inline uint64_t hashValue(const T& value, uint64_t seed = FNV_OFFSET_BASIS) {
+    return hashBytes(&value, sizeof(T), seed);
+}
+
+#endif // HASH_H
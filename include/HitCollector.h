@@ -0,0 +1,95 @@
+#ifndef HITCOLLECTOR_H
+#define HITCOLLECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "Docking.h"
+
+// Criterio para quedarse con los mejores resultados en lugar de la matriz completa de
+// scores: los 'topK' mejores y/o los que no superan 'threshold' (menor = mejor).
+struct HitCriteria {
+    std::size_t topK = 0;
+    bool useThreshold = false;
+    float threshold = 0.0f;
+
+    bool enabled() const { return topK > 0 || useThreshold; }
+};
+
+// Orden total de los resultados: score ascendente y, a igualdad, por índices. Al no
+// depender del orden de llegada, mezclar colectores en cualquier orden da lo mismo.
+inline bool isBetterResult(const DockingResult& a, const DockingResult& b) {
+    if (a.score != b.score)
+        return a.score < b.score;
+    if (a.proteinIndex != b.proteinIndex)
+        return a.proteinIndex < b.proteinIndex;
+    return a.ligandIndex < b.ligandIndex;
+}
+
+// Recolector de hits en flujo. Cada hilo/proceso usa el suyo y al final se mezclan.
+// Con topK > 0 mantiene un montículo acotado cuya cima es el peor hit retenido, de
+// modo que la memoria es O(K) y cada inserción O(log K). Con sólo umbral guarda todos
+// los pares que lo cumplen.
+class HitCollector {
+public:
+    explicit HitCollector(const HitCriteria& criteria) : criteria(criteria), scored(0) {}
+
+    // Registra el score de un par (proteína, ligando).
+    void add(int proteinIndex, int ligandIndex, float score) {
+        scored++;
+        // Los NaN nunca son hits.
+        if (!(score == score))
+            return;
+        if (criteria.useThreshold && score > criteria.threshold)
+            return;
+        insert(DockingResult{ proteinIndex, ligandIndex, score });
+    }
+
+    // Incorpora los hits de otro colector con el mismo criterio.
+    void merge(const HitCollector& other) {
+        for (const DockingResult& hit : other.hits)
+            insert(hit);
+        scored += other.scored;
+    }
+
+    // Añade hits ya filtrados (por ejemplo, recibidos de otro proceso).
+    void merge(const DockingResult* begin, const DockingResult* end, std::size_t otherScored) {
+        for (const DockingResult* hit = begin; hit != end; ++hit)
+            insert(*hit);
+        scored += otherScored;
+    }
+
+    // Hits retenidos, sin orden concreto.
+    const std::vector<DockingResult>& getHits() const { return hits; }
+
+    // Hits ordenados de mejor a peor.
+    std::vector<DockingResult> sortedHits() const {
+        std::vector<DockingResult> sorted(hits);
+        std::sort(sorted.begin(), sorted.end(), isBetterResult);
+        return sorted;
+    }
+
+    // Número de pares evaluados (incluidos los descartados).
+    std::size_t getScored() const { return scored; }
+    const HitCriteria& getCriteria() const { return criteria; }
+
+private:
+    void insert(const DockingResult& hit) {
+        if (criteria.topK == 0) {
+            hits.push_back(hit);
+        } else if (hits.size() < criteria.topK) {
+            hits.push_back(hit);
+            std::push_heap(hits.begin(), hits.end(), isBetterResult);
+        } else if (isBetterResult(hit, hits.front())) {
+            std::pop_heap(hits.begin(), hits.end(), isBetterResult);
+            hits.back() = hit;
+            std::push_heap(hits.begin(), hits.end(), isBetterResult);
+        }
+    }
+
+    HitCriteria criteria;
+    std::size_t scored;
+    std::vector<DockingResult> hits;
+};
+
+#endif // HITCOLLECTOR_H
@@ -0,0 +1,94 @@
+#ifndef INCREMENTALRESULTS_H
+#define INCREMENTALRESULTS_H
+
+// Resultados de una ejecución guardados para volver a cribar sólo lo que cambia
+// (--incremental). El fichero "results.bsrs" del directorio contiene el manifiesto de
+// los ficheros de entrada, el hash de contenido de cada molécula y la matriz completa de
+// scores:
+//
+//   ResultsHeader
+//   ManifestRecord[numProteinFiles + numLigandFiles]
+//   char paths[pathBytes]
+//   uint64_t proteinHashes[numProteins], ligandHashes[numLigands]
+//   float scores[numProteins * numLigands]
+//
+// En la ejecución siguiente, un par se reutiliza si su proteína y su ligando (por hash
+// de contenido, no por posición ni nombre) ya estaban en la matriz guardada; el resto
+// (filas de proteínas nuevas o modificadas, columnas de ligandos nuevos o modificados)
+// se calcula. El manifiesto describe qué ficheros se añadieron, cambiaron o
+// desaparecieron; el hash de un fichero sólo se recalcula si su tamaño o su fecha de
+// modificación no coinciden con los guardados.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Docking.h"
+#include "MappedFile.h"
+#include "Molecule.h"
+#include "Partition.h"
+
+// Un fichero de entrada: ruta, tamaño, fecha de modificación (ns) y hash del contenido.
+struct ManifestEntry {
+    std::string path;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+};
+
+// Diferencias entre dos manifiestos, en número de ficheros.
+struct ManifestChanges {
+    std::size_t added = 0;
+    std::size_t changed = 0;
+    std::size_t removed = 0;
+};
+
+// Identifica los parámetros con los que se calcularon los scores. Con un embudo por
+// fracción o con rejillas ajustadas a la caja de los ligandos, el score de un par depende
+// del conjunto de ligandos, así que éste también entra en la clave.
+uint64_t incrementalKey(const std::vector<Molecule>& ligands, const DockingParams& params);
+
+// Manifiesto actual de 'path' (los ficheros con 'extensions', o el propio fichero). Los
+// hashes de 'previous' se reutilizan para los ficheros con la misma ruta, tamaño y fecha.
+bool buildManifest(const std::string& path, const std::vector<std::string>& extensions,
+                   const std::vector<ManifestEntry>& previous, std::vector<ManifestEntry>& manifest);
+
+ManifestChanges compareManifests(const std::vector<ManifestEntry>& previous,
+                                 const std::vector<ManifestEntry>& current);
+
+class IncrementalResults {
+public:
+    IncrementalResults();
+
+    // Abre los resultados guardados en 'dir'. Devuelve false si no hay o no son válidos.
+    bool open(const std::string& dir);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    uint64_t getKey() const { return key; }
+    const std::vector<ManifestEntry>& getProteinManifest() const { return proteinManifest; }
+    const std::vector<ManifestEntry>& getLigandManifest() const { return ligandManifest; }
+
+    // Pares de la matriz actual (idx = i * ligands.size() + j) que ya están guardados:
+    // rangos ordenados y disjuntos y sus scores concatenados. Devuelve el número de pares.
+    std::size_t reusablePairs(const std::vector<Molecule>& proteins, const std::vector<Molecule>& ligands,
+                              std::vector<PairRange>& ranges, std::vector<float>& scores) const;
+
+    // Escribe los resultados de una ejecución completa en 'dir' (temporal + rename).
+    static bool save(const std::string& dir, uint64_t key, const std::vector<ManifestEntry>& proteinManifest,
+                     const std::vector<ManifestEntry>& ligandManifest, const std::vector<Molecule>& proteins,
+                     const std::vector<Molecule>& ligands, const std::vector<float>& scores);
+
+private:
+    MappedFile file;
+    uint64_t key;
+    std::vector<ManifestEntry> proteinManifest;
+    std::vector<ManifestEntry> ligandManifest;
+    const uint64_t* proteinHashes;
+    const uint64_t* ligandHashes;
+    const float* scores;
+    std::size_t numProteins;
+    std::size_t numLigands;
+};
+
+#endif // INCREMENTALRESULTS_H
@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Fichero proyectado en memoria (mmap) de sólo lectura. Permite recorrer el contenido
+// en el sitio, sin copiarlo a buffers intermedios.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Proyecta 'filename'. Un fichero vacío se abre correctamente con size() == 0.
+    // 'sequential' indica al kernel que se leerá una sola vez de principio a fin.
+    bool open(const std::string& filename, bool sequential = true);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return static_cast<const char*>(addr); }
+    std::size_t size() const { return length; }
+
+private:
+    void* addr;
+    std::size_t length;
+    bool opened;
+};
+
+#endif // MAPPEDFILE_H
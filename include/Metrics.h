@@ -0,0 +1,104 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Instrumentación de una ejecución: tiempos de cada fase (ScopedPhase, basado en Timer)
+// y contadores de trabajo. Cada hilo acumula en su propio registro, sin bloqueos ni
+// atómicos, y los registros se reúnen al final (collectThreadMetrics); los backends MPI
+// los reúnen además por proceso (ver MpiCommon.h). La instrumentación está siempre
+// activa; --metrics FICHERO escribe el informe JSON.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Utils.h"
+
+enum MetricPhase {
+    PHASE_SCAN = 0,      // Enumeración de los directorios de entrada
+    PHASE_PARSE,         // Parseo (o proyección de librerías) de los ficheros
+    PHASE_FLATTEN,       // Estructuras derivadas: listas de celdas, rejillas, ventanas compartidas
+    PHASE_COMPUTE,       // Cálculo de los scores
+    PHASE_GATHER,        // Reunión de resultados entre hilos o procesos
+    PHASE_RANK,          // Ranking e informe de resultados
+    NUM_METRIC_PHASES
+};
+
+enum MetricCounter {
+    COUNTER_PAIRS = 0,       // Pares proteína-ligando evaluados con el modelo completo
+    COUNTER_INTERACTIONS,    // Parejas de átomos calculadas (vecinas con corte, consultas a la rejilla, nodos del octree)
+    COUNTER_BYTES_READ,      // Bytes de los ficheros de entrada parseados
+    COUNTER_COARSE_PAIRS,    // Pares estimados con el modelo de grano grueso (embudo)
+    COUNTER_CACHE_LOOKUPS,   // Pares buscados en la caché de scores
+    COUNTER_CACHE_HITS,      // Pares cuyo score estaba en la caché (no se calculan)
+    COUNTER_EQUIVALENT_INTERACTIONS,  // Parejas del cálculo completo (átomos de proteína x de ligando)
+    NUM_METRIC_COUNTERS
+};
+
+// Operaciones en coma flotante de una interacción de Lennard-Jones sin corte (diferencias,
+// distancia, potencias y división), para estimar GFLOP/s. Con corte, rejillas u octree se
+// evalúan menos parejas, así que la cifra se calcula con las interacciones equivalentes.
+const double LJ_FLOPS_PER_INTERACTION = 16.0;
+
+const char* metricPhaseName(MetricPhase phase);
+const char* metricCounterName(MetricCounter counter);
+
+// Métricas de un hilo, o agregadas de varios. 'seconds' suma el tiempo de todos los
+// hilos en la fase y 'wallSeconds' es el del más lento (el que cuenta para el total).
+struct MetricsSnapshot {
+    double seconds[NUM_METRIC_PHASES];
+    double wallSeconds[NUM_METRIC_PHASES];
+    uint64_t calls[NUM_METRIC_PHASES];
+    uint64_t counters[NUM_METRIC_COUNTERS];
+
+    MetricsSnapshot();
+    void add(const MetricsSnapshot& other);
+
+    // Ritmos derivados sobre el tiempo de cálculo.
+    double pairsPerSecond() const;
+    double interactionsPerSecond() const;
+    double equivalentInteractionsPerSecond() const;
+    double gflops() const;
+};
+
+// Acumulan en el registro del hilo actual.
+void addMetricCounter(MetricCounter counter, uint64_t value);
+void addMetricPhase(MetricPhase phase, double seconds);
+
+// Mide el tiempo de una fase desde su construcción hasta su destrucción (y, con la traza
+// activa, la registra como evento).
+class ScopedPhase {
+public:
+    explicit ScopedPhase(MetricPhase phase);
+    ~ScopedPhase();
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    MetricPhase phase;
+    Timer timer;
+    uint64_t traceStart;
+};
+
+// Segundos desde el inicio del proceso.
+double metricsElapsedSeconds();
+
+// Métricas de cada hilo que ha registrado algo, en orden de registro. Sólo debe
+// llamarse cuando los hilos instrumentados han terminado (fuera de regiones paralelas).
+std::vector<MetricsSnapshot> collectThreadMetrics();
+
+// Imprime un resumen por fases y los ritmos de 'total'.
+void printMetricsSummary(const MetricsSnapshot& total, double wallSeconds);
+
+// Imprime cuántos pares supera cada etapa del embudo según los contadores de 'total'.
+void printFunnelSummary(const MetricsSnapshot& total);
+
+// Imprime la tasa de aciertos de la caché de scores.
+void printScoreCacheSummary(const MetricsSnapshot& total);
+
+// Escribe el informe JSON: por proceso y por hilo (ranks[r][t]) y los totales.
+// 'wallSeconds' es el tiempo total de la ejecución.
+bool writeMetricsJson(const std::string& filename, const std::string& backend,
+                      const std::vector<std::vector<MetricsSnapshot>>& ranks, double wallSeconds);
+
+#endif // METRICS_H
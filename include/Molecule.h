@@ -1,24 +1,168 @@
 #ifndef MOLECULE_H
 #define MOLECULE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
+#include "AlignedAllocator.h"
 
+// Códigos compactos (uint8_t) para los elementos químicos más habituales.
+// ELEMENT_UNKNOWN se usa para símbolos vacíos o no reconocidos.
+enum ElementType : uint8_t {
+    ELEMENT_UNKNOWN = 0,
+    ELEMENT_H,
+    ELEMENT_C,
+    ELEMENT_N,
+    ELEMENT_O,
+    ELEMENT_S,
+    ELEMENT_P,
+    ELEMENT_F,
+    ELEMENT_CL,
+    ELEMENT_BR,
+    ELEMENT_I,
+    ELEMENT_FE,
+    ELEMENT_ZN,
+    ELEMENT_MG,
+    ELEMENT_CA,
+    ELEMENT_NA,
+    NUM_ELEMENT_TYPES
+};
+
+// Convierte un símbolo químico (sin distinguir mayúsculas) a su código compacto.
+uint8_t elementCode(const std::string& symbol);
+uint8_t elementCode(const char* symbol, std::size_t length);
+
+// Devuelve el símbolo químico asociado a un código ("X" si es desconocido).
+const char* elementSymbol(uint8_t code);
+
+// Representación de un átomo aislado (se usa en la interfaz, no en el almacenamiento).
+// El símbolo no se copia: getAtom() lo apunta a la tabla interna de elementSymbol().
 struct Atom {
     float x, y, z;
-    std::string element;
+    const char* element;
 };
 
+// Molécula almacenada como estructura de arreglos (SoA): las coordenadas x, y, z
+// viven en arreglos contiguos y alineados, y el elemento en un arreglo de códigos
+// uint8_t. Así el bucle de docking sólo recorre los floats que necesita.
+// Una molécula puede ser también una vista sobre arreglos SoA externos (por ejemplo,
+// una librería binaria proyectada en memoria); 'owner' mantiene viva esa memoria.
 class Molecule {
 public:
     Molecule();
     ~Molecule();
 
+    // Las moléculas sólo se mueven; una copia tiene que pedirse con clone().
+    Molecule(const Molecule&) = delete;
+    Molecule& operator=(const Molecule&) = delete;
+    Molecule(Molecule&&) noexcept = default;
+    Molecule& operator=(Molecule&&) noexcept = default;
+
+    // Copia explícita. La de una vista es otra vista sobre los mismos arreglos.
+    Molecule clone() const;
+
+    // Crea una vista (sin copia) sobre 'count' átomos en arreglos externos.
+    static Molecule view(const float* x, const float* y, const float* z, const uint8_t* elements,
+                         std::size_t count, std::shared_ptr<const void> owner);
+    bool isView() const { return external; }
+
+    // Reserva espacio para al menos 'count' átomos. Si la molécula ya tiene átomos, la
+    // capacidad crece al menos al doble, así que reservar antes de cada bloque que se
+    // añade al final (un registro SDF tras otro) no copia los arreglos en cada llamada.
+    void reserve(std::size_t count);
+
     void addAtom(const Atom& atom);
-    const std::vector<Atom>& getAtoms() const;
+    void addAtom(float x, float y, float z, uint8_t element);
+
+    // Añade al final todos los átomos de 'other'.
+    void append(const Molecule& other);
+
+    // Ajusta la capacidad de los arreglos propios a los átomos que contienen.
+    void shrinkToFit();
+
+    std::size_t getAtomCount() const;
+    bool empty() const;
+
+    // Acceso directo a los arreglos de coordenadas y códigos de elemento.
+    const float* getX() const;
+    const float* getY() const;
+    const float* getZ() const;
+    const uint8_t* getElements() const;
+
+    // Reconstruye el átomo i-ésimo (uso fuera de los bucles críticos).
+    Atom getAtom(std::size_t index) const;
+
+    // Hash del contenido (coordenadas y elementos), para cachés en disco.
+    uint64_t contentHash() const;
+
+private:
+    // Copia los datos de una vista a almacenamiento propio (antes de modificarla).
+    void materialize();
+
+    AlignedVector<float> xs;
+    AlignedVector<float> ys;
+    AlignedVector<float> zs;
+    AlignedVector<uint8_t> elements;
+
+    // Datos de la vista externa (sólo válidos si external == true).
+    bool external = false;
+    const float* viewX = nullptr;
+    const float* viewY = nullptr;
+    const float* viewZ = nullptr;
+    const uint8_t* viewElements = nullptr;
+    std::size_t viewCount = 0;
+    std::shared_ptr<const void> viewOwner;
+};
+
+// Moléculas construidas sobre un único bloque SoA (arena). Los parsers añaden los átomos
+// de la molécula en curso al final del bloque (getBuffer()) y commit() la cierra; al
+// terminar, release() entrega las moléculas como vistas sobre el bloque, que pasa a ser
+// compartido por todas ellas. La carga no hace asignaciones por molécula y el conjunto
+// ocupa cuatro arreglos contiguos en lugar de cuatro por molécula repartidos por el heap.
+class MoleculeArena {
+public:
+    MoleculeArena();
+
+    // Reserva espacio para 'molecules' moléculas y 'atoms' átomos en total.
+    void reserve(std::size_t molecules, std::size_t atoms);
+
+    // Bloque al que se añaden los átomos de la molécula en curso.
+    Molecule& getBuffer() { return buffer; }
+
+    // Cierra la molécula en curso. Devuelve false (y no la añade) si no tiene átomos.
+    bool commit();
+
+    // Ajusta el bloque a los átomos de las moléculas cerradas (la capacidad crece al doble
+    // durante el parseo).
+    void shrinkToFit();
+
+    std::size_t size() const { return bounds.size() - 1; }
+    bool empty() const { return size() == 0; }
+    std::size_t getAtomCount() const { return bounds.back(); }
+
+    // Añade a 'molecules' una vista por molécula sobre el bloque y deja la arena vacía.
+    void release(std::vector<Molecule>& molecules);
 
 private:
-    std::vector<Atom> atoms;
+    Molecule buffer;
+    std::vector<std::size_t> bounds;   // La molécula k ocupa [bounds[k], bounds[k + 1])
 };
 
-#endif // MOLECULE_H
\ No newline at end of file
+// Conjunto de moléculas aplanado en un único bloque SoA, tal y como lo consumen
+// los backends que necesitan transferir los datos de una vez (por ejemplo, CUDA).
+// Los átomos de la molécula i ocupan [offsets[i], offsets[i] + counts[i]).
+struct FlatMolecules {
+    std::vector<int> counts;
+    std::vector<int> offsets;
+    AlignedVector<float> x;
+    AlignedVector<float> y;
+    AlignedVector<float> z;
+    AlignedVector<uint8_t> elements;
+};
+
+// Construye la disposición aplanada a partir de un vector de moléculas.
+FlatMolecules flattenMolecules(const std::vector<Molecule>& molecules);
+
+#endif // MOLECULE_H
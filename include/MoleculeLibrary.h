@@ -0,0 +1,68 @@
+#ifndef MOLECULELIBRARY_H
+#define MOLECULELIBRARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Molecule.h"
+
+// Extensión de los ficheros de librería binaria.
+const std::string LIBRARY_EXTENSION = ".bslib";
+
+// Alineación (en bytes) de cada sección de la librería.
+const uint64_t LIBRARY_ALIGNMENT = 64;
+
+// Formato binario de librería de moléculas (.bslib), pensado para proyectarse con mmap
+// y servir las moléculas sin copiarlas ni parsearlas:
+//
+//   LibraryHeader
+//   uint64_t atomOffsets[numMolecules + 1]   primer átomo de cada molécula
+//   uint32_t atomCounts[numMolecules]
+//   float    x[numAtoms], y[numAtoms], z[numAtoms]
+//   uint8_t  elements[numAtoms]
+//   uint64_t nameOffsets[numMolecules + 1]   (opcional) nombre de origen de cada molécula
+//   char     names[...]
+//
+// Cada sección empieza en un desplazamiento múltiplo de LIBRARY_ALIGNMENT bytes, de modo que los
+// arreglos de coordenadas quedan alineados igual que en Molecule.
+struct LibraryHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t numMolecules;
+    uint64_t numAtoms;
+    uint64_t atomOffsetsOffset;
+    uint64_t atomCountsOffset;
+    uint64_t xOffset;
+    uint64_t yOffset;
+    uint64_t zOffset;
+    uint64_t elementsOffset;
+    uint64_t nameOffsetsOffset;   // 0 si la librería no guarda nombres
+    uint64_t namesOffset;
+    uint64_t fileSize;
+};
+
+// Tamaño en bytes de la librería que contendría 'molecules' (y 'names', si no está vacío).
+std::size_t getLibrarySize(const std::vector<Molecule>& molecules, const std::vector<std::string>& names);
+
+// Serializa la librería en 'buffer', que debe tener getLibrarySize(...) bytes.
+void writeLibrary(const std::vector<Molecule>& molecules, const std::vector<std::string>& names,
+                  char* buffer);
+
+// Escribe la librería en 'filename' sección a sección (sin un buffer intermedio completo).
+bool saveLibrary(const std::string& filename, const std::vector<Molecule>& molecules,
+                 const std::vector<std::string>& names);
+
+// Interpreta una librería ya en memoria y añade a 'molecules' vistas sobre sus datos.
+// 'owner' mantiene viva la memoria mientras existan las vistas. Si 'names' no es nulo
+// se rellena con los nombres guardados (o queda vacío si la librería no los tiene).
+bool readLibrary(const char* data, std::size_t size, std::shared_ptr<const void> owner,
+                 std::vector<Molecule>& molecules, std::vector<std::string>* names, std::string& error);
+
+// Proyecta 'filename' con mmap y añade a 'molecules' vistas sin copia sobre el fichero.
+bool openLibrary(const std::string& filename, std::vector<Molecule>& molecules,
+                 std::vector<std::string>* names, std::string& error);
+
+#endif // MOLECULELIBRARY_H
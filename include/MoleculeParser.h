@@ -0,0 +1,34 @@
+#ifndef MOLECULEPARSER_H
+#define MOLECULEPARSER_H
+
+#include <cstddef>
+#include <string>
+#include "Molecule.h"
+
+// Parsers de formatos de texto que trabajan directamente sobre un buffer en memoria
+// (normalmente un MappedFile): recorren las columnas fijas en el sitio, convierten los
+// números sin crear cadenas temporales y escriben en los arreglos SoA de la molécula.
+
+// Resultado del parseo: átomos leídos y líneas descartadas (con el primer error).
+struct ParseStatus {
+    std::size_t atoms = 0;
+    std::size_t badLines = 0;
+    std::string firstError;
+};
+
+// Convierte el campo [begin, end) (con espacios a los lados) a float. Admite el formato
+// decimal de PDB/SDF por la vía rápida y recurre a strtof para cualquier otro caso.
+bool parseFixedFloat(const char* begin, const char* end, float& value);
+
+// Convierte el campo [begin, end) (con espacios a los lados) a entero.
+bool parseFixedInt(const char* begin, const char* end, int& value);
+
+// Parsea las líneas ATOM/HETATM de un contenido PDB completo. Los parsers añaden los
+// átomos al final de 'mol', que puede ser el bloque de una MoleculeArena.
+ParseStatus parsePDBBuffer(const char* begin, const char* end, Molecule& mol);
+
+// Parsea un registro SDF (V2000) que empieza en 'begin'. Devuelve el puntero al inicio
+// del registro siguiente (tras la línea "$$$$") o 'end' si no hay más.
+const char* parseSDFRecord(const char* begin, const char* end, Molecule& mol, ParseStatus& status);
+
+#endif // MOLECULEPARSER_H
@@ -0,0 +1,96 @@
+#ifndef MPICOMMON_H
+#define MPICOMMON_H
+
+// Utilidades compartidas por los backends MPI (MPI puro e híbrido OpenMP + MPI).
+// Se compilan sólo en esas versiones (src/parallel/mpi_common, ver compile.sh).
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include <mpi.h>
+#include "Checkpoint.h"
+#include "HitCollector.h"
+#include "Partition.h"
+#include "Utils.h"
+
+// Unidades de trabajo por proceso en el reparto dinámico: suficientes para absorber
+// nodos lentos o pares pesados sin que el contador se convierta en un cuello de botella.
+const std::size_t DYNAMIC_UNITS_PER_RANK = 16;
+
+// Reúne en el proceso 0 los hits de todos los procesos y los mezcla allí. Cada proceso
+// sólo envía sus hits locales (acotados), nunca sus scores.
+HitCollector gatherHits(const HitCollector& local);
+
+// Carga en flujo repartida (--stream): cada proceso carga en flujo su fragmento de los
+// ligandos, los puntúa con screenLigandStream y reúne los hits en el proceso 0, donde se
+// informa del resumen de todos. Los índices de ligando de cada proceso se desplazan con
+// los ligandos de los procesos anteriores (MPI_Exscan), así que coinciden con los de una
+// carga completa. Colectiva.
+HitCollector streamRankLigands(const ScreeningOptions& options, const DockingScorer& scorer,
+                               std::size_t numProteins);
+
+// Reúne el tiempo de cálculo de cada proceso y la fracción del coste estimado que ha
+// procesado, y los imprime en el proceso 0 junto con el desequilibrio.
+void reportRankBalance(double seconds, double costShare);
+
+// Contador global de unidades de trabajo en una ventana RMA del proceso 0. Cada
+// llamada a next() es un MPI_Fetch_and_op atómico, sin intervención del proceso 0.
+// El constructor y el destructor son colectivos.
+class WorkCounter {
+public:
+    explicit WorkCounter(MPI_Comm comm);
+    ~WorkCounter();
+
+    WorkCounter(const WorkCounter&) = delete;
+    WorkCounter& operator=(const WorkCounter&) = delete;
+
+    // Devuelve la siguiente unidad de trabajo (puede ser >= al número de unidades).
+    long next();
+
+private:
+    MPI_Comm comm;
+    MPI_Win win;
+    long* value;
+};
+
+// Resultado local de una ejecución con reparto dinámico.
+struct DynamicStats {
+    std::size_t units = 0;       // Unidades procesadas por este proceso
+    double seconds = 0.0;        // Tiempo de cálculo de este proceso
+};
+
+// Reparto dinámico maestro/trabajador sobre las unidades 'units' del espacio de pares.
+// Cada proceso (también el 0) pide unidades al WorkCounter hasta agotarlas y llama a
+// compute(begin, end, out) para cada una.
+// Con 'streamScores', 'out' apunta a end - begin floats que se envían al proceso 0 con
+// MPI_Isend (doble buffer, el envío se solapa con la unidad siguiente); el proceso 0
+// los recibe mientras calcula y los coloca en 'scores', que ya debe tener el tamaño del
+// espacio de pares, y llama a completed(unit, scores + unit.begin) (si se da) con cada
+// unidad que queda en su sitio. Sin 'streamScores', 'out' es nullptr y el llamador
+// acumula sus resultados (por ejemplo, en un HitCollector).
+DynamicStats runDynamicSchedule(const std::vector<PairRange>& units, bool streamScores,
+                                const std::function<void(std::size_t, std::size_t, float*)>& compute,
+                                std::vector<float>& scores,
+                                const std::function<void(const PairRange&, const float*)>& completed =
+                                    std::function<void(const PairRange&, const float*)>());
+
+// Abre el checkpoint de cada proceso (colectivo): el proceso 0 restaura (o limpia) el
+// directorio antes de que los demás abran en él sus ficheros. Aborta si falla.
+void openRankCheckpoints(const ScreeningOptions& options, const std::vector<Molecule>& proteins,
+                         const std::vector<Molecule>& ligands, Checkpoint& checkpoint);
+
+// Rangos ya terminados según 'checkpoint' (ninguno si es nulo), difundidos desde el
+// proceso 0, que además restaura sus resultados en 'scores' y/o 'hits' (si no son nulos).
+std::vector<PairRange> restoreCompleted(Checkpoint* checkpoint, float* scores, HitCollector* hits);
+
+// Reúne en el proceso 0 las métricas de cada hilo de cada proceso (colectiva) y, si hay
+// options.metricsFile, escribe allí el informe e imprime su resumen. Con embudo imprime
+// además cuántos pares supera cada etapa y, con caché de scores, su tasa de aciertos.
+void reportRankMetrics(const ScreeningOptions& options, const std::string& backend);
+
+// Reúne en el proceso 0 la traza de todos los procesos (colectiva) y, si hay
+// options.traceFile, la escribe allí. Los relojes se alinean en una barrera.
+void reportRankTrace(const ScreeningOptions& options);
+
+#endif // MPICOMMON_H
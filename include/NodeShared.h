@@ -0,0 +1,56 @@
+#ifndef NODESHARED_H
+#define NODESHARED_H
+
+// Carga de moléculas compartida por los procesos MPI de un mismo nodo. Se compila sólo
+// en las versiones MPI (src/parallel/mpi_common, ver compile.sh).
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mpi.h>
+#include "DataManager.h"
+#include "Molecule.h"
+
+// Cada proceso parsea un fragmento distinto de los ficheros (DataManager::setShard) y lo
+// empaqueta con el formato de librería binaria (MoleculeLibrary.h) directamente en su
+// sitio de una ventana MPI_Win_allocate_shared de su nodo (comunicador
+// MPI_COMM_TYPE_SHARED). Los procesos de un nodo parsean fragmentos consecutivos, así
+// que los procesos 0 de cada nodo completan las ventanas con un único MPI_Allgatherv.
+// Todos los procesos usan vistas Molecule sobre la ventana de su nodo: cada fichero se
+// abre una sola vez en total, hay una única copia por nodo y el orden es el de una
+// carga secuencial. El constructor, load() y release() son colectivos sobre
+// MPI_COMM_WORLD.
+class NodeSharedMolecules {
+public:
+    NodeSharedMolecules();
+    ~NodeSharedMolecules();
+
+    NodeSharedMolecules(const NodeSharedMolecules&) = delete;
+    NodeSharedMolecules& operator=(const NodeSharedMolecules&) = delete;
+
+    // Carga proteínas ('proteins' = true) o ligandos de 'path' en 'molecules'. Devuelve
+    // false en todos los procesos si falló la carga en alguno o no hay moléculas.
+    bool load(DataManager& dataManager, const std::string& path, bool proteins,
+              std::vector<Molecule>& molecules);
+
+    // Libera las ventanas. Las moléculas cargadas dejan de ser válidas: hay que
+    // llamarlo (tras descartarlas) antes de MPI_Finalize.
+    void release();
+
+    int getNodeRank() const { return nodeRank; }
+    int getNodeSize() const { return nodeSize; }
+    // Bytes compartidos en el nodo (suma de las ventanas).
+    std::size_t getSharedBytes() const { return sharedBytes; }
+
+private:
+    MPI_Comm nodeComm;
+    MPI_Comm leaderComm;         // Procesos 0 de cada nodo (MPI_COMM_NULL en los demás)
+    int nodeRank;
+    int nodeSize;
+    int leaderIndex;             // Posición del nodo en leaderComm
+    std::size_t shardBase;       // Primer fragmento que parsean los procesos del nodo
+    std::vector<MPI_Win> windows;
+    std::size_t sharedBytes;
+};
+
+#endif // NODESHARED_H
@@ -0,0 +1,83 @@
+#ifndef OCTREE_H
+#define OCTREE_H
+
+// Motor de puntuación aproximado para receptores grandes (al estilo Barnes-Hut): un
+// octree sobre los átomos de la proteína, construido una vez, en el que cada nodo guarda
+// el pseudo-átomo agregado de su subárbol. Para cada átomo del ligando, los nodos lejanos
+// (diámetro / distancia < theta) cuentan como una única interacción y los átomos de las
+// hojas cercanas se evalúan de forma exacta con el kernel SIMD. Con theta = 0 siempre se
+// abren los nodos y el resultado es el exacto (salvo redondeo).
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "ForceField.h"
+#include "Molecule.h"
+
+// Ángulo de apertura por defecto.
+const float DEFAULT_OCTREE_THETA = 0.5f;
+
+// Átomos máximos de una hoja (se evalúan de forma exacta).
+const std::size_t OCTREE_LEAF_ATOMS = 32;
+
+// Profundidad máxima (evita subdividir sin fin átomos casi coincidentes).
+const int OCTREE_MAX_DEPTH = 20;
+
+// Pares de la muestra con la que se mide el error frente al cálculo exacto.
+const std::size_t OCTREE_ERROR_SAMPLES = 32;
+
+struct OctreeParams {
+    bool enabled = false;
+    float theta = DEFAULT_OCTREE_THETA;
+};
+
+// Error de la aproximación frente al cálculo exacto sobre una muestra de pares. El
+// relativo es |aprox - exacto| / |exacto|; el absoluto lo dominan los pares con choques
+// estéricos (energías enormes), por eso sólo se guarda el máximo.
+struct ApproximationError {
+    std::size_t samples = 0;
+    double meanRel = 0.0;
+    double maxRel = 0.0;
+    double maxAbs = 0.0;
+};
+
+class ProteinOctree {
+public:
+    ProteinOctree();
+
+    void build(const Molecule& protein, ForceField forceField);
+
+    // Energía aproximada del ligando frente a la proteína. Si 'interactions' no es nulo,
+    // recibe las interacciones calculadas (con nodos lejanos y con átomos de las hojas).
+    float energy(const Molecule& ligand, float theta, std::size_t* interactions = nullptr) const;
+
+    bool empty() const { return nodes.empty(); }
+    std::size_t getNodeCount() const { return nodes.size(); }
+    std::size_t getBytes() const;
+
+private:
+    // Nodos en preorden: los hijos siguen a su padre y 'skip' es el primer nodo tras el
+    // subárbol, así que el recorrido no necesita pila. Sus átomos son [begin, end) en el
+    // orden del árbol. El centro es el centroide ponderado por b (el término dominante
+    // a distancia, 1/r^6) y el diámetro, el doble de la distancia al átomo más alejado
+    // (más ajustado que la arista del octante).
+    struct Node {
+        float x, y, z;
+        float diameter2;      // Diámetro al cuadrado
+        float a, b;           // Sumas de coeficientes separables (ForceField.h)
+        uint32_t begin, end;
+        uint32_t skip;
+        bool leaf;
+    };
+
+    uint32_t buildNode(std::vector<uint32_t>& order, std::vector<uint32_t>& scratch, const Molecule& protein,
+                       uint32_t begin, uint32_t end, const float center[3], float half, int depth);
+
+    ForceField forceField;
+    std::vector<Node> nodes;
+    AlignedVector<float> x, y, z;       // Átomos en el orden del árbol
+    AlignedVector<uint8_t> elements;
+};
+
+#endif // OCTREE_H
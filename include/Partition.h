@@ -0,0 +1,61 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <cstddef>
+#include <vector>
+#include "Docking.h"
+#include "Molecule.h"
+
+// Coste fijo estimado por par (preparación, llamada al kernel), en unidades de
+// "parejas de átomos". Evita que los pares de moléculas diminutas cuenten como gratis.
+const double PAIR_OVERHEAD_COST = 64.0;
+
+// Rango [begin, end) del espacio de pares aplanado.
+struct PairRange {
+    std::size_t begin;
+    std::size_t end;
+};
+
+// Modelo de coste de los pares (proteína i, ligando j) del espacio de índices aplanado
+// idx = i * numLigands + j que recorren los backends:
+//   coste(i, j) = peso(i) * átomos(j) + PAIR_OVERHEAD_COST
+// con peso(i) = átomos de la proteína en el cálculo exacto, y 1 con radio de corte o
+// rejillas (el coste pasa a depender sólo del ligando). El coste acumulado de cualquier
+// prefijo se obtiene en O(1) a partir de sumas prefijas por fila y por ligando, sin
+// materializar los numProteins * numLigands costes.
+class PairCostModel {
+public:
+    PairCostModel(const std::vector<Molecule>& proteins, const std::vector<Molecule>& ligands,
+                  const DockingParams& params);
+
+    std::size_t getNumPairs() const { return numPairs; }
+    double pairCost(std::size_t proteinIndex, std::size_t ligandIndex) const;
+
+    // Coste acumulado de los pares [0, idx).
+    double prefixCost(std::size_t idx) const;
+    double rangeCost(std::size_t begin, std::size_t end) const { return prefixCost(end) - prefixCost(begin); }
+    double totalCost() const { return prefixCost(numPairs); }
+
+    // Primer índice idx tal que prefixCost(idx) >= target.
+    std::size_t indexAtCost(double target) const;
+
+    // Divide [begin, end) en 'parts' rangos contiguos de coste similar (reparto por
+    // sumas prefijas). Devuelve parts + 1 fronteras: el rango k es [b[k], b[k + 1]).
+    std::vector<std::size_t> splitRange(std::size_t begin, std::size_t end, std::size_t parts) const;
+
+    // Divide una lista ordenada de rangos disjuntos en unos 'parts' rangos de coste
+    // similar, sin cruzar las fronteras de los rangos de entrada (al menos uno por rango).
+    std::vector<PairRange> splitRanges(const std::vector<PairRange>& ranges, std::size_t parts) const;
+
+private:
+    std::size_t numLigands;
+    std::size_t numPairs;
+    std::vector<double> proteinWeight;   // peso(i)
+    std::vector<double> rowPrefix;       // coste acumulado de las filas [0, i)
+    std::vector<double> ligandPrefix;    // átomos acumulados de los ligandos [0, j)
+};
+
+// Desequilibrio de carga medido: tiempo máximo / tiempo medio (1 = perfecto).
+double loadImbalance(const std::vector<double>& times);
+
+#endif // PARTITION_H
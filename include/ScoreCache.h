@@ -0,0 +1,83 @@
+#ifndef SCORECACHE_H
+#define SCORECACHE_H
+
+// Caché persistente de scores entre ejecuciones, direccionada por contenido: la clave de
+// un par es el hash de la proteína, del ligando y de los parámetros que afectan al score
+// (ver DockingScorer). Los pares que se repiten entre campañas cuestan una sonda en la
+// tabla en lugar del cálculo completo.
+//
+// El fichero "scores.bssc" del directorio es una tabla hash de direccionamiento abierto
+// (sondeo lineal, capacidad potencia de 2, carga <= 1/2):
+//
+//   ScoreCacheHeader
+//   ScoreCacheSlot[capacity]        (key == 0: hueco libre)
+//
+// Durante la ejecución la tabla se consulta proyectada en memoria (mmap) y no cambia, así
+// que las búsquedas no necesitan bloqueos. Los scores nuevos se acumulan en un buffer por
+// hilo y se vuelcan por lotes: bajo un bloqueo del fichero (flock) se releen las entradas
+// actuales, se añaden las nuevas y se escribe una tabla nueva que sustituye a la anterior
+// con rename, de modo que varios procesos pueden compartir el directorio y las
+// proyecciones abiertas nunca ven una tabla a medio escribir.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Scores nuevos por hilo que se pasan juntos a la cola compartida.
+const std::size_t SCORE_CACHE_BATCH = 4096;
+
+// Scores nuevos en cola a partir de los que se vuelcan al fichero durante la ejecución.
+const std::size_t SCORE_CACHE_FLUSH_ENTRIES = std::size_t(1) << 22;
+
+class ScoreCache {
+public:
+    ScoreCache();
+    ~ScoreCache();
+
+    ScoreCache(const ScoreCache&) = delete;
+    ScoreCache& operator=(const ScoreCache&) = delete;
+
+    // Abre (o crea) la caché del directorio 'dir'.
+    bool open(const std::string& dir);
+    bool isOpen() const { return !dir.empty(); }
+
+    // Busca el score de 'key' en la tabla abierta. Sin bloqueos; 'key' != 0.
+    bool lookup(uint64_t key, float& score) const;
+
+    // Añade un score nuevo al buffer del hilo actual. Se puede llamar desde varios hilos.
+    void insert(uint64_t key, float score);
+
+    // Vuelca al fichero todos los scores pendientes (fuera de regiones paralelas) y cierra.
+    void close();
+
+    // Entradas de la tabla abierta y scores nuevos escritos hasta ahora.
+    std::size_t getEntries() const { return entries; }
+    std::size_t getStored() const { return stored; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        float score;
+    };
+
+    std::vector<Entry>& threadBuffer();
+    bool merge(const std::vector<Entry>& added);
+
+    std::string dir;
+    MappedFile table;
+    const void* slots;
+    uint64_t mask;
+    std::size_t entries;
+    std::size_t stored;
+
+    uint64_t id;                                      // Identifica los buffers de esta caché
+    std::mutex mutex;
+    std::vector<std::unique_ptr<std::vector<Entry>>> buffers;
+    std::vector<Entry> queue;
+};
+
+#endif // SCORECACHE_H
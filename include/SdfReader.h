@@ -0,0 +1,77 @@
+#ifndef SDFREADER_H
+#define SDFREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Molecule.h"
+#include "MoleculeParser.h"
+
+// Tamaño por defecto de los fragmentos en que se divide un SDF grande para parsearlo
+// entre varios hilos.
+const uint64_t DEFAULT_SDF_CHUNK_BYTES = 32ull << 20;
+
+// Rango de bytes [begin, end) de un fichero.
+struct ByteRange {
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Divide un fichero de 'fileSize' bytes en rangos consecutivos de 'chunkSize' bytes.
+// Los cortes caen en cualquier byte: SdfReader se resincroniza con los "$$$$".
+std::vector<ByteRange> splitByteRanges(uint64_t fileSize, uint64_t chunkSize);
+
+// Lector en flujo de ficheros SDF con varios registros separados por "$$$$". Lee el
+// fichero con read() sobre un buffer acotado (sólo crece si un registro no cabe), de
+// modo que nunca tiene el fichero completo en memoria.
+//
+// Puede limitarse a un rango de bytes. Cada línea "$$$$" pertenece al rango en que
+// empieza, y el registro que la sigue pertenece a ese mismo rango (el primer registro
+// del fichero pertenece al rango que empieza en 0). Así, rangos disjuntos que cubren el
+// fichero leen cada registro exactamente una vez aunque los cortes caigan a mitad.
+class SdfReader {
+public:
+    SdfReader();
+    ~SdfReader();
+
+    SdfReader(const SdfReader&) = delete;
+    SdfReader& operator=(const SdfReader&) = delete;
+
+    // Abre 'filename' limitado a los registros del rango [begin, end).
+    bool open(const std::string& filename, uint64_t begin = 0, uint64_t end = UINT64_MAX);
+    void close();
+
+    // Añade los átomos del siguiente registro al final de 'mol' y acumula los
+    // errores de línea en 'status'. Devuelve false al terminar el rango o si falla la
+    // lectura (ver getError()). Los registros en blanco se omiten.
+    bool next(Molecule& mol, ParseStatus& status);
+
+    // Desplazamiento en el fichero del último registro devuelto por next().
+    uint64_t getRecordOffset() const { return recordOffset; }
+
+    // Mensaje del último error de E/S (vacío si no lo hubo).
+    const std::string& getError() const { return error; }
+
+private:
+    // Lee más datos al final del buffer, descartando antes lo ya consumido.
+    // Devuelve false en fin de fichero o error.
+    bool fill();
+    // Busca el siguiente fin de línea a partir de 'scan' (relativo a 'head').
+    bool findLineEnd(std::size_t& scan);
+    // Descarta datos hasta el primer registro que pertenece al rango.
+    bool synchronize(uint64_t begin);
+
+    int fd;
+    std::vector<char> buffer;
+    std::size_t head;       // Inicio de los datos sin consumir
+    std::size_t tail;       // Fin de los datos válidos
+    uint64_t bufferOffset;  // Posición en el fichero de buffer[0]
+    uint64_t rangeEnd;
+    uint64_t recordOffset;
+    bool eof;
+    bool done;
+    std::string error;
+};
+
+#endif // SDFREADER_H
@@ -0,0 +1,72 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Traza temporal opcional (--trace FICHERO) en formato Chrome/Perfetto: un evento con
+// inicio y fin por cada fase, unidad de trabajo, fichero parseado y llamada de
+// comunicación, por hilo y por proceso. Cada hilo escribe en su propio buffer circular,
+// sin bloqueos ni atómicos; los buffers se reúnen y se escriben al terminar. Con la
+// traza desactivada, cada punto de traza cuesta una comprobación de un booleano.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Eventos que guarda cada hilo; si se superan, los nuevos sustituyen a los más antiguos.
+const std::size_t TRACE_BUFFER_EVENTS = 1 << 16;
+
+struct TraceEvent {
+    const char* name;        // Cadenas estáticas: el evento sólo guarda el puntero
+    const char* category;
+    uint64_t start;          // Nanosegundos desde el inicio del proceso
+    uint64_t end;
+    uint64_t begin;          // Rango asociado (pares, bytes...); vacío si begin == end
+    uint64_t finish;
+};
+
+extern bool traceActive;
+
+inline bool isTracing() {
+    return traceActive;
+}
+
+// Activa la traza. Debe llamarse antes de crear los hilos que se quieren trazar.
+void startTracing();
+
+// Nanosegundos desde el inicio del proceso (reloj monótono).
+uint64_t traceClock();
+
+void recordTraceEvent(const char* name, const char* category, uint64_t start, uint64_t end,
+                      uint64_t begin = 0, uint64_t finish = 0);
+
+// Registra un evento desde su construcción hasta su destrucción (si la traza está activa).
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category, uint64_t begin = 0, uint64_t finish = 0)
+        : name(name), category(category), begin(begin), finish(finish),
+          start(isTracing() ? traceClock() : 0) {}
+    ~TraceScope() {
+        if (isTracing())
+            recordTraceEvent(name, category, start, traceClock(), begin, finish);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    uint64_t begin;
+    uint64_t finish;
+    uint64_t start;
+};
+
+// Eventos de todos los hilos del proceso como objetos JSON separados por comas, con
+// 'pid' como proceso y los tiempos desplazados 'offsetNs'. 'dropped' recibe los eventos
+// perdidos por desbordamiento de los buffers. Sólo debe llamarse sin hilos trazando.
+std::string formatTraceEvents(int pid, const std::string& processName, int64_t offsetNs, uint64_t& dropped);
+
+// Escribe la traza con los eventos de cada proceso (salida de formatTraceEvents).
+bool writeChromeTrace(const std::string& filename, const std::vector<std::string>& processes);
+
+#endif // TRACE_H
@@ -5,7 +5,10 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include "DataManager.h"
 #include "Docking.h"  // Para que se conozca la definición de DockingResult
+#include "HitCollector.h"
+#include "Checkpoint.h"
 
 const std::string DEFAULT_PROTEINS_DIR = "data/proteins/";
 const std::string DEFAULT_LIGANDS_DIR = "data/ligands/";
@@ -27,7 +30,79 @@ void logMessage(const std::string& msg);
 // Recibe el vector de scores, el número de proteínas y el número de ligandos.
 void analyzeDockingResults(const std::vector<float>& scores, int numProteins, int numLigands);
 
-void parseArguments(int argc, char* argv[], std::string &proteinsDir, std::string &ligandsDir, bool &verbose);
+// Muestra los hits retenidos por un HitCollector (modos --top / --threshold).
+void reportHits(const HitCollector& collector);
+
+// Prints the measured time of each worker ("thread", "rank"), the share of the estimated
+// cost it was assigned ('costShares', may be empty) and the max/mean imbalance.
+void printLoadBalance(const std::string& workerName, const std::vector<double>& times,
+                      const std::vector<double>& costShares);
+
+// Command-line configuration shared by every backend.
+struct ScreeningOptions {
+    std::string proteinsDir = DEFAULT_PROTEINS_DIR;
+    std::string ligandsDir = DEFAULT_LIGANDS_DIR;
+    bool verbose = false;
+    DockingParams docking;
+    // When enabled, backends stream scores into per-worker HitCollectors and never
+    // allocate the full proteins x ligands score matrix.
+    HitCriteria hits;
+    // Cache-blocked protein x ligand tiles (OpenMP backend).
+    bool tiled = false;
+    // Dynamic master/worker distribution with a shared counter (MPI backends).
+    bool dynamicSchedule = false;
+    // Directory for checkpoints of completed work (empty: disabled) and whether to
+    // resume from the ones already there.
+    std::string checkpointDir;
+    bool resume = false;
+    // Directory with the manifest and the score matrix of the previous run (empty:
+    // disabled). Only the pairs of new or changed molecules are computed.
+    std::string incrementalDir;
+    // Ligands are streamed in batches through a bounded queue fed by loader threads
+    // instead of being loaded up front (requires --top or --threshold).
+    bool stream = false;
+    std::size_t streamLoaders = DEFAULT_STREAM_LOADERS;
+    // JSON report of phase times, counters and rates (empty: not written).
+    std::string metricsFile;
+    // Chrome/Perfetto trace of phases, work units, parses and MPI calls (empty: off).
+    std::string traceFile;
+};
+
+// Opens the checkpoint in options.checkpointDir for 'writer' (see Checkpoint::open) and,
+// when 'restore' is set, reports how many of the pairs are already done. With
+// options.incrementalDir, the restoring writer also gets the pairs stored by the previous
+// run whose protein and ligand are unchanged.
+bool openCheckpoint(const ScreeningOptions& options, const std::vector<Molecule>& proteins,
+                    const std::vector<Molecule>& ligands, int writer, bool restore,
+                    Checkpoint& checkpoint);
+
+// With options.incrementalDir, stores the manifest of the inputs and the full score matrix
+// for the next run and reports which input files changed since the previous one.
+void saveIncrementalResults(const ScreeningOptions& options, const std::vector<Molecule>& proteins,
+                            const std::vector<Molecule>& ligands, const std::vector<float>& scores);
+
+// Scores every batch of 'stream' against all proteins and keeps the hits in 'hits'. The
+// threads of an OpenMP parallel region take batches as they arrive (with OpenMP); each
+// batch is released once scored. Ligand indices are positions in the stream.
+void screenLigandStream(const DockingScorer& scorer, std::size_t numProteins, LigandStream& stream,
+                        HitCollector& hits);
+
+// Prints how many ligands and batches were streamed and how long scoring waited for them.
+void printStreamSummary(const LigandStream& stream, std::size_t loaders);
+
+// Writes the metrics report of a single-process run to options.metricsFile, if set, and
+// prints its summary. 'backend' names the binary in the report. With a funnel it also
+// prints how many pairs pass each stage, and with a score cache its hit rate.
+void reportMetrics(const ScreeningOptions& options, const std::string& backend);
+
+// With the octree engine or grid maps, prints their size and the error measured against exact scoring.
+void reportApproximationError(const DockingScorer& scorer);
+
+// Writes the trace of a single-process run to options.traceFile, if set.
+void reportTrace(const ScreeningOptions& options, const std::string& backend);
+
+// Parses the command line. --trace starts tracing here, before any worker thread exists.
+void parseArguments(int argc, char* argv[], ScreeningOptions &options);
 
 void printHelp();
 
@@ -0,0 +1,93 @@
+#include "CacheInfo.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+static const std::size_t DEFAULT_L1D_BYTES = 32 * 1024;
+static const std::size_t DEFAULT_L2_BYTES = 1024 * 1024;
+static const std::size_t DEFAULT_L3_BYTES = 8 * 1024 * 1024;
+
+// Bytes por átomo en los arreglos SoA que recorre el kernel (x, y, z).
+static const std::size_t BYTES_PER_ATOM = 3 * sizeof(float);
+// Los bloques de proteína son múltiplos de la anchura AVX-512 para no generar colas.
+static const std::size_t ATOM_BLOCK_MULTIPLE = 16;
+static const std::size_t MAX_LIGAND_BATCH = 1024;
+
+// Lee un fichero pequeño de sysfs. Devuelve una cadena vacía si no existe.
+static std::string readSysfs(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr)
+        return "";
+    char buffer[64] = {0};
+    std::size_t n = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    std::fclose(file);
+    std::string value(buffer, n);
+    while (!value.empty() && (value.back() == '\n' || value.back() == ' '))
+        value.pop_back();
+    return value;
+}
+
+// Recorre /sys/devices/system/cpu/cpu0/cache/index* ("48K", "2048K", "8M").
+static void detectFromSysfs(CacheSizes& caches) {
+    for (int index = 0; index < 8; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::string level = readSysfs(dir + "level");
+        if (level.empty())
+            break;
+        std::string type = readSysfs(dir + "type");
+        std::string size = readSysfs(dir + "size");
+        if (type == "Instruction" || size.empty())
+            continue;
+        char* end = nullptr;
+        std::size_t bytes = std::strtoul(size.c_str(), &end, 10);
+        if (*end == 'K') bytes *= 1024;
+        else if (*end == 'M') bytes *= 1024 * 1024;
+        if (level == "1" && caches.l1d == 0) caches.l1d = bytes;
+        else if (level == "2" && caches.l2 == 0) caches.l2 = bytes;
+        else if (level == "3" && caches.l3 == 0) caches.l3 = bytes;
+    }
+}
+
+static std::size_t sysconfBytes(int name) {
+    long value = sysconf(name);
+    return value > 0 ? static_cast<std::size_t>(value) : 0;
+}
+
+static CacheSizes detectCacheSizes() {
+    CacheSizes caches = { 0, 0, 0 };
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    caches.l1d = sysconfBytes(_SC_LEVEL1_DCACHE_SIZE);
+    caches.l2 = sysconfBytes(_SC_LEVEL2_CACHE_SIZE);
+    caches.l3 = sysconfBytes(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if (caches.l1d == 0 || caches.l2 == 0 || caches.l3 == 0)
+        detectFromSysfs(caches);
+    if (caches.l1d == 0) caches.l1d = DEFAULT_L1D_BYTES;
+    if (caches.l2 == 0) caches.l2 = DEFAULT_L2_BYTES;
+    if (caches.l3 == 0) caches.l3 = DEFAULT_L3_BYTES;
+    return caches;
+}
+
+const CacheSizes& getCacheSizes() {
+    static const CacheSizes caches = detectCacheSizes();
+    return caches;
+}
+
+TileSizes chooseTileSizes(const CacheSizes& caches, std::size_t averageLigandAtoms) {
+    TileSizes tiles;
+    // Cada átomo de ligando recorre el bloque de proteína completo: debe seguir en L1.
+    tiles.proteinAtoms = (caches.l1d / 2) / BYTES_PER_ATOM;
+    tiles.proteinAtoms = std::max(ATOM_BLOCK_MULTIPLE, tiles.proteinAtoms / ATOM_BLOCK_MULTIPLE * ATOM_BLOCK_MULTIPLE);
+    // El lote de ligandos se vuelve a leer para cada bloque de proteína: debe seguir en L2.
+    std::size_t ligandBytes = std::max<std::size_t>(1, averageLigandAtoms) * BYTES_PER_ATOM;
+    tiles.ligands = std::min(MAX_LIGAND_BATCH, std::max<std::size_t>(1, (caches.l2 / 2) / ligandBytes));
+    return tiles;
+}
+
+std::string describeCacheSizes(const CacheSizes& caches) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), "L1d %zu KB, L2 %zu KB, L3 %zu KB",
+                  caches.l1d / 1024, caches.l2 / 1024, caches.l3 / 1024);
+    return buffer;
+}
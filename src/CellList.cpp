@@ -0,0 +1,130 @@
+#include "CellList.h"
+#include <algorithm>
+#include <cmath>
+
+// Límite de celdas por proteína: si la caja es muy grande respecto al corte, se
+// agrandan las celdas para no reservar una rejilla desproporcionada.
+static const std::size_t MAX_CELLS = 1u << 21;
+
+CellList::CellList()
+    : cellSize(0.0f), invCellSize(0.0f), originX(0.0f), originY(0.0f), originZ(0.0f),
+      dimX(0), dimY(0), dimZ(0) {
+}
+
+void CellList::build(const Molecule& protein, float minCellSize) {
+    const std::size_t n = protein.getAtomCount();
+    xs.assign(n, 0.0f);
+    ys.assign(n, 0.0f);
+    zs.assign(n, 0.0f);
+    elements.assign(n, ELEMENT_UNKNOWN);
+    cellStart.clear();
+    dimX = dimY = dimZ = 0;
+    if (n == 0 || minCellSize <= 0.0f)
+        return;
+
+    const float* px = protein.getX();
+    const float* py = protein.getY();
+    const float* pz = protein.getZ();
+
+    // Caja envolvente de la proteína.
+    float minX = px[0], minY = py[0], minZ = pz[0];
+    float maxX = px[0], maxY = py[0], maxZ = pz[0];
+    for (std::size_t k = 1; k < n; ++k) {
+        minX = std::min(minX, px[k]); maxX = std::max(maxX, px[k]);
+        minY = std::min(minY, py[k]); maxY = std::max(maxY, py[k]);
+        minZ = std::min(minZ, pz[k]); maxZ = std::max(maxZ, pz[k]);
+    }
+
+    cellSize = minCellSize;
+    for (;;) {
+        dimX = static_cast<int>((maxX - minX) / cellSize) + 1;
+        dimY = static_cast<int>((maxY - minY) / cellSize) + 1;
+        dimZ = static_cast<int>((maxZ - minZ) / cellSize) + 1;
+        if (static_cast<std::size_t>(dimX) * dimY * dimZ <= MAX_CELLS)
+            break;
+        cellSize *= 1.5f;
+    }
+    invCellSize = 1.0f / cellSize;
+    originX = minX;
+    originY = minY;
+    originZ = minZ;
+
+    // Ordenación por conteo: índice de celda de cada átomo, histograma y prefijos.
+    const std::size_t numCells = static_cast<std::size_t>(dimX) * dimY * dimZ;
+    std::vector<uint32_t> atomCell(n);
+    cellStart.assign(numCells + 1, 0);
+    for (std::size_t k = 0; k < n; ++k) {
+        int cx = std::min(dimX - 1, static_cast<int>((px[k] - originX) * invCellSize));
+        int cy = std::min(dimY - 1, static_cast<int>((py[k] - originY) * invCellSize));
+        int cz = std::min(dimZ - 1, static_cast<int>((pz[k] - originZ) * invCellSize));
+        atomCell[k] = static_cast<uint32_t>((static_cast<std::size_t>(cz) * dimY + cy) * dimX + cx);
+        cellStart[atomCell[k] + 1]++;
+    }
+    for (std::size_t c = 0; c < numCells; ++c)
+        cellStart[c + 1] += cellStart[c];
+
+    std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+    const uint8_t* pe = protein.getElements();
+    for (std::size_t k = 0; k < n; ++k) {
+        uint32_t dst = cursor[atomCell[k]]++;
+        xs[dst] = px[k];
+        ys[dst] = py[k];
+        zs[dst] = pz[k];
+        elements[dst] = pe[k];
+    }
+}
+
+bool CellList::empty() const {
+    return cellStart.empty();
+}
+
+std::size_t CellList::getAtomCount() const {
+    return xs.size();
+}
+
+int CellList::neighborRanges(float x, float y, float z, std::size_t* begins, std::size_t* ends) const {
+    if (cellStart.empty())
+        return 0;
+
+    // Celda (posiblemente fuera de la rejilla) que contiene el punto.
+    int cx = static_cast<int>(std::floor((x - originX) * invCellSize));
+    int cy = static_cast<int>(std::floor((y - originY) * invCellSize));
+    int cz = static_cast<int>(std::floor((z - originZ) * invCellSize));
+
+    int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, dimX - 1);
+    int y0 = std::max(cy - 1, 0), y1 = std::min(cy + 1, dimY - 1);
+    int z0 = std::max(cz - 1, 0), z1 = std::min(cz + 1, dimZ - 1);
+    if (x0 > x1 || y0 > y1 || z0 > z1)
+        return 0;
+
+    int count = 0;
+    for (int iz = z0; iz <= z1; ++iz) {
+        for (int iy = y0; iy <= y1; ++iy) {
+            std::size_t row = (static_cast<std::size_t>(iz) * dimY + iy) * dimX;
+            std::size_t begin = cellStart[row + x0];
+            std::size_t end = cellStart[row + x1 + 1];
+            if (begin < end) {
+                begins[count] = begin;
+                ends[count] = end;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+const float* CellList::getX() const {
+    return xs.data();
+}
+
+const float* CellList::getY() const {
+    return ys.data();
+}
+
+const float* CellList::getZ() const {
+    return zs.data();
+}
+
+const uint8_t* CellList::getElements() const {
+    return elements.data();
+}
@@ -0,0 +1,335 @@
+#include "Checkpoint.h"
+#include "DataManager.h"
+#include "Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cabecera del fichero de checkpoint.
+static const uint32_t CHECKPOINT_MAGIC = 0x4B435342;  // "BSCK"
+static const uint32_t CHECKPOINT_VERSION = 1;
+static const std::string CHECKPOINT_EXTENSION = ".bsck";
+
+// Tipo de los datos de un registro.
+static const uint32_t RECORD_SCORES = 1;
+static const uint32_t RECORD_HITS = 2;
+
+struct CheckpointFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+};
+
+struct CheckpointRecord {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t scored;      // Pares evaluados en el rango
+    uint64_t count;       // Elementos de datos que siguen al registro
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t checksum;    // Hash de los campos anteriores y de los datos
+};
+
+static uint64_t recordChecksum(const CheckpointRecord& record, const char* data, std::size_t bytes) {
+    uint64_t hash = hashBytes(&record, offsetof(CheckpointRecord, checksum));
+    return hashBytes(data, bytes, hash);
+}
+
+static std::size_t itemSize(uint32_t kind) {
+    return kind == RECORD_SCORES ? sizeof(float) : sizeof(DockingResult);
+}
+
+std::size_t checkpointUnits(std::size_t workers) {
+    return std::max(CHECKPOINT_MIN_UNITS, workers * CHECKPOINT_UNITS_PER_WORKER);
+}
+
+uint64_t dockingParamsKey(const DockingParams& params, uint64_t seed) {
+    uint64_t key = hashValue(params.cutoff, seed);
+    key = hashValue(params.effectiveSwitchDistance(), key);
+    key = hashValue(params.grid.enabled, key);
+    if (params.forceField != FORCEFIELD_UNIFORM)
+        key = hashValue(static_cast<uint32_t>(params.forceField), key);
+    if (params.funnel.enabled()) {
+        key = hashValue(params.funnel.keepFraction, key);
+        key = hashValue(params.funnel.useThreshold ? params.funnel.threshold : 0.0f, key);
+        key = hashValue(params.funnel.clusterSize, key);
+    }
+    if (params.octree.enabled)
+        key = hashValue(params.octree.theta, key);
+    if (params.grid.enabled) {
+        key = hashValue(params.grid.spacing, key);
+        key = hashValue(params.grid.hasBox, key);
+        key = hashBytes(params.grid.boxMin, sizeof(params.grid.boxMin), key);
+        key = hashBytes(params.grid.boxMax, sizeof(params.grid.boxMax), key);
+    }
+    return key;
+}
+
+uint64_t checkpointKey(const std::vector<Molecule>& proteins, const std::vector<Molecule>& ligands,
+                       const DockingParams& params, const HitCriteria& criteria) {
+    uint64_t key = hashValue(static_cast<uint64_t>(proteins.size()));
+    key = hashValue(static_cast<uint64_t>(ligands.size()), key);
+    for (const Molecule& protein : proteins)
+        key = hashValue(protein.contentHash(), key);
+    for (const Molecule& ligand : ligands)
+        key = hashValue(ligand.contentHash(), key);
+    key = dockingParamsKey(params, key);
+
+    key = hashValue(static_cast<uint64_t>(criteria.topK), key);
+    key = hashValue(criteria.useThreshold, key);
+    return hashValue(criteria.useThreshold ? criteria.threshold : 0.0f, key);
+}
+
+std::vector<PairRange> pendingRanges(const std::vector<PairRange>& completed, std::size_t total) {
+    std::vector<PairRange> pending;
+    std::size_t next = 0;
+    for (const PairRange& range : completed) {
+        if (range.begin > next)
+            pending.push_back(PairRange{ next, std::min(range.begin, total) });
+        next = std::max(next, range.end);
+    }
+    if (next < total)
+        pending.push_back(PairRange{ next, total });
+    return pending;
+}
+
+Checkpoint::Checkpoint() : key(0), file(nullptr), closing(false) {
+}
+
+Checkpoint::~Checkpoint() {
+    close();
+}
+
+// Lee los registros válidos de 'filename' hasta el primero incompleto o corrupto.
+// 'validBytes' es la longitud del prefijo válido. Devuelve false si el fichero no
+// existe o es de otro cálculo.
+bool Checkpoint::readFile(const std::string& filename, bool keepData, std::vector<Restored>& records,
+                          long& validBytes) const {
+    validBytes = 0;
+    FILE* in = std::fopen(filename.c_str(), "rb");
+    if (in == nullptr)
+        return false;
+    CheckpointFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, in) != 1 || header.magic != CHECKPOINT_MAGIC ||
+        header.version != CHECKPOINT_VERSION || header.key != key) {
+        std::fclose(in);
+        return false;
+    }
+    validBytes = sizeof(header);
+
+    CheckpointRecord record;
+    std::vector<char> data;
+    while (std::fread(&record, sizeof(record), 1, in) == 1) {
+        const uint64_t pairs = record.end - record.begin;
+        if (record.end < record.begin || (record.kind != RECORD_SCORES && record.kind != RECORD_HITS) ||
+            (record.kind == RECORD_SCORES && record.count != pairs) || record.count > pairs)
+            break;
+        data.resize(static_cast<std::size_t>(record.count) * itemSize(record.kind));
+        if (!data.empty() && std::fread(data.data(), data.size(), 1, in) != 1)
+            break;
+        if (recordChecksum(record, data.data(), data.size()) != record.checksum)
+            break;
+
+        Restored restoredRecord;
+        restoredRecord.range = PairRange{ static_cast<std::size_t>(record.begin), static_cast<std::size_t>(record.end) };
+        restoredRecord.scored = record.scored;
+        restoredRecord.hasScores = (record.kind == RECORD_SCORES);
+        if (keepData && record.kind == RECORD_SCORES) {
+            restoredRecord.scores.resize(record.count);
+            std::memcpy(restoredRecord.scores.data(), data.data(), data.size());
+        } else if (keepData) {
+            restoredRecord.hits.resize(record.count);
+            std::memcpy(restoredRecord.hits.data(), data.data(), data.size());
+        }
+        records.push_back(std::move(restoredRecord));
+        validBytes += static_cast<long>(sizeof(record) + data.size());
+    }
+    std::fclose(in);
+    return true;
+}
+
+// Sustituye los registros restaurados por 'records'. Por si quedaran ficheros de
+// ejecuciones que se solapan, sólo se aceptan registros disjuntos de los ya aceptados.
+void Checkpoint::acceptRecords(std::vector<Restored>& records) {
+    completed.clear();
+    restored.clear();
+    std::sort(records.begin(), records.end(), [](const Restored& a, const Restored& b) {
+        return a.range.begin < b.range.begin;
+    });
+    std::size_t end = 0;
+    for (Restored& record : records) {
+        if (record.range.begin < end || record.range.begin == record.range.end)
+            continue;
+        if (!completed.empty() && completed.back().end == record.range.begin)
+            completed.back().end = record.range.end;
+        else
+            completed.push_back(record.range);
+        end = record.range.end;
+        restored.push_back(std::move(record));
+    }
+}
+
+bool Checkpoint::open(const std::string& dir, int writer, uint64_t runKey, bool resume, bool restore) {
+    close();
+    key = runKey;
+    completed.clear();
+    restored.clear();
+    mkdir(dir.c_str(), 0755);
+
+    const std::string ownName = dir + "/checkpoint-" + std::to_string(writer) + CHECKPOINT_EXTENSION;
+    std::vector<std::string> files;
+    if (restore) {
+        if (!DataManager::listFiles(dir, { CHECKPOINT_EXTENSION }, files))
+            return false;
+        std::vector<Restored> records;
+        for (const std::string& filename : files) {
+            long validBytes;
+            if (!resume)
+                std::remove(filename.c_str());
+            else
+                readFile(filename, true, records, validBytes);
+        }
+        acceptRecords(records);
+    }
+
+    // El fichero propio se continúa, sin su posible final incompleto, o se empieza.
+    std::vector<Restored> ownRecords;
+    long validBytes = 0;
+    if (resume && readFile(ownName, false, ownRecords, validBytes) && truncate(ownName.c_str(), validBytes) == 0) {
+        file = std::fopen(ownName.c_str(), "ab");
+    } else {
+        file = std::fopen(ownName.c_str(), "wb");
+        CheckpointFileHeader header = { CHECKPOINT_MAGIC, CHECKPOINT_VERSION, key };
+        if (file != nullptr && (std::fwrite(&header, sizeof(header), 1, file) != 1 || std::fflush(file) != 0)) {
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+    if (file == nullptr) {
+        std::cerr << "Error abriendo el fichero de checkpoint " << ownName << std::endl;
+        return false;
+    }
+
+    closing = false;
+    writerThread = std::thread(&Checkpoint::writerLoop, this);
+    return true;
+}
+
+std::size_t Checkpoint::getRestoredPairs() const {
+    std::size_t pairs = 0;
+    for (const PairRange& range : completed)
+        pairs += range.end - range.begin;
+    return pairs;
+}
+
+void Checkpoint::restore(float* scores, HitCollector* hits) {
+    for (const Restored& record : restored) {
+        if (scores != nullptr && record.hasScores)
+            std::copy(record.scores.begin(), record.scores.end(), scores + record.range.begin);
+        if (hits != nullptr && !record.hasScores)
+            hits->merge(record.hits.data(), record.hits.data() + record.hits.size(), record.scored);
+    }
+    std::vector<Restored>().swap(restored);
+}
+
+void Checkpoint::addRestored(const std::vector<PairRange>& ranges, const std::vector<float>& scores) {
+    std::vector<Restored> records;
+    records.swap(restored);
+    std::size_t offset = 0;
+    for (const PairRange& range : ranges) {
+        Restored record;
+        record.range = range;
+        record.scored = range.end - range.begin;
+        record.hasScores = true;
+        record.scores.assign(scores.begin() + offset, scores.begin() + offset + (range.end - range.begin));
+        offset += range.end - range.begin;
+        records.push_back(std::move(record));
+    }
+    acceptRecords(records);
+}
+
+void Checkpoint::enqueue(const PairRange& range, uint64_t scored, uint32_t kind, const void* data,
+                         std::size_t count, std::size_t size) {
+    CheckpointRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.begin = range.begin;
+    record.end = range.end;
+    record.scored = scored;
+    record.count = count;
+    record.kind = kind;
+
+    // Sólo se copian los datos: el hash y la escritura los hace el hilo escritor.
+    std::vector<char> buffer(sizeof(record) + count * size);
+    std::memcpy(buffer.data(), &record, sizeof(record));
+    if (count > 0)
+        std::memcpy(buffer.data() + sizeof(record), data, count * size);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(buffer));
+    }
+    pending.notify_one();
+}
+
+void Checkpoint::recordScores(const PairRange& range, const float* scores) {
+    const std::size_t pairs = range.end - range.begin;
+    enqueue(range, pairs, RECORD_SCORES, scores, pairs, sizeof(float));
+}
+
+void Checkpoint::recordHits(const PairRange& range, const HitCollector& hits) {
+    const std::vector<DockingResult>& results = hits.getHits();
+    enqueue(range, hits.getScored(), RECORD_HITS, results.data(), results.size(), sizeof(DockingResult));
+}
+
+void Checkpoint::writerLoop() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastSync = Clock::now();
+    bool failed = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        pending.wait(lock, [this] { return closing || !queue.empty(); });
+        std::vector<std::vector<char>> batch;
+        batch.swap(queue);
+        const bool done = closing;
+        lock.unlock();
+
+        for (std::vector<char>& buffer : batch) {
+            CheckpointRecord record;
+            std::memcpy(&record, buffer.data(), sizeof(record));
+            record.checksum = recordChecksum(record, buffer.data() + sizeof(record), buffer.size() - sizeof(record));
+            std::memcpy(buffer.data(), &record, sizeof(record));
+            if (!failed && std::fwrite(buffer.data(), buffer.size(), 1, file) != 1) {
+                std::cerr << "Error escribiendo el checkpoint; no se guardarán más registros" << std::endl;
+                failed = true;
+            }
+        }
+        std::fflush(file);
+        // Sincronización periódica: el coste de fdatasync no se paga en cada registro.
+        std::chrono::duration<double> sinceSync = Clock::now() - lastSync;
+        if (done || sinceSync.count() >= CHECKPOINT_SYNC_SECONDS) {
+            fdatasync(fileno(file));
+            lastSync = Clock::now();
+        }
+
+        lock.lock();
+        if (done && queue.empty())
+            break;
+    }
+}
+
+void Checkpoint::close() {
+    if (file == nullptr)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    pending.notify_one();
+    writerThread.join();
+    std::fclose(file);
+    file = nullptr;
+}
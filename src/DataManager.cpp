@@ -1,197 +1,525 @@
 /* src/DataManager.cpp */
 #include "DataManager.h"
 #include "Molecule.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "MoleculeLibrary.h"
+#include "MoleculeParser.h"
+#include "SdfReader.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <chrono>
 #include <string>
 #include <dirent.h>      // Para la iteración de directorios
 #include <sys/stat.h>    // Para stat() y verificar tipos de archivo
 #include <cstring>       // Para strcmp
 
-// Función auxiliar para parsear archivos PDB
-static Molecule parsePDB(const std::string& filename) {
-    Molecule mol;
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error abriendo archivo: " << filename << std::endl;
-        return mol;
-    }
-    std::string line;
-    while (std::getline(file, line)) {
-        // Verificar que la línea comience con "ATOM" o "HETATM"
-        if (line.size() >= 4 && (line.substr(0, 4) == "ATOM" || 
-           (line.size() >= 6 && line.substr(0, 6) == "HETATM"))) {
-            try {
-                // Extraer coordenadas (columnas fijas según el estándar PDB)
-                std::string xStr = line.substr(30, 8);
-                std::string yStr = line.substr(38, 8);
-                std::string zStr = line.substr(46, 8);
-                float x = std::stof(xStr);
-                float y = std::stof(yStr);
-                float z = std::stof(zStr);
-
-                // Extraer el símbolo del elemento (col. 77-78)
-                std::string element;
-                if (line.size() >= 78) {
-                    element = line.substr(76, 2);
-                    element.erase(std::remove_if(element.begin(), element.end(), ::isspace), element.end());
-                } else {
-                    element = "X";  // Valor por defecto
-                }
-                Atom atom = { x, y, z, element };
-                mol.addAtom(atom);
-            } catch (const std::exception& e) {
-                std::cerr << "Error parseando línea en " << filename << ": " << e.what() << std::endl;
-            }
-        }
+// Número máximo de errores individuales que se muestran en el resumen de carga.
+static const std::size_t MAX_REPORTED_ERRORS = 5;
+
+// Tamaño mínimo de los rangos de un SDF cuando se reparte la carga entre procesos.
+static const uint64_t MIN_SHARD_CHUNK_BYTES = 1ull << 20;
+
+// Función para obtener la extensión en minúsculas de un nombre de archivo
+static std::string getExtension(const std::string& filename) {
+    std::size_t pos = filename.rfind('.');
+    if (pos == std::string::npos) return "";
+    std::string ext = filename.substr(pos);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
+
+// Unidad de trabajo de la carga: un fichero completo o un rango de bytes de un SDF.
+struct LoadUnit {
+    std::size_t file;
+    bool sdf;
+    ByteRange range;
+    uint64_t bytes;                    // Tamaño estimado (sólo para repartir fragmentos)
+};
+
+static uint64_t getFileSize(const std::string& filename) {
+    struct stat s;
+    return (stat(filename.c_str(), &s) == 0) ? static_cast<uint64_t>(s.st_size) : 0;
+}
+
+// Conserva sólo las unidades del fragmento 'index' de 'count': bloques contiguos de
+// bytes similares (cada unidad va al fragmento en el que cae su punto medio).
+template <typename Unit>
+static void selectShard(std::vector<Unit>& units, std::size_t index, std::size_t count) {
+    uint64_t total = 0;
+    for (const Unit& unit : units)
+        total += unit.bytes;
+    std::vector<Unit> selected;
+    uint64_t before = 0;
+    for (std::size_t u = 0; u < units.size(); ++u) {
+        double middle = (total > 0) ? (before + units[u].bytes / 2.0) / total
+                                    : (u + 0.5) / units.size();
+        std::size_t shard = std::min(count - 1, static_cast<std::size_t>(middle * count));
+        if (shard == index)
+            selected.push_back(units[u]);
+        before += units[u].bytes;
     }
-    file.close();
-    return mol;
-}
-
-// Función auxiliar para parsear archivos SDF
-static Molecule parseSDF(const std::string& filename) {
-    Molecule mol;
-    std::ifstream file(filename);
-    if (!file.is_open()){
-        std::cerr << "Error abriendo archivo: " << filename << std::endl;
-        return mol;
-    }
-    std::string line;
-    // Omitir las primeras 3 líneas de cabecera
-    for (int i = 0; i < 3 && std::getline(file, line); ++i) {}
-
-    // La cuarta línea es la línea de conteo
-    if (!std::getline(file, line)) {
-        std::cerr << "Error leyendo línea de conteo en " << filename << std::endl;
-        return mol;
-    }
-    int numAtoms = 0;
-    try {
-        numAtoms = std::stoi(line.substr(0, 3));
-    } catch (const std::exception& e) {
-        std::cerr << "Error parseando número de átomos en " << filename << ": " << e.what() << std::endl;
-        return mol;
-    }
-    // Parsear las siguientes numAtoms líneas (sección de átomos)
-    for (int i = 0; i < numAtoms; ++i) {
-        if (!std::getline(file, line))
-            break;
-        try {
-            // Para SDF (V2000):  
-            // X: columnas 1–10, Y: columnas 11–20, Z: columnas 21–30, Elemento: columnas 32–34
-            std::string xStr = line.substr(0, 10);
-            std::string yStr = line.substr(10, 10);
-            std::string zStr = line.substr(20, 10);
-            float x = std::stof(xStr);
-            float y = std::stof(yStr);
-            float z = std::stof(zStr);
-
-            std::string element;
-            if (line.size() >= 34) {
-                element = line.substr(31, 3);
-                element.erase(std::remove_if(element.begin(), element.end(), ::isspace), element.end());
-            } else {
-                element = "X";
-            }
-            Atom atom = { x, y, z, element };
-            mol.addAtom(atom);
-        } catch (const std::exception & e) {
-            std::cerr << "Error parseando átomo en " << filename << ": " << e.what() << std::endl;
-        }
+    units.swap(selected);
+}
+
+// Resultado de una unidad (o, tras la mezcla, de un fichero completo). Las moléculas
+// van a la arena que recibe cada parser; aquí queda una posición por molécula.
+struct LoadResult {
+    std::vector<uint64_t> offsets;     // Posición en el fichero de cada molécula
+    std::size_t badLines = 0;
+    std::size_t emptyRecords = 0;      // Registros sin átomos
+    std::string firstError;
+};
+
+// Parsea un fichero PDB proyectándolo en memoria y parseándolo en el sitio
+// (ver MoleculeParser.h).
+static void parsePDBFile(const std::string& filename, MoleculeArena& molecules, LoadResult& result) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        result.firstError = "error abriendo archivo";
+        return;
+    }
+    addMetricCounter(COUNTER_BYTES_READ, file.size());
+    ParseStatus status = parsePDBBuffer(file.data(), file.data() + file.size(), molecules.getBuffer());
+    result.badLines = status.badLines;
+    result.firstError = status.firstError;
+    if (molecules.commit())
+        result.offsets.push_back(0);
+    else
+        result.emptyRecords++;
+}
+
+// Parsea en flujo los registros SDF que pertenecen a 'range' (ver SdfReader.h).
+static void parseSDFRange(const std::string& filename, const ByteRange& range, MoleculeArena& molecules,
+                          LoadResult& result) {
+    SdfReader reader;
+    if (!reader.open(filename, range.begin, range.end)) {
+        result.firstError = reader.getError();
+        return;
+    }
+    addMetricCounter(COUNTER_BYTES_READ, range.end - range.begin);
+    ParseStatus status;
+    while (reader.next(molecules.getBuffer(), status)) {
+        if (molecules.commit())
+            result.offsets.push_back(reader.getRecordOffset());
+        else
+            result.emptyRecords++;
+    }
+    result.badLines = status.badLines;
+    result.firstError = !reader.getError().empty() ? reader.getError() : status.firstError;
+}
+
+// Añade a 'total' los resultados de una unidad del mismo fichero.
+static void mergeResult(LoadResult& total, const LoadResult& unit) {
+    total.offsets.insert(total.offsets.end(), unit.offsets.begin(), unit.offsets.end());
+    if (total.firstError.empty())
+        total.firstError = unit.firstError;
+    total.badLines += unit.badLines;
+    total.emptyRecords += unit.emptyRecords;
+}
+
+// Mensaje de error agregado de un fichero (vacío si no hubo errores).
+static std::string describeErrors(const std::string& filename, const LoadResult& result) {
+    std::string message;
+    if (result.badLines > 0) {
+        message = std::to_string(result.badLines) + " línea(s) no válidas (" + result.firstError + ")";
+    } else if (!result.firstError.empty()) {
+        message = result.firstError;
+    }
+    if (result.offsets.empty()) {
+        if (message.empty())
+            message = "no se parsearon átomos";
+    } else if (result.emptyRecords > 0) {
+        message += (message.empty() ? "" : "; ") + std::to_string(result.emptyRecords) +
+                   " registro(s) sin átomos";
     }
-    file.close();
-    return mol;
+    return message.empty() ? message : filename + ": " + message;
 }
 
 // Constructor y Destructor
-DataManager::DataManager() {
-    // Inicializaciones necesarias.
+DataManager::DataManager() : sdfChunkBytes(DEFAULT_SDF_CHUNK_BYTES), shardIndex(0), shardCount(1) {
 }
 
 DataManager::~DataManager() {
     // Liberar recursos si es necesario.
 }
 
-// Función para obtener la extensión en minúsculas de un nombre de archivo
-static std::string getExtension(const std::string& filename) {
-    std::size_t pos = filename.rfind('.');
-    if (pos == std::string::npos) return "";
-    std::string ext = filename.substr(pos);
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-    return ext;
-}
+bool DataManager::listFiles(const std::string& path, const std::vector<std::string>& extensions,
+                            std::vector<std::string>& files) {
+    files.clear();
+    struct stat s;
+    if (stat(path.c_str(), &s) == 0 && S_ISREG(s.st_mode)) {
+        files.push_back(path);
+        return true;
+    }
 
-// Función para cargar proteínas desde archivos PDB en un directorio
-bool DataManager::loadProteins(const std::string& path, std::vector<Molecule>& proteins) {
     DIR *dir = opendir(path.c_str());
     if (dir == nullptr) {
         std::cerr << "Error abriendo el directorio: " << path << std::endl;
         return false;
     }
     struct dirent *entry;
-    int count = 0;
     while ((entry = readdir(dir)) != nullptr) {
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
             continue;
+        std::string ext = getExtension(entry->d_name);
+        if (std::find(extensions.begin(), extensions.end(), ext) == extensions.end())
+            continue;
 
         std::string filepath = path + "/" + entry->d_name;
-        struct stat s;
-        if (stat(filepath.c_str(), &s) == 0 && S_ISREG(s.st_mode)) {
-            std::string ext = getExtension(entry->d_name);
-            if (ext == ".pdb") {
-                Molecule mol = parsePDB(filepath);
-                if (mol.getAtoms().empty()) {
-                    std::cerr << "No se parsearon átomos en " << filepath << std::endl;
-                } else {
-                    proteins.push_back(mol);
-                    count++;
-                }
-            }
-        }
+        // d_type evita un stat() por fichero cuando el sistema de ficheros lo rellena.
+        bool regular = (entry->d_type == DT_REG);
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
+            regular = (stat(filepath.c_str(), &s) == 0 && S_ISREG(s.st_mode));
+        if (regular)
+            files.push_back(filepath);
     }
     closedir(dir);
+
+    // Orden determinista (el de readdir es arbitrario).
+    std::sort(files.begin(), files.end());
+    return true;
+}
+
+// Enumera primero los ficheros y los divide en unidades de trabajo (los SDF grandes en
+// varios rangos de bytes). Las unidades se parsean en paralelo (reparto dinámico entre
+// hilos OpenMP) y se colocan en el orden de la lista ordenada.
+bool DataManager::loadFiles(const std::string& path, const std::vector<std::string>& extensions,
+                            std::vector<Molecule>& molecules) {
+    lastReport = LoadReport();
+
+    const bool sharded = (shardCount > 1);
+
+    // Librería binaria (.bslib): se proyecta y se sirven vistas sin copiar ni parsear.
+    if (getExtension(path) == LIBRARY_EXTENSION)
+        return (sharded && shardIndex != 0) ? true : loadLibrary(path, molecules);
+
+    std::vector<std::string> files;
+    {
+        ScopedPhase phase(PHASE_SCAN);
+        if (!listFiles(path, extensions, files))
+            return false;
+    }
+    lastReport.filesFound = files.size();
+
+    std::vector<LoadUnit> units;
+    units.reserve(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (getExtension(files[i]) != ".sdf") {
+            // El tamaño sólo hace falta (y sólo se pide a stat) para repartir fragmentos.
+            units.push_back(LoadUnit{ i, false, ByteRange{ 0, 0 }, sharded ? getFileSize(files[i]) : 0 });
+            continue;
+        }
+        uint64_t size = getFileSize(files[i]);
+        uint64_t chunk = sdfChunkBytes;
+        // Con fragmentos, un SDF se divide lo suficiente para repartirlo entre todos.
+        if (sharded && chunk > 0)
+            chunk = std::min(chunk, std::max(MIN_SHARD_CHUNK_BYTES, (size + shardCount - 1) / shardCount));
+        for (const ByteRange& range : splitByteRanges(size, chunk))
+            units.push_back(LoadUnit{ i, true, range, range.end - range.begin });
+    }
+    // Número de unidades de cada fichero, para saber si un fragmento lo tiene completo.
+    std::vector<std::size_t> fileUnits(files.size(), 0);
+    for (const LoadUnit& unit : units)
+        fileUnits[unit.file]++;
+    if (sharded)
+        selectShard(units, shardIndex, shardCount);
+
+    ScopedPhase phase(PHASE_PARSE);
+    std::vector<LoadResult> parsed(units.size());
+    std::vector<MoleculeArena> arenas(units.size());
+    // Reparto de una unidad cada vez: los rangos de un SDF grande son consecutivos.
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (std::size_t u = 0; u < units.size(); ++u) {
+        const LoadUnit& unit = units[u];
+        TraceScope trace("parse", "io", unit.range.begin, unit.range.end);
+        if (unit.sdf)
+            parseSDFRange(files[unit.file], unit.range, arenas[u], parsed[u]);
+        else
+            parsePDBFile(files[unit.file], arenas[u], parsed[u]);
+        arenas[u].shrinkToFit();
+    }
+
+    // Cada unidad entrega, en orden, sus moléculas como vistas sobre su propia arena, que
+    // queda compartida por ellas; no se copia a un bloque común.
+    std::size_t totalMolecules = 0;
+    for (const MoleculeArena& arena : arenas)
+        totalMolecules += arena.size();
+    const std::size_t firstMolecule = molecules.size();
+    molecules.reserve(firstMolecule + totalMolecules);
+    lastReport.sources.reserve(lastReport.sources.size() + totalMolecules);
+    for (std::size_t u = 0; u < units.size(); ) {
+        // Mezclar las unidades consecutivas del mismo fichero.
+        const std::size_t file = units[u].file;
+        const std::size_t first = u;
+        LoadResult result = std::move(parsed[u]);
+        arenas[u++].release(molecules);
+        while (u < units.size() && units[u].file == file) {
+            mergeResult(result, parsed[u]);
+            arenas[u++].release(molecules);
+        }
+        const bool complete = (u - first == fileUnits[file]);
+
+        // Un fichero repartido entre fragmentos puede no tener moléculas en éste.
+        std::string error = (complete || !result.offsets.empty() || result.badLines > 0 ||
+                             !result.firstError.empty()) ? describeErrors(files[file], result) : "";
+        if (!error.empty())
+            lastReport.errors.push_back(error);
+        // Un fichero con una sola molécula se identifica por su nombre, como siempre.
+        const bool single = (complete && result.offsets.size() == 1 && result.offsets[0] == 0);
+        for (uint64_t offset : result.offsets)
+            lastReport.sources.push_back(single ? files[file] : files[file] + "@" + std::to_string(offset));
+    }
+    const std::size_t count = molecules.size() - firstMolecule;
+
+    // Resumen agregado de errores en lugar de un mensaje por línea.
+    if (!lastReport.errors.empty()) {
+        std::cerr << lastReport.errors.size() << " de " << files.size() << " fichero(s) en " << path
+                  << " con errores";
+        if (sharded)
+            std::cerr << " en el fragmento " << shardIndex + 1 << " de " << shardCount;
+        if (lastReport.errors.size() > MAX_REPORTED_ERRORS)
+            std::cerr << " (se muestran los " << MAX_REPORTED_ERRORS << " primeros)";
+        std::cerr << ":" << std::endl;
+        for (std::size_t i = 0; i < lastReport.errors.size() && i < MAX_REPORTED_ERRORS; ++i)
+            std::cerr << "  " << lastReport.errors[i] << std::endl;
+    }
+    return (count > 0 || sharded);
+}
+
+bool DataManager::loadLibrary(const std::string& path, std::vector<Molecule>& molecules) {
+    ScopedPhase phase(PHASE_PARSE);
+    std::size_t first = molecules.size();
+    std::vector<std::string> names;
+    std::string error;
+    if (!openLibrary(path, molecules, &names, error)) {
+        std::cerr << "Error cargando la librería " << error << std::endl;
+        lastReport.errors.push_back(error);
+        return false;
+    }
+    std::size_t count = molecules.size() - first;
+    lastReport.filesFound = 1;
+    if (names.size() == count) {
+        lastReport.sources = std::move(names);
+    } else {
+        for (std::size_t i = 0; i < count; ++i)
+            lastReport.sources.push_back(path + "#" + std::to_string(i));
+    }
     return (count > 0);
 }
 
+const std::vector<std::string>& DataManager::proteinExtensions() {
+    static const std::vector<std::string> extensions = { ".pdb" };
+    return extensions;
+}
+
+const std::vector<std::string>& DataManager::ligandExtensions() {
+    static const std::vector<std::string> extensions = { ".pdb", ".sdf" };
+    return extensions;
+}
+
+// Función para cargar proteínas desde archivos PDB en un directorio
+bool DataManager::loadProteins(const std::string& path, std::vector<Molecule>& proteins) {
+    return loadFiles(path, proteinExtensions(), proteins);
+}
+
 // Función para cargar ligandos desde archivos SDF o PDB en un directorio
 bool DataManager::loadLigands(const std::string& path, std::vector<Molecule>& ligands) {
-    DIR *dir = opendir(path.c_str());
-    if (dir == nullptr) {
-        std::cerr << "Error abriendo el directorio: " << path << std::endl;
-        return false;
+    return loadFiles(path, ligandExtensions(), ligands);
+}
+
+const LoadReport& DataManager::getLastReport() const {
+    return lastReport;
+}
+
+LigandStream::LigandStream()
+    : capacity(0), nextUnit(0), nextBatch(0), queued(0), closing(false),
+      delivered(0), batches(0), peakQueued(0), waitSeconds(0.0) {
+}
+
+LigandStream::~LigandStream() {
+    close();
+}
+
+// Las unidades son rangos de STREAM_SDF_CHUNK_BYTES de los SDF grandes o grupos de hasta
+// STREAM_UNIT_FILES ficheros pequeños consecutivos que suman como mucho un rango; en una
+// librería, grupos de vistas con el tamaño medio de un rango de SDF.
+bool LigandStream::open(const std::string& streamPath, std::size_t numLoaders, std::size_t queueCapacity,
+                        std::size_t shardIndex, std::size_t shardCount) {
+    close();
+    path = streamPath;
+    files.clear();
+    sizes.clear();
+    units.clear();
+    library.clear();
+    errors.clear();
+    const bool sharded = (shardCount > 1);
+
+    if (getExtension(path) == LIBRARY_EXTENSION) {
+        ScopedPhase phase(PHASE_PARSE);
+        std::string error;
+        if (!openLibrary(path, library, nullptr, error)) {
+            std::cerr << "Error cargando la librería " << error << std::endl;
+            return false;
+        }
+        uint64_t atoms = 0;
+        for (const Molecule& molecule : library)
+            atoms += molecule.getAtomCount();
+        // Unos 40 bytes de SDF por átomo.
+        const std::size_t perUnit = std::max<std::size_t>(1, library.empty() ? 1 :
+            static_cast<std::size_t>(STREAM_SDF_CHUNK_BYTES / 40 / std::max<uint64_t>(1, atoms / library.size())));
+        for (std::size_t first = 0; first < library.size(); first += perUnit) {
+            const std::size_t last = std::min(library.size(), first + perUnit);
+            units.push_back(Unit{ first, last, false, ByteRange{ 0, 0 }, last - first });
+        }
+    } else {
+        {
+            ScopedPhase phase(PHASE_SCAN);
+            if (!DataManager::listFiles(path, DataManager::ligandExtensions(), files))
+                return false;
+        }
+        sizes.resize(files.size());
+        for (std::size_t f = 0; f < files.size(); ++f)
+            sizes[f] = getFileSize(files[f]);
+        for (std::size_t f = 0; f < files.size(); ) {
+            if (getExtension(files[f]) == ".sdf" && sizes[f] > STREAM_SDF_CHUNK_BYTES) {
+                for (const ByteRange& range : splitByteRanges(sizes[f], STREAM_SDF_CHUNK_BYTES))
+                    units.push_back(Unit{ f, f + 1, true, range, range.end - range.begin });
+                f++;
+                continue;
+            }
+            // Ficheros pequeños consecutivos, hasta STREAM_UNIT_FILES o el tamaño de un rango.
+            Unit unit = { f, f, false, ByteRange{ 0, 0 }, 0 };
+            while (unit.lastFile < files.size() && unit.lastFile - f < STREAM_UNIT_FILES &&
+                   unit.bytes < STREAM_SDF_CHUNK_BYTES &&
+                   !(getExtension(files[unit.lastFile]) == ".sdf" && sizes[unit.lastFile] > STREAM_SDF_CHUNK_BYTES)) {
+                unit.bytes += sizes[unit.lastFile];
+                unit.lastFile++;
+            }
+            units.push_back(unit);
+            f = unit.lastFile;
+        }
     }
-    struct dirent *entry;
-    int count = 0;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
+    if (sharded)
+        selectShard(units, shardIndex, shardCount);
 
-        std::string filepath = path + "/" + entry->d_name;
-        struct stat s;
-        if (stat(filepath.c_str(), &s) == 0 && S_ISREG(s.st_mode)) {
-            std::string ext = getExtension(entry->d_name);
-            if (ext == ".pdb") {
-                Molecule mol = parsePDB(filepath);
-                if (mol.getAtoms().empty())
-                    std::cerr << "No se parsearon átomos en " << filepath << std::endl;
-                else {
-                    ligands.push_back(mol);
-                    count++;
-                }
-            } else if (ext == ".sdf") {
-                Molecule mol = parseSDF(filepath);
-                if (mol.getAtoms().empty())
-                    std::cerr << "No se parsearon átomos en " << filepath << std::endl;
-                else {
-                    ligands.push_back(mol);
-                    count++;
+    ready.clear();
+    ready.resize(units.size());
+    capacity = std::max<std::size_t>(1, queueCapacity);
+    nextUnit = nextBatch = queued = 0;
+    closing = false;
+    delivered = batches = peakQueued = 0;
+    waitSeconds = 0.0;
+    for (std::size_t t = 0; t < std::max<std::size_t>(1, numLoaders); ++t)
+        loaders.emplace_back(&LigandStream::loaderLoop, this);
+    return true;
+}
+
+void LigandStream::loaderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // La carga no se adelanta más de 'capacity' unidades a la siguiente por entregar.
+        consumed.wait(lock, [this] {
+            return closing || nextUnit >= units.size() || nextUnit < nextBatch + capacity;
+        });
+        if (closing || nextUnit >= units.size())
+            return;
+        const std::size_t u = nextUnit++;
+        lock.unlock();
+
+        const Unit& unit = units[u];
+        std::unique_ptr<Parsed> result(new Parsed());
+        {
+            ScopedPhase phase(PHASE_PARSE);
+            TraceScope trace("parse", "io", unit.range.begin, unit.range.end);
+            if (!library.empty()) {
+                // Vistas sobre la librería proyectada (clone() no copia los átomos).
+                result->molecules.reserve(unit.lastFile - unit.firstFile);
+                for (std::size_t f = unit.firstFile; f < unit.lastFile; ++f)
+                    result->molecules.push_back(library[f].clone());
+            } else {
+                // Todos los ficheros de la unidad comparten una arena, que se libera
+                // cuando se descartan las moléculas del lote.
+                MoleculeArena arena;
+                for (std::size_t f = unit.firstFile; f < unit.lastFile; ++f) {
+                    LoadResult loaded;
+                    if (unit.split)
+                        parseSDFRange(files[f], unit.range, arena, loaded);
+                    else if (getExtension(files[f]) == ".sdf")
+                        parseSDFRange(files[f], ByteRange{ 0, sizes[f] }, arena, loaded);
+                    else
+                        parsePDBFile(files[f], arena, loaded);
+                    // Un rango de SDF puede no tener registros propios sin que sea un error.
+                    const std::string error = (!unit.split || !loaded.offsets.empty() || loaded.badLines > 0 ||
+                                               !loaded.firstError.empty()) ? describeErrors(files[f], loaded) : "";
+                    if (!error.empty())
+                        result->errors.push_back(error);
                 }
+                arena.release(result->molecules);
             }
         }
+
+        lock.lock();
+        ready[u] = std::move(result);
+        queued++;
+        peakQueued = std::max(peakQueued, queued);
+        parsed.notify_all();
     }
-    closedir(dir);
-    return (count > 0);
-}
\ No newline at end of file
+}
+
+bool LigandStream::next(MoleculeBatch& batch) {
+    batch.molecules.clear();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (nextBatch < units.size()) {
+        if (!ready[nextBatch]) {
+            // Varios hilos pueden esperar la misma unidad: al despertar, otro puede
+            // haberla tomado (incluso la última), así que se vuelve a comprobar el bucle.
+            const auto start = std::chrono::steady_clock::now();
+            parsed.wait(lock, [this] { return nextBatch >= units.size() || ready[nextBatch]; });
+            waitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            continue;
+        }
+        std::unique_ptr<Parsed> unit = std::move(ready[nextBatch]);
+        nextBatch++;
+        queued--;
+        consumed.notify_all();
+        // Los que esperan una unidad posterior a la última deben ver que se acabó.
+        if (nextBatch == units.size())
+            parsed.notify_all();
+        errors.insert(errors.end(), unit->errors.begin(), unit->errors.end());
+        if (unit->molecules.empty())
+            continue;
+        batch.first = delivered;
+        batch.molecules = std::move(unit->molecules);
+        delivered += batch.molecules.size();
+        batches++;
+        return true;
+    }
+    return false;
+}
+
+void LigandStream::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    consumed.notify_all();
+    for (std::thread& loader : loaders)
+        loader.join();
+    loaders.clear();
+    ready.clear();
+    library.clear();
+
+    if (!errors.empty()) {
+        std::cerr << errors.size() << " error(es) en los ficheros de " << path;
+        if (errors.size() > MAX_REPORTED_ERRORS)
+            std::cerr << " (se muestran los " << MAX_REPORTED_ERRORS << " primeros)";
+        std::cerr << ":" << std::endl;
+        for (std::size_t i = 0; i < errors.size() && i < MAX_REPORTED_ERRORS; ++i)
+            std::cerr << "  " << errors[i] << std::endl;
+        errors.clear();
+    }
+}
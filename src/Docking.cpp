@@ -1,35 +1,648 @@
 #include "Docking.h"
+#include "DockingKernels.h"
+#include "Hash.h"
+#include "Metrics.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <limits>
 
 // Re-implementación real de performDocking basada en un potencial de Lennard-Jones
-float performDocking(const Molecule& protein, const Molecule& ligand) {
+float performDocking(const Molecule& protein, const Molecule& ligand, ForceField forceField) {
     // Verificar que ambas moléculas contienen átomos.
-    if (protein.getAtoms().empty() || ligand.getAtoms().empty()) {
+    if (protein.empty() || ligand.empty()) {
         return 0.0f;
     }
-    
+
+    // Parámetros del potencial Lennard-Jones (por defecto, sigma = 1 y epsilon = 1):
+    // energía = sum 4 * ((1 / r^12) - (1 / r^6)) sobre cada par (ligando, proteína).
+    // Con parámetros por elemento, c12 y c6 de cada par salen de la tabla combinada
+    // indexada por los códigos de elemento (ver ForceField.h).
+    // El doble bucle lo resuelve el kernel SIMD elegido en tiempo de ejecución
+    // (ver DockingKernels.h), que recorre directamente los arreglos SoA.
+    const LJKernelFn kernel = getLJKernel(forceField);
+    return kernel(ligand.getX(), ligand.getY(), ligand.getZ(), ligand.getElements(), ligand.getAtomCount(),
+                  protein.getX(), protein.getY(), protein.getZ(), protein.getElements(), protein.getAtomCount());
+}
+
+float DockingParams::effectiveSwitchDistance() const {
+    if (switchDistance >= 0.0f)
+        return std::min(switchDistance, cutoff);
+    return std::max(0.0f, cutoff - DEFAULT_SWITCH_WIDTH);
+}
+
+// Constantes de la función de conmutación de CHARMM entre r_on y r_c:
+//   S(r) = (rc2 - r2)^2 * (rc2 + 2 r2 - 3 ron2) / (rc2 - ron2)^3
+// vale 1 en r_on, 0 en r_c y su derivada se anula en ambos extremos.
+struct SwitchConstants {
+    float rc2;
+    float ron2;
+    float invDenom;
+
+    explicit SwitchConstants(const DockingParams& params) {
+        rc2 = params.cutoff * params.cutoff;
+        const float ron = params.effectiveSwitchDistance();
+        ron2 = ron * ron;
+        const float denom = (rc2 - ron2) * (rc2 - ron2) * (rc2 - ron2);
+        invDenom = denom > 0.0f ? 1.0f / denom : 0.0f;
+    }
+};
+
+// Energía con corte de un átomo de tipo 'element' en (x, y, z) frente a los átomos de la
+// lista de celdas. Suma a 'evaluated' los átomos de las celdas vecinas, que son las
+// parejas que se calculan.
+template <class LJ>
+static inline float cutoffAtomEnergy(const CellList& cells, const SwitchConstants& sw,
+                                     float x, float y, float z, uint8_t element, std::size_t& evaluated) {
+    const float* px = cells.getX();
+    const float* py = cells.getY();
+    const float* pz = cells.getZ();
+    const uint8_t* pe = cells.getElements();
+    const float* c12Row = LJ::table().c12[element];
+    const float* c6Row = LJ::table().c6[element];
+    const float rc2 = sw.rc2;
+    const float ron2 = sw.ron2;
+    const float invSwitchDenom = sw.invDenom;
+
+    std::size_t begins[9];
+    std::size_t ends[9];
+    const int numRanges = cells.neighborRanges(x, y, z, begins, ends);
     float energy = 0.0f;
-    // Parámetros del potencial Lennard-Jones (para simplificar, sigma = 1 y epsilon = 1)
-    const float epsilon = 1.0f;
-    // sigma^6 y sigma^12 son 1 cuando sigma = 1, por lo que se omiten.
-    
-    // Se recorre cada par de átomos (ligando-proteína)
-    for (const auto& atomL : ligand.getAtoms()) {
-        for (const auto& atomP : protein.getAtoms()) {
-            float dx = atomL.x - atomP.x;
-            float dy = atomL.y - atomP.y;
-            float dz = atomL.z - atomP.z;
+    for (int r = 0; r < numRanges; ++r) {
+        evaluated += ends[r] - begins[r];
+        for (std::size_t k = begins[r]; k < ends[r]; ++k) {
+            float dx = x - px[k];
+            float dy = y - py[k];
+            float dz = z - pz[k];
             float r2 = dx * dx + dy * dy + dz * dz;
-            // Evitar división por cero o distancias extremadamente cortas
-            if (r2 < 1e-6f)
-                continue;
-            // Calcular r^6 y r^12
-            float r6 = r2 * r2 * r2;
-            float r12 = r6 * r6;
-            // Cálculo del potencial: 4 * epsilon * ((1 / r^12) - (1 / r^6))
-            float ljEnergy = 4.0f * epsilon * ((1.0f / r12) - (1.0f / r6));
-            energy += ljEnergy;
+            // Sin saltos dependientes de los datos para que el compilador pueda
+            // vectorizar: las parejas fuera de [LJ_MIN_R2, rc2) aportan 0.
+            bool inRange = (r2 < rc2) & (r2 >= LJ_MIN_R2);
+            float inv2 = inRange ? 1.0f / r2 : 0.0f;
+            float inv6 = inv2 * inv2 * inv2;
+            float d = rc2 - r2;
+            float s = (r2 > ron2) ? d * d * (rc2 + 2.0f * r2 - 3.0f * ron2) * invSwitchDenom : 1.0f;
+            energy += ljPairEnergy<LJ>(inv6, c12Row, c6Row, pe[k]) * s;
         }
     }
     return energy;
-}
\ No newline at end of file
+}
+
+template <class LJ>
+static float cutoffLigandEnergy(const CellList& cells, const SwitchConstants& sw, const Molecule& ligand,
+                                std::size_t& evaluated) {
+    const float* lx = ligand.getX();
+    const float* ly = ligand.getY();
+    const float* lz = ligand.getZ();
+    const uint8_t* le = ligand.getElements();
+
+    float energy = 0.0f;
+    for (std::size_t i = 0; i < ligand.getAtomCount(); ++i) {
+        energy += cutoffAtomEnergy<LJ>(cells, sw, lx[i], ly[i], lz[i], le[i], evaluated);
+    }
+    return energy;
+}
+
+float performDocking(const CellList& cells, const Molecule& ligand, const DockingParams& params,
+                     std::size_t* interactions) {
+    std::size_t evaluated = 0;
+    float energy = 0.0f;
+    if (!cells.empty() && !ligand.empty()) {
+        const SwitchConstants sw(params);
+        energy = params.forceField == FORCEFIELD_UFF ? cutoffLigandEnergy<UffLJ>(cells, sw, ligand, evaluated)
+                                                     : cutoffLigandEnergy<UniformLJ>(cells, sw, ligand, evaluated);
+    }
+    if (interactions != nullptr)
+        *interactions = evaluated;
+    return energy;
+}
+
+// Energía exacta de un átomo de prueba de tipo 'element' frente a la proteína (con o
+// sin corte). Suma a 'evaluated' las parejas calculadas.
+static inline float exactAtomEnergy(const Molecule& protein, const CellList* cells, const SwitchConstants& sw,
+                                    ForceField forceField, float x, float y, float z, uint8_t element,
+                                    std::size_t& evaluated) {
+    if (cells != nullptr) {
+        return forceField == FORCEFIELD_UFF ? cutoffAtomEnergy<UffLJ>(*cells, sw, x, y, z, element, evaluated)
+                                            : cutoffAtomEnergy<UniformLJ>(*cells, sw, x, y, z, element, evaluated);
+    }
+    evaluated += protein.getAtomCount();
+    const LJKernelFn kernel = getLJKernel(forceField);
+    return kernel(&x, &y, &z, &element, 1, protein.getX(), protein.getY(), protein.getZ(), protein.getElements(),
+                  protein.getAtomCount());
+}
+
+float performDocking(const GridMapSet& maps, const Molecule& protein, const CellList* cells,
+                     const Molecule& ligand, const DockingParams& params, std::size_t* interactions) {
+    if (interactions != nullptr)
+        *interactions = 0;
+    if (protein.empty() || ligand.empty()) {
+        return 0.0f;
+    }
+
+    const SwitchConstants sw(params);
+    const float* lx = ligand.getX();
+    const float* ly = ligand.getY();
+    const float* lz = ligand.getZ();
+    const uint8_t* le = ligand.getElements();
+
+    // Cada consulta a la rejilla cuenta como una interacción.
+    std::size_t evaluated = 0;
+    float energy = 0.0f;
+    for (std::size_t i = 0; i < ligand.getAtomCount(); ++i) {
+        float atomEnergy;
+        if (maps.interpolate(le[i], lx[i], ly[i], lz[i], atomEnergy))
+            evaluated++;
+        else
+            atomEnergy = exactAtomEnergy(protein, cells, sw, params.forceField, lx[i], ly[i], lz[i], le[i], evaluated);
+        energy += atomEnergy;
+    }
+    if (interactions != nullptr)
+        *interactions = evaluated;
+    return energy;
+}
+
+// Rellena cada mapa evaluando un átomo de prueba en todos los puntos de la rejilla; el
+// átomo de prueba de cada clase es el primer elemento asignado a ella. Después marca la
+// zona de cálculo exacto alrededor de cada átomo de la proteína (ver GRID_EXACT_SIGMAS).
+// Los planos (z, y) se reparten entre hilos OpenMP.
+static void buildGridMaps(GridMapSet& maps, const Molecule& protein, const CellList* cells,
+                          const DockingParams& params) {
+    const SwitchConstants sw(params);
+    const int dimX = maps.getDimX();
+    const int dimY = maps.getDimY();
+    const int dimZ = maps.getDimZ();
+    const float* px = protein.getX();
+    const float* py = protein.getY();
+    const float* pz = protein.getZ();
+    const uint8_t* pe = protein.getElements();
+    std::vector<uint8_t> classElement(maps.getNumClasses(), ELEMENT_UNKNOWN);
+    for (int e = NUM_ELEMENT_TYPES - 1; e >= 0; --e) {
+        const int mapClass = maps.classForElement(static_cast<uint8_t>(e));
+        if (mapClass >= 0)
+            classElement[mapClass] = static_cast<uint8_t>(e);
+    }
+    for (int mapClass = 0; mapClass < maps.getNumClasses(); ++mapClass) {
+        float* data = maps.mapData(mapClass);
+        const uint8_t element = classElement[mapClass];
+        #ifdef _OPENMP
+        #pragma omp parallel for collapse(2) schedule(dynamic)
+        #endif
+        for (int iz = 0; iz < dimZ; ++iz) {
+            for (int iy = 0; iy < dimY; ++iy) {
+                float* row = data + (static_cast<std::size_t>(iz) * dimY + iy) * dimX;
+                const float y = maps.pointY(iy);
+                const float z = maps.pointZ(iz);
+                std::size_t evaluated = 0;
+                for (int ix = 0; ix < dimX; ++ix) {
+                    float e = exactAtomEnergy(protein, cells, sw, params.forceField, maps.pointX(ix), y, z, element,
+                                              evaluated);
+                    row[ix] = std::min(e, GRID_ENERGY_CAP);
+                }
+            }
+        }
+
+        float radius[NUM_ELEMENT_TYPES];
+        for (int e = 0; e < NUM_ELEMENT_TYPES; ++e)
+            radius[e] = GRID_EXACT_SIGMAS * pairSigma(params.forceField, element, static_cast<uint8_t>(e)) +
+                        2.0f * maps.getSpacing();
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for (int iz = 0; iz < dimZ; ++iz) {
+            for (std::size_t k = 0; k < protein.getAtomCount(); ++k)
+                maps.markExact(mapClass, iz, px[k], py[k], pz[k], radius[pe[k]]);
+        }
+    }
+}
+
+// Amplía la caja [boxMin, boxMax] con los átomos de 'mol'. 'any' indica si la caja ya
+// contiene algún punto.
+static void extendBox(const Molecule& mol, float boxMin[3], float boxMax[3], bool& any) {
+    const float* coords[3] = { mol.getX(), mol.getY(), mol.getZ() };
+    for (std::size_t k = 0; k < mol.getAtomCount(); ++k) {
+        for (int d = 0; d < 3; ++d) {
+            float v = coords[d][k];
+            boxMin[d] = any ? std::min(boxMin[d], v) : v;
+            boxMax[d] = any ? std::max(boxMax[d], v) : v;
+        }
+        any = true;
+    }
+}
+
+// Error de 'approximate' frente a 'exact' sobre 'maxSamples' pares equiespaciados de la
+// matriz completa (determinista, igual en todos los procesos).
+template <class Approximate, class Exact>
+static ApproximationError sampleApproximationError(std::size_t numProteins, const std::vector<Molecule>& ligands,
+                                                   std::size_t maxSamples, Approximate approximate, Exact exact) {
+    const std::size_t numLigands = ligands.size();
+    const std::size_t numPairs = numProteins * numLigands;
+    const std::size_t numSamples = std::min(numPairs, maxSamples);
+    std::vector<double> errors(numSamples), relative(numSamples);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (std::size_t s = 0; s < numSamples; ++s) {
+        const std::size_t pair = s * numPairs / numSamples;
+        const std::size_t i = pair / numLigands;
+        const Molecule& ligand = ligands[pair % numLigands];
+        const double reference = exact(i, ligand);
+        errors[s] = std::fabs(approximate(i, ligand) - reference);
+        relative[s] = reference != 0.0 ? errors[s] / std::fabs(reference) : 0.0;
+    }
+    ApproximationError error;
+    error.samples = numSamples;
+    for (std::size_t s = 0; s < numSamples; ++s) {
+        error.meanRel += relative[s] / numSamples;
+        error.maxAbs = std::max(error.maxAbs, errors[s]);
+        error.maxRel = std::max(error.maxRel, relative[s]);
+    }
+    return error;
+}
+
+DockingScorer::DockingScorer(const std::vector<Molecule>& proteins, const DockingParams& params)
+    : proteins(proteins), params(params), knownLigands(nullptr), gridMapsFromCache(0) {
+    prepare(nullptr);
+}
+
+DockingScorer::DockingScorer(const std::vector<Molecule>& proteins, const DockingParams& params,
+                             const std::vector<Molecule>& ligands)
+    : proteins(proteins), params(params), knownLigands(nullptr), gridMapsFromCache(0) {
+    prepare(&ligands);
+}
+
+void DockingScorer::prepare(const std::vector<Molecule>* ligands) {
+    ScopedPhase phase(PHASE_FLATTEN);
+    knownLigands = ligands;
+    if (params.useCutoff()) {
+        // Una lista de celdas por proteína, reutilizada para todos los ligandos.
+        cellLists.resize(proteins.size());
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for (std::size_t i = 0; i < proteins.size(); ++i) {
+            cellLists[i].build(proteins[i], params.cutoff);
+        }
+    }
+    if (params.grid.enabled)
+        prepareGridMaps(ligands);
+    if (params.funnel.enabled())
+        prepareFunnel(ligands);
+    if (params.octree.enabled)
+        prepareOctrees(ligands);
+    if (!params.scoreCacheDir.empty())
+        prepareScoreCache(ligands);
+}
+
+void DockingScorer::prepareGridMaps(const std::vector<Molecule>* ligands) {
+    const GridMapParams& grid = params.grid;
+
+    // Con parámetros LJ uniformes todos los tipos de átomo del ligando comparten el mismo
+    // potencial, así que basta una única clase. Con parámetros por elemento hay un mapa por
+    // cada elemento presente en los ligandos (o por cada elemento si no se conocen).
+    std::vector<int> elementClass(NUM_ELEMENT_TYPES, 0);
+    int numClasses = 1;
+    if (params.forceField != FORCEFIELD_UNIFORM) {
+        std::vector<bool> present(NUM_ELEMENT_TYPES, ligands == nullptr);
+        if (ligands != nullptr) {
+            for (const Molecule& ligand : *ligands) {
+                const uint8_t* le = ligand.getElements();
+                for (std::size_t k = 0; k < ligand.getAtomCount(); ++k)
+                    present[le[k]] = true;
+            }
+        }
+        numClasses = 0;
+        for (int e = 0; e < NUM_ELEMENT_TYPES; ++e)
+            elementClass[e] = present[e] ? numClasses++ : -1;
+    }
+
+    // Todas las proteínas comparten la caja indicada; sin ella, cada una usa la suya más un
+    // margen, así que las rejillas no dependen de los ligandos.
+    const float margin = params.useCutoff() ? params.cutoff : GRID_BOX_MARGIN_SIGMAS * maxPairSigma(params.forceField);
+    gridMaps.resize(proteins.size());
+    for (std::size_t i = 0; i < proteins.size(); ++i) {
+        float boxMin[3] = { 0.0f, 0.0f, 0.0f };
+        float boxMax[3] = { 0.0f, 0.0f, 0.0f };
+        if (grid.hasBox) {
+            std::copy(grid.boxMin, grid.boxMin + 3, boxMin);
+            std::copy(grid.boxMax, grid.boxMax + 3, boxMax);
+        } else {
+            bool any = false;
+            extendBox(proteins[i], boxMin, boxMax, any);
+            for (int d = 0; d < 3; ++d) {
+                boxMin[d] -= margin;
+                boxMax[d] += margin;
+            }
+        }
+
+        // Sin --grid-spacing, la separación por defecto salvo que la caja supere el máximo
+        // de puntos; entonces crece hasta ajustarse.
+        float spacing = grid.spacing;
+        if (spacing <= 0.0f) {
+            double volume = 1.0;
+            for (int d = 0; d < 3; ++d)
+                volume *= std::max(0.0f, boxMax[d] - boxMin[d]);
+            spacing = std::max(defaultGridSpacing(params.forceField),
+                               static_cast<float>(std::cbrt(volume / GRID_MAX_DEFAULT_POINTS)));
+        }
+
+        GridMapSet& maps = gridMaps[i];
+        maps.setGeometry(boxMin, boxMax, spacing);
+
+        // La clave de caché identifica la proteína, la geometría y el potencial.
+        std::string cacheFile;
+        uint64_t key = 0;
+        if (!grid.cacheDir.empty()) {
+            key = proteins[i].contentHash();
+            key = hashBytes(boxMin, sizeof(boxMin), key);
+            key = hashBytes(boxMax, sizeof(boxMax), key);
+            key = hashValue(spacing, key);
+            key = hashValue(params.cutoff, key);
+            key = hashValue(params.effectiveSwitchDistance(), key);
+            key = hashBytes(elementClass.data(), elementClass.size() * sizeof(int), key);
+            if (params.forceField != FORCEFIELD_UNIFORM)
+                key = hashValue(static_cast<uint32_t>(params.forceField), key);
+            char name[64];
+            std::snprintf(name, sizeof(name), "/grid_%016llx.map", static_cast<unsigned long long>(key));
+            cacheFile = grid.cacheDir + name;
+            if (maps.load(cacheFile, key)) {
+                gridMapsFromCache++;
+                continue;
+            }
+        }
+
+        maps.allocate(elementClass, numClasses);
+        buildGridMaps(maps, proteins[i], params.useCutoff() ? &cellLists[i] : nullptr, params);
+        if (!cacheFile.empty() && !maps.save(cacheFile, key))
+            std::cerr << "No se pudo escribir la caché de rejillas: " << cacheFile << std::endl;
+    }
+    if (ligands == nullptr || ligands->empty() || proteins.empty())
+        return;
+
+    approximationError = sampleApproximationError(
+        proteins.size(), *ligands, GRID_ERROR_SAMPLES,
+        [this](std::size_t i, const Molecule& ligand) -> double {
+            const CellList* cells = params.useCutoff() ? &cellLists[i] : nullptr;
+            return performDocking(gridMaps[i], proteins[i], cells, ligand, params);
+        },
+        [this](std::size_t i, const Molecule& ligand) -> double {
+            return params.useCutoff() ? performDocking(cellLists[i], ligand, params)
+                                      : performDocking(proteins[i], ligand, params.forceField);
+        });
+}
+
+void DockingScorer::prepareFunnel(const std::vector<Molecule>* ligands) {
+    const FunnelParams& funnel = params.funnel;
+    coarseProteins.build(proteins, funnel.clusterSize, params.forceField);
+    if (ligands != nullptr)
+        coarseLigands.build(*ligands, funnel.clusterSize, params.forceField);
+    funnelCutoff.assign(proteins.size(),
+                        funnel.useThreshold ? funnel.threshold : std::numeric_limits<float>::infinity());
+    if (funnel.keepFraction <= 0.0f || funnel.keepFraction >= 1.0f || ligands == nullptr || ligands->empty())
+        return;
+
+    // Corte de la fracción conservada: el percentil de las estimaciones de una muestra
+    // equiespaciada de ligandos (todos si hay pocos). Es determinista, así que todos los
+    // procesos obtienen el mismo corte sin comunicarse.
+    const std::size_t numLigands = ligands->size();
+    const std::size_t numSamples = std::min(numLigands, FUNNEL_SAMPLE_LIGANDS);
+    const std::size_t keep = std::max<std::size_t>(
+        1, std::min(numSamples, static_cast<std::size_t>(std::ceil(funnel.keepFraction * numSamples))));
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (std::size_t i = 0; i < proteins.size(); ++i) {
+        std::vector<float> estimates(numSamples);
+        for (std::size_t s = 0; s < numSamples; ++s)
+            estimates[s] = CoarseModels::energy(coarseProteins, i, coarseLigands, s * numLigands / numSamples);
+        std::nth_element(estimates.begin(), estimates.begin() + (keep - 1), estimates.end());
+        funnelCutoff[i] = std::min(funnelCutoff[i], estimates[keep - 1]);
+    }
+}
+
+// Posición de 'ligand' en knownLigands, o NO_KNOWN_LIGAND si no es uno de ellos.
+static const std::size_t NO_KNOWN_LIGAND = std::numeric_limits<std::size_t>::max();
+
+std::size_t DockingScorer::knownLigandIndex(const Molecule& ligand) const {
+    const std::less<const Molecule*> before;
+    if (knownLigands != nullptr && !knownLigands->empty() && !before(&ligand, knownLigands->data()) &&
+        before(&ligand, knownLigands->data() + knownLigands->size()))
+        return static_cast<std::size_t>(&ligand - knownLigands->data());
+    return NO_KNOWN_LIGAND;
+}
+
+bool DockingScorer::passesFunnel(std::size_t proteinIndex, const CoarseModels& ligands,
+                                 std::size_t ligandIndex) const {
+    addMetricCounter(COUNTER_COARSE_PAIRS, 1);
+    return CoarseModels::energy(coarseProteins, proteinIndex, ligands, ligandIndex) <= funnelCutoff[proteinIndex];
+}
+
+void DockingScorer::prepareOctrees(const std::vector<Molecule>* ligands) {
+    octrees.resize(proteins.size());
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (std::size_t i = 0; i < proteins.size(); ++i) {
+        octrees[i].build(proteins[i], params.forceField);
+    }
+    if (ligands == nullptr || ligands->empty() || proteins.empty())
+        return;
+
+    approximationError = sampleApproximationError(
+        proteins.size(), *ligands, OCTREE_ERROR_SAMPLES,
+        [this](std::size_t i, const Molecule& ligand) -> double {
+            return octrees[i].energy(ligand, params.octree.theta);
+        },
+        [this](std::size_t i, const Molecule& ligand) -> double {
+            return performDocking(proteins[i], ligand, params.forceField);
+        });
+}
+
+// La clave de un par combina la de la proteína (su contenido y todo lo que afecta a su
+// score: parámetros, motor y geometría de las rejillas) con el hash del ligando. El embudo
+// no cambia el score de los pares que pasan, así que no forma parte de la clave.
+void DockingScorer::prepareScoreCache(const std::vector<Molecule>* ligands) {
+    if (!scoreCache.open(params.scoreCacheDir)) {
+        std::cerr << "No se pudo abrir la caché de scores: " << params.scoreCacheDir << std::endl;
+        return;
+    }
+    uint64_t paramsKey = hashValue(params.cutoff);
+    paramsKey = hashValue(params.effectiveSwitchDistance(), paramsKey);
+    paramsKey = hashValue(static_cast<uint32_t>(params.forceField), paramsKey);
+    paramsKey = hashValue(params.grid.enabled, paramsKey);
+    paramsKey = hashValue(params.octree.enabled ? params.octree.theta : -1.0f, paramsKey);
+
+    proteinCacheKeys.resize(proteins.size());
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for (std::size_t i = 0; i < proteins.size(); ++i) {
+        uint64_t key = hashValue(proteins[i].contentHash(), paramsKey);
+        if (params.grid.enabled) {
+            const GridMapSet& maps = gridMaps[i];
+            const float geometry[4] = { maps.pointX(0), maps.pointY(0), maps.pointZ(0), maps.getSpacing() };
+            const int dims[3] = { maps.getDimX(), maps.getDimY(), maps.getDimZ() };
+            key = hashBytes(geometry, sizeof(geometry), key);
+            key = hashBytes(dims, sizeof(dims), key);
+        }
+        proteinCacheKeys[i] = key;
+    }
+    if (ligands != nullptr) {
+        ligandHashes.resize(ligands->size());
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 256)
+        #endif
+        for (std::size_t j = 0; j < ligands->size(); ++j)
+            ligandHashes[j] = (*ligands)[j].contentHash();
+    }
+}
+
+std::size_t DockingScorer::getOctreeNodeCount() const {
+    std::size_t count = 0;
+    for (const ProteinOctree& octree : octrees)
+        count += octree.getNodeCount();
+    return count;
+}
+
+std::size_t DockingScorer::getOctreeBytes() const {
+    std::size_t bytes = 0;
+    for (const ProteinOctree& octree : octrees)
+        bytes += octree.getBytes();
+    return bytes;
+}
+
+std::size_t DockingScorer::getGridPointCount() const {
+    std::size_t count = 0;
+    for (const GridMapSet& maps : gridMaps)
+        count += maps.getPointCount() * maps.getNumClasses();
+    return count;
+}
+
+std::size_t DockingScorer::getGridBytes() const {
+    std::size_t bytes = 0;
+    for (const GridMapSet& maps : gridMaps)
+        bytes += maps.getBytes();
+    return bytes;
+}
+
+float DockingScorer::getGridMaxSpacing() const {
+    float spacing = 0.0f;
+    for (const GridMapSet& maps : gridMaps)
+        spacing = std::max(spacing, maps.getSpacing());
+    return spacing;
+}
+
+float DockingScorer::score(std::size_t proteinIndex, const Molecule& ligand) const {
+    const std::size_t known = knownLigandIndex(ligand);
+    if (params.funnel.enabled()) {
+        bool passes;
+        if (known != NO_KNOWN_LIGAND) {
+            passes = passesFunnel(proteinIndex, coarseLigands, known);
+        } else {
+            static thread_local CoarseModels single;
+            single.build(ligand, params.funnel.clusterSize, params.forceField);
+            passes = passesFunnel(proteinIndex, single, 0);
+        }
+        if (!passes)
+            return FUNNEL_REJECTED;
+    }
+    if (!scoreCache.isOpen())
+        return computeScore(proteinIndex, ligand);
+    return cachedScore(proteinIndex, ligand, known != NO_KNOWN_LIGAND ? ligandHashes[known] : ligand.contentHash());
+}
+
+void DockingScorer::prepareBatch(const std::vector<Molecule>& ligands, LigandBatch& batch) const {
+    batch.ligands = &ligands;
+    if (params.funnel.enabled())
+        batch.coarse.build(ligands, params.funnel.clusterSize, params.forceField);
+    batch.hashes.clear();
+    if (scoreCache.isOpen()) {
+        batch.hashes.reserve(ligands.size());
+        for (const Molecule& ligand : ligands)
+            batch.hashes.push_back(ligand.contentHash());
+    }
+}
+
+float DockingScorer::score(std::size_t proteinIndex, const LigandBatch& batch, std::size_t ligandIndex) const {
+    const Molecule& ligand = (*batch.ligands)[ligandIndex];
+    if (params.funnel.enabled() && !passesFunnel(proteinIndex, batch.coarse, ligandIndex))
+        return FUNNEL_REJECTED;
+    if (!scoreCache.isOpen())
+        return computeScore(proteinIndex, ligand);
+    return cachedScore(proteinIndex, ligand, batch.hashes[ligandIndex]);
+}
+
+float DockingScorer::cachedScore(std::size_t proteinIndex, const Molecule& ligand, uint64_t ligandHash) const {
+    addMetricCounter(COUNTER_CACHE_LOOKUPS, 1);
+    uint64_t key = hashValue(ligandHash, proteinCacheKeys[proteinIndex]);
+    key = key != 0 ? key : 1;    // 0 marca los huecos libres de la tabla
+    float cached;
+    if (scoreCache.lookup(key, cached)) {
+        addMetricCounter(COUNTER_CACHE_HITS, 1);
+        return cached;
+    }
+    const float result = computeScore(proteinIndex, ligand);
+    scoreCache.insert(key, result);
+    return result;
+}
+
+float DockingScorer::computeScore(std::size_t proteinIndex, const Molecule& ligand) const {
+    // Las interacciones son las parejas (o consultas a la rejilla) que se calculan de
+    // verdad; las equivalentes, las del cálculo completo sin corte ni aproximaciones.
+    const std::size_t allPairs = proteins[proteinIndex].getAtomCount() * ligand.getAtomCount();
+    std::size_t interactions = allPairs;
+    const CellList* cells = params.useCutoff() ? &cellLists[proteinIndex] : nullptr;
+    float score;
+    if (params.grid.enabled)
+        score = performDocking(gridMaps[proteinIndex], proteins[proteinIndex], cells, ligand, params, &interactions);
+    else if (cells != nullptr)
+        score = performDocking(*cells, ligand, params, &interactions);
+    else if (params.octree.enabled)
+        score = octrees[proteinIndex].energy(ligand, params.octree.theta, &interactions);
+    else
+        score = performDocking(proteins[proteinIndex], ligand, params.forceField);
+    addMetricCounter(COUNTER_PAIRS, 1);
+    addMetricCounter(COUNTER_INTERACTIONS, interactions);
+    addMetricCounter(COUNTER_EQUIVALENT_INTERACTIONS, allPairs);
+    return score;
+}
+
+void DockingScorer::scoreBatch(std::size_t proteinIndex, const std::vector<Molecule>& ligands,
+                               std::size_t first, std::size_t last, std::size_t proteinBlock,
+                               float* out) const {
+    const Molecule& protein = proteins[proteinIndex];
+    // Con corte, rejillas u octree el acceso ya es local (celdas vecinas, interpolación o
+    // hojas cercanas); con embudo o caché cada par pasa antes por la etapa gruesa o por la
+    // tabla de scores.
+    if (params.useCutoff() || params.grid.enabled || params.octree.enabled || params.funnel.enabled() ||
+        scoreCache.isOpen() || proteinBlock == 0) {
+        for (std::size_t j = first; j < last; ++j)
+            out[j - first] = score(proteinIndex, ligands[j]);
+        return;
+    }
+
+    const LJKernelFn kernel = getLJKernel(params.forceField);
+    const std::size_t numAtoms = protein.getAtomCount();
+    std::size_t ligandAtoms = 0;
+    for (std::size_t j = first; j < last; ++j) {
+        out[j - first] = 0.0f;
+        ligandAtoms += ligands[j].getAtomCount();
+    }
+    addMetricCounter(COUNTER_PAIRS, last - first);
+    addMetricCounter(COUNTER_INTERACTIONS, numAtoms * ligandAtoms);
+    addMetricCounter(COUNTER_EQUIVALENT_INTERACTIONS, numAtoms * ligandAtoms);
+    for (std::size_t block = 0; block < numAtoms; block += proteinBlock) {
+        const std::size_t count = std::min(proteinBlock, numAtoms - block);
+        const float* px = protein.getX() + block;
+        const float* py = protein.getY() + block;
+        const float* pz = protein.getZ() + block;
+        const uint8_t* pe = protein.getElements() + block;
+        for (std::size_t j = first; j < last; ++j) {
+            const Molecule& ligand = ligands[j];
+            out[j - first] += kernel(ligand.getX(), ligand.getY(), ligand.getZ(), ligand.getElements(),
+                                     ligand.getAtomCount(), px, py, pz, pe, count);
+        }
+    }
+}
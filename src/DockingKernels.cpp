@@ -0,0 +1,374 @@
+#include "DockingKernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DOCKING_X86 1
+#include <immintrin.h>
+#endif
+
+#define LJ_KERNEL_PARAMS const float* lx, const float* ly, const float* lz, const uint8_t* le, \
+    std::size_t numLigandAtoms, const float* px, const float* py, const float* pz, const uint8_t* pe, \
+    std::size_t numProteinAtoms
+
+// Kernel escalar de referencia (con UniformLJ, el mismo cálculo que la versión original
+// de performDocking).
+template <class LJ>
+static float ljKernelScalar(LJ_KERNEL_PARAMS) {
+    const LJPairTable& table = LJ::table();
+    float energy = 0.0f;
+    for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+        const float x = lx[i];
+        const float y = ly[i];
+        const float z = lz[i];
+        const uint8_t type = LJ::PER_ELEMENT ? le[i] : 0;
+        const float* c12Row = table.c12[type];
+        const float* c6Row = table.c6[type];
+        for (std::size_t k = 0; k < numProteinAtoms; ++k) {
+            float dx = x - px[k];
+            float dy = y - py[k];
+            float dz = z - pz[k];
+            float r2 = dx * dx + dy * dy + dz * dz;
+            // Evitar división por cero o distancias extremadamente cortas
+            if (r2 < LJ_MIN_R2)
+                continue;
+            float r6 = r2 * r2 * r2;
+            if (LJ::PER_ELEMENT) {
+                float inv6 = 1.0f / r6;
+                energy += ljPairEnergy<LJ>(inv6, c12Row, c6Row, pe[k]);
+            } else {
+                float r12 = r6 * r6;
+                energy += 4.0f * ((1.0f / r12) - (1.0f / r6));
+            }
+        }
+    }
+    return energy;
+}
+
+#ifdef DOCKING_X86
+
+// En todas las variantes vectoriales las parejas con r2 < LJ_MIN_R2 se descartan con una
+// máscara (en lugar del 'continue' escalar): se sustituye r2 por 1 antes de dividir para
+// no generar inf/NaN y el término se anula con la máscara.
+// Con parámetros por elemento, los coeficientes c12/c6 de cada átomo de la proteína se
+// toman de la fila del átomo del ligando; con UniformLJ esas consultas desaparecen en
+// compilación y el término es el de siempre.
+
+//-----------------------------------------------------------------------------
+// SSE (4 átomos de proteína por instrucción). SSE2 forma parte de x86-64, por lo que
+// esta variante siempre está disponible en estas arquitecturas.
+template <class LJ>
+static inline __m128 ljTermSSE(__m128 x, __m128 y, __m128 z, __m128 px, __m128 py, __m128 pz,
+                               __m128 c12, __m128 c6) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 dx = _mm_sub_ps(x, px);
+    __m128 dy = _mm_sub_ps(y, py);
+    __m128 dz = _mm_sub_ps(z, pz);
+    __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    __m128 valid = _mm_cmpge_ps(r2, _mm_set1_ps(LJ_MIN_R2));
+    r2 = _mm_or_ps(_mm_and_ps(valid, r2), _mm_andnot_ps(valid, one));
+    __m128 inv2 = _mm_div_ps(one, r2);
+    __m128 inv6 = _mm_mul_ps(_mm_mul_ps(inv2, inv2), inv2);
+    __m128 e = LJ::PER_ELEMENT ? _mm_mul_ps(inv6, _mm_sub_ps(_mm_mul_ps(c12, inv6), c6))
+                               : _mm_mul_ps(_mm_set1_ps(4.0f), _mm_sub_ps(_mm_mul_ps(inv6, inv6), inv6));
+    return _mm_and_ps(e, valid);
+}
+
+// Coeficientes de 4 átomos consecutivos (SSE no tiene permutaciones variables de floats).
+static inline __m128 rowLookupSSE(const float* row, const uint8_t* types) {
+    return _mm_setr_ps(row[types[0]], row[types[1]], row[types[2]], row[types[3]]);
+}
+
+template <class LJ>
+static float ljKernelSSE(LJ_KERNEL_PARAMS) {
+    const std::size_t vecEnd = numProteinAtoms & ~static_cast<std::size_t>(3);
+    const std::size_t rem = numProteinAtoms - vecEnd;
+    const LJPairTable& table = LJ::table();
+
+    // Cola: se copia a un bloque de 4 y se enmascaran las posiciones no válidas.
+    alignas(16) float tailX[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    alignas(16) float tailY[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    alignas(16) float tailZ[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    uint8_t tailE[4] = {0, 0, 0, 0};
+    for (std::size_t k = 0; k < rem; ++k) {
+        tailX[k] = px[vecEnd + k];
+        tailY[k] = py[vecEnd + k];
+        tailZ[k] = pz[vecEnd + k];
+        if (LJ::PER_ELEMENT)
+            tailE[k] = pe[vecEnd + k];
+    }
+    const __m128 tailMask = _mm_castsi128_ps(
+        _mm_cmpgt_epi32(_mm_set1_epi32(static_cast<int>(rem)), _mm_setr_epi32(0, 1, 2, 3)));
+
+    __m128 acc = _mm_setzero_ps();
+    __m128 c12 = _mm_setzero_ps();
+    __m128 c6 = _mm_setzero_ps();
+    for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+        const __m128 x = _mm_set1_ps(lx[i]);
+        const __m128 y = _mm_set1_ps(ly[i]);
+        const __m128 z = _mm_set1_ps(lz[i]);
+        const uint8_t type = LJ::PER_ELEMENT ? le[i] : 0;
+        const float* c12Row = table.c12[type];
+        const float* c6Row = table.c6[type];
+        for (std::size_t k = 0; k < vecEnd; k += 4) {
+            if (LJ::PER_ELEMENT) {
+                c12 = rowLookupSSE(c12Row, pe + k);
+                c6 = rowLookupSSE(c6Row, pe + k);
+            }
+            acc = _mm_add_ps(acc, ljTermSSE<LJ>(x, y, z, _mm_loadu_ps(px + k), _mm_loadu_ps(py + k),
+                                                _mm_loadu_ps(pz + k), c12, c6));
+        }
+        if (rem) {
+            if (LJ::PER_ELEMENT) {
+                c12 = rowLookupSSE(c12Row, tailE);
+                c6 = rowLookupSSE(c6Row, tailE);
+            }
+            __m128 e = ljTermSSE<LJ>(x, y, z, _mm_load_ps(tailX), _mm_load_ps(tailY), _mm_load_ps(tailZ), c12, c6);
+            acc = _mm_add_ps(acc, _mm_and_ps(e, tailMask));
+        }
+    }
+
+    // Reducción horizontal.
+    __m128 shuf = _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(acc, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+//-----------------------------------------------------------------------------
+// AVX2 + FMA (8 átomos de proteína por instrucción).
+template <class LJ>
+__attribute__((target("avx2,fma")))
+static inline __m256 ljTermAVX2(__m256 x, __m256 y, __m256 z, __m256 px, __m256 py, __m256 pz,
+                                __m256 c12, __m256 c6) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 dx = _mm256_sub_ps(x, px);
+    __m256 dy = _mm256_sub_ps(y, py);
+    __m256 dz = _mm256_sub_ps(z, pz);
+    __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+    __m256 valid = _mm256_cmp_ps(r2, _mm256_set1_ps(LJ_MIN_R2), _CMP_GE_OQ);
+    r2 = _mm256_blendv_ps(one, r2, valid);
+    __m256 inv2 = _mm256_div_ps(one, r2);
+    __m256 inv6 = _mm256_mul_ps(_mm256_mul_ps(inv2, inv2), inv2);
+    __m256 e = LJ::PER_ELEMENT ? _mm256_mul_ps(inv6, _mm256_fmsub_ps(c12, inv6, c6))
+                               : _mm256_mul_ps(_mm256_set1_ps(4.0f), _mm256_fmsub_ps(inv6, inv6, inv6));
+    return _mm256_and_ps(e, valid);
+}
+
+// Códigos de elemento de 8 átomos consecutivos, ampliados a enteros de 32 bits.
+__attribute__((target("avx2")))
+static inline __m256i loadTypesAVX2(const uint8_t* types) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(types)));
+}
+
+// Consulta de una fila de 16 floats (mitades 'lo' y 'hi') con dos permutaciones: el
+// bit 3 del índice, llevado al bit de signo, elige la mitad.
+__attribute__((target("avx2")))
+static inline __m256 rowLookupAVX2(__m256 lo, __m256 hi, __m256i types) {
+    return _mm256_blendv_ps(_mm256_permutevar8x32_ps(lo, types), _mm256_permutevar8x32_ps(hi, types),
+                            _mm256_castsi256_ps(_mm256_slli_epi32(types, 28)));
+}
+
+template <class LJ>
+__attribute__((target("avx2,fma")))
+static float ljKernelAVX2(LJ_KERNEL_PARAMS) {
+    const std::size_t vecEnd = numProteinAtoms & ~static_cast<std::size_t>(7);
+    const std::size_t rem = numProteinAtoms - vecEnd;
+    const __m256i tailMask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(rem)),
+                                                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const LJPairTable& table = LJ::table();
+    alignas(8) uint8_t tailE[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    if (LJ::PER_ELEMENT) {
+        for (std::size_t k = 0; k < rem; ++k)
+            tailE[k] = pe[vecEnd + k];
+    }
+
+    __m256 acc = _mm256_setzero_ps();
+    __m256 c12 = _mm256_setzero_ps();
+    __m256 c6 = _mm256_setzero_ps();
+    for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+        const __m256 x = _mm256_set1_ps(lx[i]);
+        const __m256 y = _mm256_set1_ps(ly[i]);
+        const __m256 z = _mm256_set1_ps(lz[i]);
+        const uint8_t type = LJ::PER_ELEMENT ? le[i] : 0;
+        const __m256 c12Lo = _mm256_load_ps(table.c12[type]);
+        const __m256 c12Hi = _mm256_load_ps(table.c12[type] + 8);
+        const __m256 c6Lo = _mm256_load_ps(table.c6[type]);
+        const __m256 c6Hi = _mm256_load_ps(table.c6[type] + 8);
+        for (std::size_t k = 0; k < vecEnd; k += 8) {
+            if (LJ::PER_ELEMENT) {
+                const __m256i types = loadTypesAVX2(pe + k);
+                c12 = rowLookupAVX2(c12Lo, c12Hi, types);
+                c6 = rowLookupAVX2(c6Lo, c6Hi, types);
+            }
+            acc = _mm256_add_ps(acc, ljTermAVX2<LJ>(x, y, z, _mm256_loadu_ps(px + k), _mm256_loadu_ps(py + k),
+                                                    _mm256_loadu_ps(pz + k), c12, c6));
+        }
+        if (rem) {
+            if (LJ::PER_ELEMENT) {
+                const __m256i types = loadTypesAVX2(tailE);
+                c12 = rowLookupAVX2(c12Lo, c12Hi, types);
+                c6 = rowLookupAVX2(c6Lo, c6Hi, types);
+            }
+            __m256 e = ljTermAVX2<LJ>(x, y, z, _mm256_maskload_ps(px + vecEnd, tailMask),
+                                      _mm256_maskload_ps(py + vecEnd, tailMask),
+                                      _mm256_maskload_ps(pz + vecEnd, tailMask), c12, c6);
+            acc = _mm256_add_ps(acc, _mm256_and_ps(e, _mm256_castsi256_ps(tailMask)));
+        }
+    }
+
+    // Reducción horizontal: 8 -> 4 -> 1.
+    __m128 sums = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+    sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 1));
+    return _mm_cvtss_f32(sums);
+}
+
+//-----------------------------------------------------------------------------
+// AVX-512 (16 átomos de proteína por instrucción, cola con máscaras de predicado).
+// Una fila de la tabla ocupa un registro: la consulta es una sola permutación.
+template <class LJ>
+__attribute__((target("avx512f")))
+static inline __m512 ljTermAVX512(__m512 x, __m512 y, __m512 z, __m512 px, __m512 py, __m512 pz,
+                                  __m512 c12, __m512 c6, __mmask16 lanes) {
+    const __m512 one = _mm512_set1_ps(1.0f);
+    __m512 dx = _mm512_sub_ps(x, px);
+    __m512 dy = _mm512_sub_ps(y, py);
+    __m512 dz = _mm512_sub_ps(z, pz);
+    __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+    __mmask16 valid = _mm512_mask_cmp_ps_mask(lanes, r2, _mm512_set1_ps(LJ_MIN_R2), _CMP_GE_OQ);
+    __m512 inv2 = _mm512_mask_div_ps(one, valid, one, r2);
+    __m512 inv6 = _mm512_mul_ps(_mm512_mul_ps(inv2, inv2), inv2);
+    if (LJ::PER_ELEMENT)
+        return _mm512_maskz_mul_ps(valid, inv6, _mm512_fmsub_ps(c12, inv6, c6));
+    return _mm512_maskz_mul_ps(valid, _mm512_set1_ps(4.0f), _mm512_fmsub_ps(inv6, inv6, inv6));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i loadTypesAVX512(const uint8_t* types) {
+    return _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(types)));
+}
+
+template <class LJ>
+__attribute__((target("avx512f")))
+static float ljKernelAVX512(LJ_KERNEL_PARAMS) {
+    const std::size_t vecEnd = numProteinAtoms & ~static_cast<std::size_t>(15);
+    const std::size_t rem = numProteinAtoms - vecEnd;
+    const __mmask16 allLanes = static_cast<__mmask16>(0xFFFF);
+    const __mmask16 tailLanes = static_cast<__mmask16>((1u << rem) - 1u);
+    const LJPairTable& table = LJ::table();
+    alignas(16) uint8_t tailE[16] = {0};
+    if (LJ::PER_ELEMENT) {
+        for (std::size_t k = 0; k < rem; ++k)
+            tailE[k] = pe[vecEnd + k];
+    }
+
+    __m512 acc = _mm512_setzero_ps();
+    __m512 c12 = _mm512_setzero_ps();
+    __m512 c6 = _mm512_setzero_ps();
+    for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+        const __m512 x = _mm512_set1_ps(lx[i]);
+        const __m512 y = _mm512_set1_ps(ly[i]);
+        const __m512 z = _mm512_set1_ps(lz[i]);
+        const uint8_t type = LJ::PER_ELEMENT ? le[i] : 0;
+        const __m512 c12Row = _mm512_load_ps(table.c12[type]);
+        const __m512 c6Row = _mm512_load_ps(table.c6[type]);
+        for (std::size_t k = 0; k < vecEnd; k += 16) {
+            if (LJ::PER_ELEMENT) {
+                const __m512i types = loadTypesAVX512(pe + k);
+                c12 = _mm512_permutexvar_ps(types, c12Row);
+                c6 = _mm512_permutexvar_ps(types, c6Row);
+            }
+            acc = _mm512_add_ps(acc, ljTermAVX512<LJ>(x, y, z, _mm512_loadu_ps(px + k), _mm512_loadu_ps(py + k),
+                                                      _mm512_loadu_ps(pz + k), c12, c6, allLanes));
+        }
+        if (rem) {
+            if (LJ::PER_ELEMENT) {
+                const __m512i types = loadTypesAVX512(tailE);
+                c12 = _mm512_permutexvar_ps(types, c12Row);
+                c6 = _mm512_permutexvar_ps(types, c6Row);
+            }
+            acc = _mm512_add_ps(acc, ljTermAVX512<LJ>(x, y, z, _mm512_maskz_loadu_ps(tailLanes, px + vecEnd),
+                                                      _mm512_maskz_loadu_ps(tailLanes, py + vecEnd),
+                                                      _mm512_maskz_loadu_ps(tailLanes, pz + vecEnd), c12, c6,
+                                                      tailLanes));
+        }
+    }
+    return _mm512_reduce_add_ps(acc);
+}
+
+#else // !DOCKING_X86
+
+// En arquitecturas no x86 las variantes vectoriales delegan en el kernel escalar.
+template <class LJ>
+static float ljKernelSSE(LJ_KERNEL_PARAMS) {
+    return ljKernelScalar<LJ>(lx, ly, lz, le, numLigandAtoms, px, py, pz, pe, numProteinAtoms);
+}
+template <class LJ>
+static float ljKernelAVX2(LJ_KERNEL_PARAMS) {
+    return ljKernelScalar<LJ>(lx, ly, lz, le, numLigandAtoms, px, py, pz, pe, numProteinAtoms);
+}
+template <class LJ>
+static float ljKernelAVX512(LJ_KERNEL_PARAMS) {
+    return ljKernelScalar<LJ>(lx, ly, lz, le, numLigandAtoms, px, py, pz, pe, numProteinAtoms);
+}
+
+#endif // DOCKING_X86
+
+#undef LJ_KERNEL_PARAMS
+
+//-----------------------------------------------------------------------------
+// Selección en tiempo de ejecución.
+
+struct KernelEntry {
+    const char* name;
+    LJKernelFn fn[NUM_FORCEFIELDS];   // Una especialización por conjunto de parámetros
+    bool supported;
+};
+
+static KernelEntry selectKernel() {
+    KernelEntry entries[] = {
+        { "avx512", { ljKernelAVX512<UniformLJ>, ljKernelAVX512<UffLJ> }, false },
+        { "avx2",   { ljKernelAVX2<UniformLJ>,   ljKernelAVX2<UffLJ>   }, false },
+        { "sse",    { ljKernelSSE<UniformLJ>,    ljKernelSSE<UffLJ>    }, false },
+        { "scalar", { ljKernelScalar<UniformLJ>, ljKernelScalar<UffLJ> }, true  },
+    };
+#ifdef DOCKING_X86
+    __builtin_cpu_init();
+    entries[0].supported = __builtin_cpu_supports("avx512f");
+    entries[1].supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    entries[2].supported = true;
+#endif
+
+    const char* forced = std::getenv("BIOSCREENING_SIMD");
+    if (forced != nullptr) {
+        for (const KernelEntry& entry : entries) {
+            if (std::strcmp(forced, entry.name) == 0) {
+                if (entry.supported)
+                    return entry;
+                std::cerr << "BIOSCREENING_SIMD=" << forced
+                          << " no está soportado por esta CPU; se usa la mejor alternativa." << std::endl;
+            }
+        }
+    }
+    for (const KernelEntry& entry : entries) {
+        if (entry.supported)
+            return entry;
+    }
+    return entries[3];
+}
+
+static const KernelEntry& selectedKernel() {
+    static const KernelEntry entry = selectKernel();
+    return entry;
+}
+
+LJKernelFn getLJKernel(ForceField forceField) {
+    return selectedKernel().fn[forceField < NUM_FORCEFIELDS ? forceField : FORCEFIELD_UNIFORM];
+}
+
+const char* getLJKernelName() {
+    return selectedKernel().name;
+}
@@ -0,0 +1,103 @@
+#include "ForceField.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Parámetros UFF por elemento (x en Å, D en kcal/mol), en el orden de ElementType.
+// Los elementos desconocidos usan los del carbono.
+static constexpr LJElementParams UFF_ELEMENTS[NUM_ELEMENT_TYPES] = {
+    { 3.851, 0.105 },   // desconocido (como C)
+    { 2.886, 0.044 },   // H
+    { 3.851, 0.105 },   // C
+    { 3.660, 0.069 },   // N
+    { 3.500, 0.060 },   // O
+    { 4.035, 0.274 },   // S
+    { 4.147, 0.305 },   // P
+    { 3.364, 0.050 },   // F
+    { 3.947, 0.227 },   // Cl
+    { 4.189, 0.251 },   // Br
+    { 4.500, 0.339 },   // I
+    { 2.912, 0.013 },   // Fe
+    { 2.763, 0.124 },   // Zn
+    { 3.021, 0.111 },   // Mg
+    { 3.399, 0.238 },   // Ca
+    { 2.983, 0.030 },   // Na
+};
+
+// Tabla con los mismos coeficientes para todas las parejas.
+static constexpr LJPairTable constantTable(float c12, float c6) {
+    LJPairTable table{};
+    for (std::size_t a = 0; a < NUM_ELEMENT_TYPES; ++a) {
+        for (std::size_t b = 0; b < NUM_ELEMENT_TYPES; ++b) {
+            table.c12[a][b] = c12;
+            table.c6[a][b] = c6;
+        }
+    }
+    return table;
+}
+
+// La declaración extern de ForceField.h les da enlace externo; constexpr garantiza que
+// se inicializan en compilación.
+constexpr LJPairTable UNIFORM_PAIR_TABLE = constantTable(4.0f, 4.0f);
+constexpr LJPairTable UFF_PAIR_TABLE = mixGeometric(UFF_ELEMENTS);
+
+// La regla de combinación es simétrica y la tabla se evalúa en compilación.
+static_assert(UFF_PAIR_TABLE.c6[ELEMENT_C][ELEMENT_O] == UFF_PAIR_TABLE.c6[ELEMENT_O][ELEMENT_C],
+              "La tabla UFF debe ser simétrica");
+
+static const char* const FORCEFIELD_NAMES[NUM_FORCEFIELDS] = { "uniform", "uff" };
+
+const char* forceFieldName(ForceField forceField) {
+    return forceField < NUM_FORCEFIELDS ? FORCEFIELD_NAMES[forceField] : "?";
+}
+
+bool parseForceField(const char* name, ForceField& forceField) {
+    for (int k = 0; k < NUM_FORCEFIELDS; ++k) {
+        if (std::strcmp(name, FORCEFIELD_NAMES[k]) == 0) {
+            forceField = static_cast<ForceField>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+const LJPairTable& pairTable(ForceField forceField) {
+    return forceField == FORCEFIELD_UFF ? UFF_PAIR_TABLE : UNIFORM_PAIR_TABLE;
+}
+
+static SeparableLJ computeSeparable(ForceField forceField) {
+    const LJPairTable& table = pairTable(forceField);
+    SeparableLJ coefficients;
+    for (int e = 0; e < NUM_ELEMENT_TYPES; ++e) {
+        coefficients.a[e] = std::sqrt(table.c12[e][e]);
+        coefficients.b[e] = std::sqrt(table.c6[e][e]);
+    }
+    return coefficients;
+}
+
+const SeparableLJ& separableCoefficients(ForceField forceField) {
+    static const SeparableLJ uniform = computeSeparable(FORCEFIELD_UNIFORM);
+    static const SeparableLJ uff = computeSeparable(FORCEFIELD_UFF);
+    return forceField == FORCEFIELD_UFF ? uff : uniform;
+}
+
+float pairSigma(ForceField forceField, uint8_t a, uint8_t b) {
+    const LJPairTable& table = pairTable(forceField);
+    return static_cast<float>(std::pow(static_cast<double>(table.c12[a][b]) / table.c6[a][b], 1.0 / 6.0));
+}
+
+float minPairSigma(ForceField forceField) {
+    float sigma = pairSigma(forceField, 0, 0);
+    for (int a = 0; a < NUM_ELEMENT_TYPES; ++a)
+        for (int b = 0; b < NUM_ELEMENT_TYPES; ++b)
+            sigma = std::min(sigma, pairSigma(forceField, static_cast<uint8_t>(a), static_cast<uint8_t>(b)));
+    return sigma;
+}
+
+float maxPairSigma(ForceField forceField) {
+    float sigma = pairSigma(forceField, 0, 0);
+    for (int a = 0; a < NUM_ELEMENT_TYPES; ++a)
+        for (int b = 0; b < NUM_ELEMENT_TYPES; ++b)
+            sigma = std::max(sigma, pairSigma(forceField, static_cast<uint8_t>(a), static_cast<uint8_t>(b)));
+    return sigma;
+}
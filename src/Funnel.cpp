@@ -0,0 +1,154 @@
+#include "Funnel.h"
+#include "DockingKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// Celda de cada átomo de 'mol' (21 bits por eje, desplazados para que sean positivos),
+// ordenada: los átomos de cada pseudo-átomo quedan consecutivos en 'cells'.
+static void sortAtomsByCell(const Molecule& mol, float clusterSize,
+                            std::vector<std::pair<uint64_t, uint32_t>>& cells) {
+    const float invSize = 1.0f / clusterSize;
+    const float* coords[3] = { mol.getX(), mol.getY(), mol.getZ() };
+    const uint64_t mask = (1u << 21) - 1;
+    cells.resize(mol.getAtomCount());
+    for (std::size_t k = 0; k < mol.getAtomCount(); ++k) {
+        uint64_t key = 0;
+        for (int d = 0; d < 3; ++d) {
+            const int64_t cell = static_cast<int64_t>(std::floor(coords[d][k] * invSize)) + (1 << 20);
+            key = (key << 21) | (static_cast<uint64_t>(cell) & mask);
+        }
+        cells[k] = std::make_pair(key, static_cast<uint32_t>(k));
+    }
+    std::sort(cells.begin(), cells.end());
+}
+
+static std::size_t countCells(const std::vector<std::pair<uint64_t, uint32_t>>& cells) {
+    std::size_t count = 0;
+    for (std::size_t k = 0; k < cells.size(); ++k)
+        count += (k == 0 || cells[k].first != cells[k - 1].first) ? 1 : 0;
+    return count;
+}
+
+// Escribe los pseudo-átomos de 'mol' a partir de la posición 'out' de los arreglos.
+static void writePseudoAtoms(const Molecule& mol, const SeparableLJ& coefficients,
+                             const std::vector<std::pair<uint64_t, uint32_t>>& cells, std::size_t out,
+                             float* x, float* y, float* z, float* a, float* b) {
+    const float* mx = mol.getX();
+    const float* my = mol.getY();
+    const float* mz = mol.getZ();
+    const uint8_t* me = mol.getElements();
+    std::size_t first = 0;
+    while (first < cells.size()) {
+        std::size_t last = first;
+        float sx = 0.0f, sy = 0.0f, sz = 0.0f, sa = 0.0f, sb = 0.0f;
+        for (; last < cells.size() && cells[last].first == cells[first].first; ++last) {
+            const uint32_t k = cells[last].second;
+            sx += mx[k];
+            sy += my[k];
+            sz += mz[k];
+            sa += coefficients.a[me[k]];
+            sb += coefficients.b[me[k]];
+        }
+        const float invMembers = 1.0f / static_cast<float>(last - first);
+        x[out] = sx * invMembers;
+        y[out] = sy * invMembers;
+        z[out] = sz * invMembers;
+        a[out] = sa;
+        b[out] = sb;
+        out++;
+        first = last;
+    }
+}
+
+void CoarseModels::build(const std::vector<Molecule>& molecules, float clusterSize, ForceField forceField) {
+    const SeparableLJ& coefficients = separableCoefficients(forceField);
+    const std::size_t numMolecules = molecules.size();
+
+    // Dos pasadas paralelas: número de pseudo-átomos de cada molécula y, tras la suma
+    // prefija, sus valores en su posición definitiva.
+    offsets.assign(numMolecules + 1, 0);
+    #ifdef _OPENMP
+    #pragma omp parallel
+    #endif
+    {
+        std::vector<std::pair<uint64_t, uint32_t>> cells;
+        #ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 256)
+        #endif
+        for (std::size_t m = 0; m < numMolecules; ++m) {
+            sortAtomsByCell(molecules[m], clusterSize, cells);
+            offsets[m + 1] = countCells(cells);
+        }
+    }
+    for (std::size_t m = 0; m < numMolecules; ++m)
+        offsets[m + 1] += offsets[m];
+
+    const std::size_t total = offsets[numMolecules];
+    x.resize(total); y.resize(total); z.resize(total);
+    a.resize(total); b.resize(total);
+    #ifdef _OPENMP
+    #pragma omp parallel
+    #endif
+    {
+        std::vector<std::pair<uint64_t, uint32_t>> cells;
+        #ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 256)
+        #endif
+        for (std::size_t m = 0; m < numMolecules; ++m) {
+            sortAtomsByCell(molecules[m], clusterSize, cells);
+            writePseudoAtoms(molecules[m], coefficients, cells, offsets[m],
+                             x.data(), y.data(), z.data(), a.data(), b.data());
+        }
+    }
+}
+
+void CoarseModels::build(const Molecule& molecule, float clusterSize, ForceField forceField) {
+    // Reutiliza la memoria de la llamada anterior (se usa con un buffer por hilo).
+    static thread_local std::vector<std::pair<uint64_t, uint32_t>> cells;
+    sortAtomsByCell(molecule, clusterSize, cells);
+    const std::size_t count = countCells(cells);
+    offsets.assign(2, 0);
+    offsets[1] = count;
+    x.resize(count); y.resize(count); z.resize(count);
+    a.resize(count); b.resize(count);
+    writePseudoAtoms(molecule, separableCoefficients(forceField), cells, 0, x.data(), y.data(), z.data(),
+                     a.data(), b.data());
+}
+
+std::size_t CoarseModels::getBytes() const {
+    return offsets.size() * sizeof(std::size_t) + 5 * x.size() * sizeof(float);
+}
+
+float CoarseModels::energy(const CoarseModels& proteins, std::size_t protein,
+                           const CoarseModels& ligands, std::size_t ligand) {
+    const std::size_t pBegin = proteins.offsets[protein];
+    const std::size_t pEnd = proteins.offsets[protein + 1];
+    const float* px = proteins.x.data();
+    const float* py = proteins.y.data();
+    const float* pz = proteins.z.data();
+    const float* pa = proteins.a.data();
+    const float* pb = proteins.b.data();
+
+    float energy = 0.0f;
+    for (std::size_t l = ligands.offsets[ligand]; l < ligands.offsets[ligand + 1]; ++l) {
+        const float x = ligands.x[l];
+        const float y = ligands.y[l];
+        const float z = ligands.z[l];
+        const float a = ligands.a[l];
+        const float b = ligands.b[l];
+        for (std::size_t p = pBegin; p < pEnd; ++p) {
+            float dx = x - px[p];
+            float dy = y - py[p];
+            float dz = z - pz[p];
+            float r2 = dx * dx + dy * dy + dz * dz;
+            // Sin saltos: las parejas demasiado cercanas aportan 0.
+            bool valid = r2 >= LJ_MIN_R2;
+            float inv2 = 1.0f / (valid ? r2 : 1.0f);
+            inv2 = valid ? inv2 : 0.0f;
+            float inv6 = inv2 * inv2 * inv2;
+            energy += inv6 * (a * pa[p] * inv6 - b * pb[p]);
+        }
+    }
+    return energy;
+}
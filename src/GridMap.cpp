@@ -0,0 +1,200 @@
+#include "GridMap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+// Cabecera del fichero de caché de rejillas.
+static const uint32_t GRID_FILE_MAGIC = 0x4D475342;  // "BSGM"
+static const uint32_t GRID_FILE_VERSION = 2;
+
+struct GridFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    int32_t dims[3];
+    float origin[3];
+    float spacing;
+    int32_t numClasses;
+    int32_t elementClass[NUM_ELEMENT_TYPES];
+};
+
+float defaultGridSpacing(ForceField forceField) {
+    return GRID_SPACING_PER_SIGMA * minPairSigma(forceField);
+}
+
+GridMapSet::GridMapSet()
+    : originX(0.0f), originY(0.0f), originZ(0.0f), spacing(0.0f), invSpacing(0.0f),
+      dimX(0), dimY(0), dimZ(0), numClasses(0) {
+    std::fill(elementClass, elementClass + NUM_ELEMENT_TYPES, -1);
+}
+
+void GridMapSet::setGeometry(const float boxMin[3], const float boxMax[3], float gridSpacing) {
+    spacing = gridSpacing;
+    invSpacing = 1.0f / gridSpacing;
+    originX = boxMin[0];
+    originY = boxMin[1];
+    originZ = boxMin[2];
+    // Se añade un punto extra para que boxMax quede dentro de la rejilla.
+    dimX = std::max(2, static_cast<int>(std::ceil((boxMax[0] - boxMin[0]) * invSpacing)) + 1);
+    dimY = std::max(2, static_cast<int>(std::ceil((boxMax[1] - boxMin[1]) * invSpacing)) + 1);
+    dimZ = std::max(2, static_cast<int>(std::ceil((boxMax[2] - boxMin[2]) * invSpacing)) + 1);
+}
+
+void GridMapSet::allocate(const std::vector<int>& classes, int count) {
+    numClasses = count;
+    std::fill(elementClass, elementClass + NUM_ELEMENT_TYPES, -1);
+    for (std::size_t e = 0; e < classes.size() && e < NUM_ELEMENT_TYPES; ++e)
+        elementClass[e] = classes[e];
+    values.assign(getPointCount() * numClasses, 0.0f);
+}
+
+bool GridMapSet::empty() const {
+    return values.empty();
+}
+
+int GridMapSet::getNumClasses() const {
+    return numClasses;
+}
+
+std::size_t GridMapSet::getPointCount() const {
+    return static_cast<std::size_t>(dimX) * dimY * dimZ;
+}
+
+std::size_t GridMapSet::getBytes() const {
+    return values.size() * sizeof(float);
+}
+
+float* GridMapSet::mapData(int mapClass) {
+    return values.data() + static_cast<std::size_t>(mapClass) * getPointCount();
+}
+
+const float* GridMapSet::mapData(int mapClass) const {
+    return values.data() + static_cast<std::size_t>(mapClass) * getPointCount();
+}
+
+int GridMapSet::classForElement(uint8_t element) const {
+    return element < NUM_ELEMENT_TYPES ? elementClass[element] : -1;
+}
+
+void GridMapSet::markExact(int mapClass, int iz, float x, float y, float z, float radius) {
+    const float dz = pointZ(iz) - z;
+    const float rest2 = radius * radius - dz * dz;
+    if (rest2 <= 0.0f)
+        return;
+    const float rest = std::sqrt(rest2);
+    const int y0 = std::max(0, static_cast<int>(std::ceil((y - rest - originY) * invSpacing)));
+    const int y1 = std::min(dimY - 1, static_cast<int>(std::floor((y + rest - originY) * invSpacing)));
+    const int x0 = std::max(0, static_cast<int>(std::ceil((x - rest - originX) * invSpacing)));
+    const int x1 = std::min(dimX - 1, static_cast<int>(std::floor((x + rest - originX) * invSpacing)));
+    float* plane = mapData(mapClass) + static_cast<std::size_t>(iz) * dimY * dimX;
+    for (int iy = y0; iy <= y1; ++iy) {
+        const float dy = pointY(iy) - y;
+        for (int ix = x0; ix <= x1; ++ix) {
+            const float dx = pointX(ix) - x;
+            if (dx * dx + dy * dy < rest2)
+                plane[static_cast<std::size_t>(iy) * dimX + ix] = GRID_EXACT_MARK;
+        }
+    }
+}
+
+bool GridMapSet::interpolate(uint8_t element, float x, float y, float z, float& energy) const {
+    int mapClass = classForElement(element);
+    if (mapClass < 0)
+        return false;
+
+    float fx = (x - originX) * invSpacing;
+    float fy = (y - originY) * invSpacing;
+    float fz = (z - originZ) * invSpacing;
+    if (!(fx >= 0.0f && fy >= 0.0f && fz >= 0.0f))
+        return false;
+    int ix = static_cast<int>(fx);
+    int iy = static_cast<int>(fy);
+    int iz = static_cast<int>(fz);
+    if (ix >= dimX - 1 || iy >= dimY - 1 || iz >= dimZ - 1)
+        return false;
+    float tx = fx - ix;
+    float ty = fy - iy;
+    float tz = fz - iz;
+
+    const std::size_t strideY = dimX;
+    const std::size_t strideZ = static_cast<std::size_t>(dimX) * dimY;
+    const float* v = mapData(mapClass) + iz * strideZ + iy * strideY + ix;
+
+    // Los valores válidos no superan GRID_ENERGY_CAP; un vértice marcado pide el cálculo exacto.
+    const float highest = std::max(std::max(std::max(v[0], v[1]), std::max(v[strideY], v[strideY + 1])),
+                                   std::max(std::max(v[strideZ], v[strideZ + 1]),
+                                            std::max(v[strideZ + strideY], v[strideZ + strideY + 1])));
+    if (highest > GRID_ENERGY_CAP)
+        return false;
+
+    // Interpolación a lo largo de x, luego y, luego z.
+    float c00 = v[0] + tx * (v[1] - v[0]);
+    float c10 = v[strideY] + tx * (v[strideY + 1] - v[strideY]);
+    float c01 = v[strideZ] + tx * (v[strideZ + 1] - v[strideZ]);
+    float c11 = v[strideZ + strideY] + tx * (v[strideZ + strideY + 1] - v[strideZ + strideY]);
+    float c0 = c00 + ty * (c10 - c00);
+    float c1 = c01 + ty * (c11 - c01);
+    energy = c0 + tz * (c1 - c0);
+    return true;
+}
+
+bool GridMapSet::save(const std::string& filename, uint64_t key) const {
+    GridFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = GRID_FILE_MAGIC;
+    header.version = GRID_FILE_VERSION;
+    header.key = key;
+    header.dims[0] = dimX;
+    header.dims[1] = dimY;
+    header.dims[2] = dimZ;
+    header.origin[0] = originX;
+    header.origin[1] = originY;
+    header.origin[2] = originZ;
+    header.spacing = spacing;
+    header.numClasses = numClasses;
+    std::copy(elementClass, elementClass + NUM_ELEMENT_TYPES, header.elementClass);
+
+    // Se escribe en un temporal y se renombra para no dejar ficheros a medias.
+    std::string tmpName = filename + ".tmp." + std::to_string(getpid());
+    FILE* file = std::fopen(tmpName.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(values.data(), sizeof(float), values.size(), file) == values.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GridMapSet::load(const std::string& filename, uint64_t key) {
+    FILE* file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    GridFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != GRID_FILE_MAGIC ||
+        header.version != GRID_FILE_VERSION || header.key != key) {
+        std::fclose(file);
+        return false;
+    }
+    dimX = header.dims[0];
+    dimY = header.dims[1];
+    dimZ = header.dims[2];
+    originX = header.origin[0];
+    originY = header.origin[1];
+    originZ = header.origin[2];
+    spacing = header.spacing;
+    invSpacing = 1.0f / spacing;
+    numClasses = header.numClasses;
+    std::copy(header.elementClass, header.elementClass + NUM_ELEMENT_TYPES, elementClass);
+    values.resize(getPointCount() * numClasses);
+    bool ok = std::fread(values.data(), sizeof(float), values.size(), file) == values.size();
+    std::fclose(file);
+    if (!ok)
+        values.clear();
+    return ok;
+}
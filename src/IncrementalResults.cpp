@@ -0,0 +1,309 @@
+#include "IncrementalResults.h"
+#include "Checkpoint.h"
+#include "DataManager.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cabecera del fichero de resultados.
+static const uint32_t RESULTS_MAGIC = 0x53525342;  // "BSRS"
+static const uint32_t RESULTS_VERSION = 1;
+static const char* RESULTS_FILE = "/results.bsrs";
+
+struct ResultsHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t numProteinFiles;
+    uint64_t numLigandFiles;
+    uint64_t numProteins;
+    uint64_t numLigands;
+    uint64_t pathBytes;
+};
+
+struct ManifestRecord {
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+    uint64_t pathOffset;
+    uint64_t pathLength;
+};
+
+uint64_t incrementalKey(const std::vector<Molecule>& ligands, const DockingParams& params) {
+    uint64_t key = dockingParamsKey(params, hashValue(RESULTS_VERSION));
+    if (params.funnel.keepFraction > 0.0f) {
+        // El conjunto de ligandos, sin importar su orden.
+        std::vector<uint64_t> hashes(ligands.size());
+        for (std::size_t j = 0; j < ligands.size(); ++j)
+            hashes[j] = ligands[j].contentHash();
+        std::sort(hashes.begin(), hashes.end());
+        key = hashBytes(hashes.data(), hashes.size() * sizeof(uint64_t), key);
+    }
+    return key;
+}
+
+bool buildManifest(const std::string& path, const std::vector<std::string>& extensions,
+                   const std::vector<ManifestEntry>& previous, std::vector<ManifestEntry>& manifest) {
+    manifest.clear();
+    std::vector<std::string> files;
+    if (!DataManager::listFiles(path, extensions, files))
+        return false;
+    std::unordered_map<std::string, const ManifestEntry*> known;
+    for (const ManifestEntry& entry : previous)
+        known[entry.path] = &entry;
+
+    manifest.resize(files.size());
+    bool ok = true;
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) reduction(&&:ok)
+    #endif
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        ManifestEntry& entry = manifest[f];
+        entry.path = files[f];
+        struct stat s;
+        if (stat(entry.path.c_str(), &s) != 0) {
+            ok = false;
+            continue;
+        }
+        entry.size = static_cast<uint64_t>(s.st_size);
+        entry.mtime = static_cast<int64_t>(s.st_mtim.tv_sec) * 1000000000LL + s.st_mtim.tv_nsec;
+        auto it = known.find(entry.path);
+        if (it != known.end() && it->second->size == entry.size && it->second->mtime == entry.mtime) {
+            entry.hash = it->second->hash;
+            continue;
+        }
+        MappedFile content;
+        if (!content.open(entry.path)) {
+            ok = false;
+            continue;
+        }
+        entry.hash = hashBytes(content.data(), content.size());
+    }
+    return ok;
+}
+
+ManifestChanges compareManifests(const std::vector<ManifestEntry>& previous,
+                                 const std::vector<ManifestEntry>& current) {
+    std::unordered_map<std::string, uint64_t> known;
+    for (const ManifestEntry& entry : previous)
+        known[entry.path] = entry.hash;
+    ManifestChanges changes;
+    std::size_t kept = 0;
+    for (const ManifestEntry& entry : current) {
+        auto it = known.find(entry.path);
+        if (it == known.end()) {
+            changes.added++;
+        } else {
+            kept++;
+            if (it->second != entry.hash)
+                changes.changed++;
+        }
+    }
+    changes.removed = known.size() - kept;
+    return changes;
+}
+
+IncrementalResults::IncrementalResults()
+    : key(0), proteinHashes(nullptr), ligandHashes(nullptr), scores(nullptr), numProteins(0), numLigands(0) {
+}
+
+// Lee 'count' registros del manifiesto a partir de 'records'.
+static void readManifest(const ManifestRecord* records, std::size_t count, const char* paths,
+                         std::vector<ManifestEntry>& manifest) {
+    manifest.resize(count);
+    for (std::size_t f = 0; f < count; ++f) {
+        manifest[f].path.assign(paths + records[f].pathOffset, records[f].pathLength);
+        manifest[f].size = records[f].size;
+        manifest[f].mtime = records[f].mtime;
+        manifest[f].hash = records[f].hash;
+    }
+}
+
+bool IncrementalResults::open(const std::string& dir) {
+    close();
+    if (!file.open(dir + RESULTS_FILE, false))
+        return false;
+    ResultsHeader header;
+    if (file.size() < sizeof(header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    // Los tamaños se comprueban por partes para que una cabecera corrupta no desborde.
+    const uint64_t size = file.size();
+    const uint64_t numFiles = header.numProteinFiles + header.numLigandFiles;
+    if (header.magic != RESULTS_MAGIC || header.version != RESULTS_VERSION ||
+        numFiles > size / sizeof(ManifestRecord) || header.pathBytes > size ||
+        header.numProteins + header.numLigands > size / sizeof(uint64_t) ||
+        (header.numProteins > 0 && header.numLigands > size / sizeof(float) / header.numProteins)) {
+        close();
+        return false;
+    }
+    // Los hashes empiezan alineados a 8 bytes (ver save()).
+    const uint64_t hashesOffset = (sizeof(header) + numFiles * sizeof(ManifestRecord) + header.pathBytes + 7) & ~7ULL;
+    if (size != hashesOffset + (header.numProteins + header.numLigands) * sizeof(uint64_t) +
+                header.numProteins * header.numLigands * sizeof(float)) {
+        close();
+        return false;
+    }
+
+    const ManifestRecord* records = reinterpret_cast<const ManifestRecord*>(file.data() + sizeof(header));
+    const char* paths = file.data() + sizeof(header) + numFiles * sizeof(ManifestRecord);
+    for (uint64_t f = 0; f < numFiles; ++f) {
+        if (records[f].pathOffset > header.pathBytes || records[f].pathLength > header.pathBytes - records[f].pathOffset) {
+            close();
+            return false;
+        }
+    }
+    readManifest(records, header.numProteinFiles, paths, proteinManifest);
+    readManifest(records + header.numProteinFiles, header.numLigandFiles, paths, ligandManifest);
+
+    key = header.key;
+    numProteins = header.numProteins;
+    numLigands = header.numLigands;
+    proteinHashes = reinterpret_cast<const uint64_t*>(file.data() + hashesOffset);
+    ligandHashes = proteinHashes + numProteins;
+    scores = reinterpret_cast<const float*>(ligandHashes + numLigands);
+    return true;
+}
+
+void IncrementalResults::close() {
+    file.close();
+    key = 0;
+    proteinManifest.clear();
+    ligandManifest.clear();
+    proteinHashes = ligandHashes = nullptr;
+    scores = nullptr;
+    numProteins = numLigands = 0;
+}
+
+// Posición guardada de cada molécula actual (por hash de contenido), o SIZE_MAX.
+static std::vector<std::size_t> storedIndices(const std::vector<Molecule>& molecules, const uint64_t* hashes,
+                                              std::size_t count) {
+    std::unordered_map<uint64_t, std::size_t> stored;
+    stored.reserve(count);
+    for (std::size_t k = count; k-- > 0; )
+        stored[hashes[k]] = k;
+    std::vector<std::size_t> indices(molecules.size(), SIZE_MAX);
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (std::size_t k = 0; k < molecules.size(); ++k) {
+        auto it = stored.find(molecules[k].contentHash());
+        if (it != stored.end())
+            indices[k] = it->second;
+    }
+    return indices;
+}
+
+std::size_t IncrementalResults::reusablePairs(const std::vector<Molecule>& proteins,
+                                              const std::vector<Molecule>& ligands,
+                                              std::vector<PairRange>& ranges, std::vector<float>& reused) const {
+    ranges.clear();
+    reused.clear();
+    if (!isOpen())
+        return 0;
+    const std::vector<std::size_t> rows = storedIndices(proteins, proteinHashes, numProteins);
+    const std::vector<std::size_t> columns = storedIndices(ligands, ligandHashes, numLigands);
+
+    // Los tramos de ligandos conocidos de una fila se repiten en todas: se calculan una vez.
+    std::vector<PairRange> columnRuns;
+    for (std::size_t j = 0; j < ligands.size(); ++j) {
+        if (columns[j] == SIZE_MAX)
+            continue;
+        if (!columnRuns.empty() && columnRuns.back().end == j)
+            columnRuns.back().end++;
+        else
+            columnRuns.push_back(PairRange{ j, j + 1 });
+    }
+    for (std::size_t i = 0; i < proteins.size(); ++i) {
+        if (rows[i] == SIZE_MAX)
+            continue;
+        const float* row = scores + rows[i] * numLigands;
+        for (const PairRange& run : columnRuns) {
+            const std::size_t begin = i * ligands.size() + run.begin;
+            const std::size_t end = i * ligands.size() + run.end;
+            if (!ranges.empty() && ranges.back().end == begin)
+                ranges.back().end = end;
+            else
+                ranges.push_back(PairRange{ begin, end });
+            for (std::size_t j = run.begin; j < run.end; ++j)
+                reused.push_back(row[columns[j]]);
+        }
+    }
+    return reused.size();
+}
+
+// Añade los registros de 'manifest' a 'records' y sus rutas a 'paths'.
+static void appendManifest(const std::vector<ManifestEntry>& manifest, std::vector<ManifestRecord>& records,
+                           std::string& paths) {
+    for (const ManifestEntry& entry : manifest) {
+        ManifestRecord record;
+        record.size = entry.size;
+        record.mtime = entry.mtime;
+        record.hash = entry.hash;
+        record.pathOffset = paths.size();
+        record.pathLength = entry.path.size();
+        records.push_back(record);
+        paths += entry.path;
+    }
+}
+
+bool IncrementalResults::save(const std::string& dir, uint64_t key, const std::vector<ManifestEntry>& proteinManifest,
+                              const std::vector<ManifestEntry>& ligandManifest, const std::vector<Molecule>& proteins,
+                              const std::vector<Molecule>& ligands, const std::vector<float>& scores) {
+    if (scores.size() != proteins.size() * ligands.size())
+        return false;
+    mkdir(dir.c_str(), 0755);
+
+    std::vector<ManifestRecord> records;
+    std::string paths;
+    appendManifest(proteinManifest, records, paths);
+    appendManifest(ligandManifest, records, paths);
+    // Relleno para que los hashes queden alineados a 8 bytes en la proyección.
+    const std::size_t used = sizeof(ResultsHeader) + records.size() * sizeof(ManifestRecord) + paths.size();
+    const std::string padding((8 - used % 8) % 8, '\0');
+
+    std::vector<uint64_t> hashes(proteins.size() + ligands.size());
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (std::size_t k = 0; k < hashes.size(); ++k)
+        hashes[k] = k < proteins.size() ? proteins[k].contentHash() : ligands[k - proteins.size()].contentHash();
+
+    ResultsHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = RESULTS_MAGIC;
+    header.version = RESULTS_VERSION;
+    header.key = key;
+    header.numProteinFiles = proteinManifest.size();
+    header.numLigandFiles = ligandManifest.size();
+    header.numProteins = proteins.size();
+    header.numLigands = ligands.size();
+    header.pathBytes = paths.size();
+
+    // Se escribe en un temporal y se renombra para no dejar resultados a medias.
+    const std::string filename = dir + RESULTS_FILE;
+    std::string tmpName = filename + ".tmp." + std::to_string(getpid());
+    FILE* file = std::fopen(tmpName.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(records.data(), sizeof(ManifestRecord), records.size(), file) == records.size() &&
+              std::fwrite(paths.data(), 1, paths.size(), file) == paths.size() &&
+              std::fwrite(padding.data(), 1, padding.size(), file) == padding.size() &&
+              std::fwrite(hashes.data(), sizeof(uint64_t), hashes.size(), file) == hashes.size() &&
+              std::fwrite(scores.data(), sizeof(float), scores.size(), file) == scores.size();
+    ok = std::fflush(file) == 0 && ok;
+    ok = fdatasync(fileno(file)) == 0 && ok;
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
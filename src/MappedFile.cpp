@@ -0,0 +1,69 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : addr(nullptr), length(0), opened(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : addr(other.addr), length(other.length), opened(other.opened) {
+    other.addr = nullptr;
+    other.length = 0;
+    other.opened = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        addr = other.addr;
+        length = other.length;
+        opened = other.opened;
+        other.addr = nullptr;
+        other.length = 0;
+        other.opened = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename, bool sequential) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat s;
+    if (fstat(fd, &s) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<std::size_t>(s.st_size);
+    if (length > 0) {
+        addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            addr = nullptr;
+            length = 0;
+            ::close(fd);
+            return false;
+        }
+        // Los parsers recorren el fichero de principio a fin.
+        if (sequential)
+            madvise(addr, length, MADV_SEQUENTIAL);
+    }
+    // La proyección sigue siendo válida tras cerrar el descriptor.
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (addr != nullptr)
+        munmap(addr, length);
+    addr = nullptr;
+    length = 0;
+    opened = false;
+}
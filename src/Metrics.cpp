@@ -0,0 +1,210 @@
+#include "Metrics.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+static const char* PHASE_NAMES[NUM_METRIC_PHASES] = { "scan", "parse", "flatten", "compute", "gather", "rank" };
+static const char* COUNTER_NAMES[NUM_METRIC_COUNTERS] = { "pairs_scored", "atom_pair_interactions", "bytes_read",
+                                                             "coarse_pairs", "cache_lookups", "cache_hits",
+                                                             "equivalent_interactions" };
+
+const char* metricPhaseName(MetricPhase phase) {
+    return PHASE_NAMES[phase];
+}
+
+const char* metricCounterName(MetricCounter counter) {
+    return COUNTER_NAMES[counter];
+}
+
+MetricsSnapshot::MetricsSnapshot() {
+    std::fill(seconds, seconds + NUM_METRIC_PHASES, 0.0);
+    std::fill(wallSeconds, wallSeconds + NUM_METRIC_PHASES, 0.0);
+    std::fill(calls, calls + NUM_METRIC_PHASES, 0);
+    std::fill(counters, counters + NUM_METRIC_COUNTERS, 0);
+}
+
+void MetricsSnapshot::add(const MetricsSnapshot& other) {
+    for (int p = 0; p < NUM_METRIC_PHASES; ++p) {
+        seconds[p] += other.seconds[p];
+        wallSeconds[p] = std::max(wallSeconds[p], other.wallSeconds[p]);
+        calls[p] += other.calls[p];
+    }
+    for (int c = 0; c < NUM_METRIC_COUNTERS; ++c)
+        counters[c] += other.counters[c];
+}
+
+double MetricsSnapshot::pairsPerSecond() const {
+    const double t = wallSeconds[PHASE_COMPUTE];
+    return t > 0.0 ? counters[COUNTER_PAIRS] / t : 0.0;
+}
+
+double MetricsSnapshot::interactionsPerSecond() const {
+    const double t = wallSeconds[PHASE_COMPUTE];
+    return t > 0.0 ? counters[COUNTER_INTERACTIONS] / t : 0.0;
+}
+
+double MetricsSnapshot::equivalentInteractionsPerSecond() const {
+    const double t = wallSeconds[PHASE_COMPUTE];
+    return t > 0.0 ? counters[COUNTER_EQUIVALENT_INTERACTIONS] / t : 0.0;
+}
+
+double MetricsSnapshot::gflops() const {
+    return equivalentInteractionsPerSecond() * LJ_FLOPS_PER_INTERACTION / 1.0e9;
+}
+
+// Registros de todos los hilos. Cada hilo crea el suyo la primera vez que registra algo
+// y sólo él lo modifica; los registros sobreviven a sus hilos hasta el informe final.
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<MetricsSnapshot>> registry;
+static thread_local MetricsSnapshot* threadMetrics = nullptr;
+
+static MetricsSnapshot& currentMetrics() {
+    if (threadMetrics == nullptr) {
+        std::unique_ptr<MetricsSnapshot> slot(new MetricsSnapshot());
+        threadMetrics = slot.get();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(std::move(slot));
+    }
+    return *threadMetrics;
+}
+
+void addMetricCounter(MetricCounter counter, uint64_t value) {
+    currentMetrics().counters[counter] += value;
+}
+
+void addMetricPhase(MetricPhase phase, double seconds) {
+    MetricsSnapshot& metrics = currentMetrics();
+    metrics.seconds[phase] += seconds;
+    metrics.wallSeconds[phase] += seconds;
+    metrics.calls[phase]++;
+}
+
+ScopedPhase::ScopedPhase(MetricPhase phase) : phase(phase), traceStart(isTracing() ? traceClock() : 0) {
+    timer.start();
+}
+
+ScopedPhase::~ScopedPhase() {
+    timer.stop();
+    addMetricPhase(phase, timer.elapsedMilliseconds() / 1000.0);
+    if (isTracing())
+        recordTraceEvent(PHASE_NAMES[phase], "phase", traceStart, traceClock());
+}
+
+// Se inicializa al arrancar el programa, antes de main.
+static const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+double metricsElapsedSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+std::vector<MetricsSnapshot> collectThreadMetrics() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<MetricsSnapshot> threads;
+    for (const std::unique_ptr<MetricsSnapshot>& slot : registry)
+        threads.push_back(*slot);
+    return threads;
+}
+
+void printMetricsSummary(const MetricsSnapshot& total, double wallSeconds) {
+    std::cout << "Phase times (wall ms / summed over workers ms):" << std::endl;
+    for (int p = 0; p < NUM_METRIC_PHASES; ++p) {
+        if (total.calls[p] == 0)
+            continue;
+        std::cout << "  " << PHASE_NAMES[p] << ": " << total.wallSeconds[p] * 1000 << " / "
+                  << total.seconds[p] * 1000 << std::endl;
+    }
+    std::cout << "Pairs scored: " << total.counters[COUNTER_PAIRS]
+              << ", atom-pair interactions: " << total.counters[COUNTER_INTERACTIONS] << " ("
+              << total.counters[COUNTER_EQUIVALENT_INTERACTIONS] << " all-pairs equivalent), bytes read: " << total.counters[COUNTER_BYTES_READ] << std::endl;
+    std::cout << "Rates: " << total.pairsPerSecond() << " pairs/s, " << total.interactionsPerSecond()
+              << " interactions/s, " << total.gflops() << " equivalent GFLOP/s (total " << wallSeconds * 1000
+              << " ms)" << std::endl;
+}
+
+void printFunnelSummary(const MetricsSnapshot& total) {
+    const uint64_t coarse = total.counters[COUNTER_COARSE_PAIRS];
+    // Los pares servidos por la caché de scores también han pasado el embudo.
+    const uint64_t full = total.counters[COUNTER_PAIRS] + total.counters[COUNTER_CACHE_HITS];
+    std::cout << "Funnel: " << coarse << " pairs estimated with the coarse model, " << full << " ("
+              << (coarse > 0 ? 100.0 * full / coarse : 0.0) << "%) passed to full scoring" << std::endl;
+}
+
+void printScoreCacheSummary(const MetricsSnapshot& total) {
+    const uint64_t lookups = total.counters[COUNTER_CACHE_LOOKUPS];
+    const uint64_t hits = total.counters[COUNTER_CACHE_HITS];
+    std::cout << "Score cache: " << hits << " of " << lookups << " pairs found ("
+              << (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "% hit rate), " << lookups - hits
+              << " scored and stored" << std::endl;
+}
+
+static void writeNumber(FILE* out, double value) {
+    if (std::isfinite(value))
+        std::fprintf(out, "%.9g", value);
+    else
+        std::fputs("null", out);
+}
+
+// Objeto JSON con las fases, contadores y ritmos de 'metrics'.
+static void writeSnapshot(FILE* out, const MetricsSnapshot& metrics) {
+    std::fputs("{\"phases\": {", out);
+    bool first = true;
+    for (int p = 0; p < NUM_METRIC_PHASES; ++p) {
+        if (metrics.calls[p] == 0)
+            continue;
+        std::fprintf(out, "%s\"%s\": {\"wall_seconds\": ", first ? "" : ", ", PHASE_NAMES[p]);
+        writeNumber(out, metrics.wallSeconds[p]);
+        std::fputs(", \"seconds\": ", out);
+        writeNumber(out, metrics.seconds[p]);
+        std::fprintf(out, ", \"calls\": %llu}", static_cast<unsigned long long>(metrics.calls[p]));
+        first = false;
+    }
+    std::fputs("}, \"counters\": {", out);
+    for (int c = 0; c < NUM_METRIC_COUNTERS; ++c)
+        std::fprintf(out, "%s\"%s\": %llu", c == 0 ? "" : ", ", COUNTER_NAMES[c],
+                     static_cast<unsigned long long>(metrics.counters[c]));
+    std::fputs("}, \"rates\": {\"pairs_per_second\": ", out);
+    writeNumber(out, metrics.pairsPerSecond());
+    std::fputs(", \"interactions_per_second\": ", out);
+    writeNumber(out, metrics.interactionsPerSecond());
+    std::fputs(", \"equivalent_interactions_per_second\": ", out);
+    writeNumber(out, metrics.equivalentInteractionsPerSecond());
+    std::fputs(", \"gflops\": ", out);
+    writeNumber(out, metrics.gflops());
+    std::fputs("}}", out);
+}
+
+bool writeMetricsJson(const std::string& filename, const std::string& backend,
+                      const std::vector<std::vector<MetricsSnapshot>>& ranks, double wallSeconds) {
+    FILE* out = std::fopen(filename.c_str(), "w");
+    if (out == nullptr)
+        return false;
+
+    MetricsSnapshot total;
+    std::fprintf(out, "{\n  \"schema\": 1,\n  \"backend\": \"%s\",\n  \"wall_seconds\": ", backend.c_str());
+    writeNumber(out, wallSeconds);
+    std::fprintf(out, ",\n  \"flops_per_interaction\": %g,\n  \"ranks\": [", LJ_FLOPS_PER_INTERACTION);
+    for (std::size_t r = 0; r < ranks.size(); ++r) {
+        MetricsSnapshot rankTotal;
+        for (const MetricsSnapshot& thread : ranks[r])
+            rankTotal.add(thread);
+        total.add(rankTotal);
+
+        std::fprintf(out, "%s\n    {\"rank\": %zu, \"total\": ", r == 0 ? "" : ",", r);
+        writeSnapshot(out, rankTotal);
+        std::fputs(",\n     \"threads\": [", out);
+        for (std::size_t t = 0; t < ranks[r].size(); ++t) {
+            std::fputs(t == 0 ? "\n       " : ",\n       ", out);
+            writeSnapshot(out, ranks[r][t]);
+        }
+        std::fputs("]}", out);
+    }
+    std::fputs("\n  ],\n  \"total\": ", out);
+    writeSnapshot(out, total);
+    std::fputs("\n}\n", out);
+    return std::fclose(out) == 0;
+}
@@ -1,4 +1,44 @@
 #include "Molecule.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// Símbolos indexados por código de elemento (ver ElementType).
+static const char* const ELEMENT_SYMBOLS[NUM_ELEMENT_TYPES] = {
+    "X", "H", "C", "N", "O", "S", "P", "F", "Cl", "Br", "I", "Fe", "Zn", "Mg", "Ca", "Na"
+};
+
+uint8_t elementCode(const std::string& symbol) {
+    return elementCode(symbol.data(), symbol.size());
+}
+
+uint8_t elementCode(const char* symbol, std::size_t length) {
+    if (length == 0 || length > 2)
+        return ELEMENT_UNKNOWN;
+    for (int code = 1; code < NUM_ELEMENT_TYPES; ++code) {
+        const char* ref = ELEMENT_SYMBOLS[code];
+        if (std::strlen(ref) != length)
+            continue;
+        bool match = true;
+        for (std::size_t k = 0; k < length; ++k) {
+            if (std::tolower(static_cast<unsigned char>(symbol[k])) !=
+                std::tolower(static_cast<unsigned char>(ref[k]))) {
+                match = false;
+                break;
+            }
+        }
+        if (match)
+            return static_cast<uint8_t>(code);
+    }
+    return ELEMENT_UNKNOWN;
+}
+
+const char* elementSymbol(uint8_t code) {
+    if (code >= NUM_ELEMENT_TYPES)
+        return ELEMENT_SYMBOLS[ELEMENT_UNKNOWN];
+    return ELEMENT_SYMBOLS[code];
+}
 
 Molecule::Molecule() {
     // Inicialización del objeto molecule.
@@ -8,10 +48,184 @@ Molecule::~Molecule() {
     // Destructor.
 }
 
+Molecule Molecule::view(const float* x, const float* y, const float* z, const uint8_t* elements,
+                        std::size_t count, std::shared_ptr<const void> owner) {
+    Molecule mol;
+    mol.external = true;
+    mol.viewX = x;
+    mol.viewY = y;
+    mol.viewZ = z;
+    mol.viewElements = elements;
+    mol.viewCount = count;
+    mol.viewOwner = std::move(owner);
+    return mol;
+}
+
+Molecule Molecule::clone() const {
+    Molecule copy;
+    if (external) {
+        copy = view(viewX, viewY, viewZ, viewElements, viewCount, viewOwner);
+    } else {
+        copy.xs = xs;
+        copy.ys = ys;
+        copy.zs = zs;
+        copy.elements = elements;
+    }
+    return copy;
+}
+
+void Molecule::materialize() {
+    if (!external)
+        return;
+    xs.assign(viewX, viewX + viewCount);
+    ys.assign(viewY, viewY + viewCount);
+    zs.assign(viewZ, viewZ + viewCount);
+    elements.assign(viewElements, viewElements + viewCount);
+    external = false;
+    viewX = viewY = viewZ = nullptr;
+    viewElements = nullptr;
+    viewCount = 0;
+    viewOwner.reset();
+}
+
+void Molecule::reserve(std::size_t count) {
+    materialize();
+    if (count <= xs.capacity())
+        return;
+    if (!xs.empty())
+        count = std::max(count, 2 * xs.capacity());
+    xs.reserve(count);
+    ys.reserve(count);
+    zs.reserve(count);
+    elements.reserve(count);
+}
+
 void Molecule::addAtom(const Atom& atom) {
-    atoms.push_back(atom);
+    addAtom(atom.x, atom.y, atom.z, elementCode(atom.element, std::strlen(atom.element)));
+}
+
+void Molecule::addAtom(float x, float y, float z, uint8_t element) {
+    materialize();
+    xs.push_back(x);
+    ys.push_back(y);
+    zs.push_back(z);
+    elements.push_back(element);
 }
 
-const std::vector<Atom>& Molecule::getAtoms() const {
-    return atoms;
-}
\ No newline at end of file
+void Molecule::append(const Molecule& other) {
+    const std::size_t n = other.getAtomCount();
+    if (n == 0)
+        return;
+    reserve(getAtomCount() + n);
+    xs.insert(xs.end(), other.getX(), other.getX() + n);
+    ys.insert(ys.end(), other.getY(), other.getY() + n);
+    zs.insert(zs.end(), other.getZ(), other.getZ() + n);
+    elements.insert(elements.end(), other.getElements(), other.getElements() + n);
+}
+
+void Molecule::shrinkToFit() {
+    xs.shrink_to_fit();
+    ys.shrink_to_fit();
+    zs.shrink_to_fit();
+    elements.shrink_to_fit();
+}
+
+std::size_t Molecule::getAtomCount() const {
+    return external ? viewCount : xs.size();
+}
+
+bool Molecule::empty() const {
+    return getAtomCount() == 0;
+}
+
+const float* Molecule::getX() const {
+    return external ? viewX : xs.data();
+}
+
+const float* Molecule::getY() const {
+    return external ? viewY : ys.data();
+}
+
+const float* Molecule::getZ() const {
+    return external ? viewZ : zs.data();
+}
+
+const uint8_t* Molecule::getElements() const {
+    return external ? viewElements : elements.data();
+}
+
+Atom Molecule::getAtom(std::size_t index) const {
+    Atom atom = { getX()[index], getY()[index], getZ()[index], elementSymbol(getElements()[index]) };
+    return atom;
+}
+
+uint64_t Molecule::contentHash() const {
+    std::size_t n = getAtomCount();
+    uint64_t hash = hashValue(static_cast<uint64_t>(n));
+    hash = hashBytes(getX(), n * sizeof(float), hash);
+    hash = hashBytes(getY(), n * sizeof(float), hash);
+    hash = hashBytes(getZ(), n * sizeof(float), hash);
+    return hashBytes(getElements(), n * sizeof(uint8_t), hash);
+}
+
+MoleculeArena::MoleculeArena() : bounds(1, 0) {
+}
+
+void MoleculeArena::reserve(std::size_t molecules, std::size_t atoms) {
+    bounds.reserve(molecules + 1);
+    buffer.reserve(atoms);
+}
+
+bool MoleculeArena::commit() {
+    if (buffer.getAtomCount() == bounds.back())
+        return false;
+    bounds.push_back(buffer.getAtomCount());
+    return true;
+}
+
+void MoleculeArena::shrinkToFit() {
+    buffer.shrinkToFit();
+    bounds.shrink_to_fit();
+}
+
+void MoleculeArena::release(std::vector<Molecule>& molecules) {
+    // Los átomos de una molécula sin cerrar se descartan.
+    std::shared_ptr<const Molecule> block = std::make_shared<const Molecule>(std::move(buffer));
+    molecules.reserve(molecules.size() + size());
+    for (std::size_t k = 0; k + 1 < bounds.size(); ++k) {
+        const std::size_t begin = bounds[k];
+        molecules.push_back(Molecule::view(block->getX() + begin, block->getY() + begin, block->getZ() + begin,
+                                           block->getElements() + begin, bounds[k + 1] - begin, block));
+    }
+    *this = MoleculeArena();
+}
+
+FlatMolecules flattenMolecules(const std::vector<Molecule>& molecules) {
+    FlatMolecules flat;
+    flat.counts.resize(molecules.size());
+    flat.offsets.resize(molecules.size());
+
+    std::size_t totalAtoms = 0;
+    for (std::size_t i = 0; i < molecules.size(); ++i) {
+        flat.counts[i] = static_cast<int>(molecules[i].getAtomCount());
+        flat.offsets[i] = static_cast<int>(totalAtoms);
+        totalAtoms += molecules[i].getAtomCount();
+    }
+
+    flat.x.resize(totalAtoms);
+    flat.y.resize(totalAtoms);
+    flat.z.resize(totalAtoms);
+    flat.elements.resize(totalAtoms);
+
+    // Cada molécula ya está en SoA: basta con copiar bloques contiguos.
+    for (std::size_t i = 0; i < molecules.size(); ++i) {
+        const Molecule& mol = molecules[i];
+        std::size_t n = mol.getAtomCount();
+        std::size_t off = flat.offsets[i];
+        std::copy(mol.getX(), mol.getX() + n, flat.x.begin() + off);
+        std::copy(mol.getY(), mol.getY() + n, flat.y.begin() + off);
+        std::copy(mol.getZ(), mol.getZ() + n, flat.z.begin() + off);
+        std::copy(mol.getElements(), mol.getElements() + n, flat.elements.begin() + off);
+    }
+    return flat;
+}
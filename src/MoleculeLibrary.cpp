@@ -0,0 +1,274 @@
+#include "MoleculeLibrary.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+static const uint64_t LIBRARY_MAGIC = 0x0142494C53534942ULL;   // "BISSLIB\1" en little-endian
+static const uint32_t LIBRARY_VERSION = 1;
+
+static inline uint64_t alignUp(uint64_t value) {
+    return (value + LIBRARY_ALIGNMENT - 1) & ~(LIBRARY_ALIGNMENT - 1);
+}
+
+// Calcula la posición de cada sección a partir de los tamaños.
+static LibraryHeader computeLayout(const std::vector<Molecule>& molecules, const std::vector<std::string>& names) {
+    LibraryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = LIBRARY_MAGIC;
+    header.version = LIBRARY_VERSION;
+    header.headerSize = sizeof(LibraryHeader);
+    header.numMolecules = molecules.size();
+    for (const Molecule& mol : molecules)
+        header.numAtoms += mol.getAtomCount();
+
+    const uint64_t n = header.numMolecules;
+    const uint64_t atoms = header.numAtoms;
+    uint64_t pos = alignUp(sizeof(LibraryHeader));
+    header.atomOffsetsOffset = pos;
+    pos = alignUp(pos + (n + 1) * sizeof(uint64_t));
+    header.atomCountsOffset = pos;
+    pos = alignUp(pos + n * sizeof(uint32_t));
+    header.xOffset = pos;
+    pos = alignUp(pos + atoms * sizeof(float));
+    header.yOffset = pos;
+    pos = alignUp(pos + atoms * sizeof(float));
+    header.zOffset = pos;
+    pos = alignUp(pos + atoms * sizeof(float));
+    header.elementsOffset = pos;
+    pos = pos + atoms * sizeof(uint8_t);
+    if (!names.empty()) {
+        pos = alignUp(pos);
+        header.nameOffsetsOffset = pos;
+        pos += (n + 1) * sizeof(uint64_t);
+        header.namesOffset = pos;
+        for (const std::string& name : names)
+            pos += name.size();
+    }
+    header.fileSize = pos;
+    return header;
+}
+
+// Destinos de escritura: memoria o fichero. Ambos llevan la cuenta de la posición.
+struct MemorySink {
+    char* buffer;
+    uint64_t pos;
+    bool write(const void* data, std::size_t size) {
+        if (size > 0)
+            std::memcpy(buffer + pos, data, size);
+        pos += size;
+        return true;
+    }
+};
+
+struct FileSink {
+    FILE* file;
+    uint64_t pos;
+    bool write(const void* data, std::size_t size) {
+        pos += size;
+        return size == 0 || std::fwrite(data, 1, size, file) == size;
+    }
+};
+
+template <typename Sink>
+static bool padTo(Sink& sink, uint64_t offset) {
+    static const char zeros[LIBRARY_ALIGNMENT] = {0};
+    while (sink.pos < offset) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(offset - sink.pos, LIBRARY_ALIGNMENT));
+        if (!sink.write(zeros, chunk))
+            return false;
+    }
+    return true;
+}
+
+template <typename Sink>
+static bool writeSections(Sink& sink, const LibraryHeader& header, const std::vector<Molecule>& molecules,
+                          const std::vector<std::string>& names) {
+    if (!sink.write(&header, sizeof(header)))
+        return false;
+
+    // Tabla de desplazamientos y número de átomos por molécula.
+    if (!padTo(sink, header.atomOffsetsOffset))
+        return false;
+    uint64_t atomOffset = 0;
+    for (const Molecule& mol : molecules) {
+        if (!sink.write(&atomOffset, sizeof(atomOffset)))
+            return false;
+        atomOffset += mol.getAtomCount();
+    }
+    if (!sink.write(&atomOffset, sizeof(atomOffset)) || !padTo(sink, header.atomCountsOffset))
+        return false;
+    for (const Molecule& mol : molecules) {
+        uint32_t count = static_cast<uint32_t>(mol.getAtomCount());
+        if (!sink.write(&count, sizeof(count)))
+            return false;
+    }
+
+    // Coordenadas SoA empaquetadas y códigos de elemento.
+    const uint64_t sectionOffsets[3] = { header.xOffset, header.yOffset, header.zOffset };
+    for (int axis = 0; axis < 3; ++axis) {
+        if (!padTo(sink, sectionOffsets[axis]))
+            return false;
+        for (const Molecule& mol : molecules) {
+            const float* coords = axis == 0 ? mol.getX() : (axis == 1 ? mol.getY() : mol.getZ());
+            if (!sink.write(coords, mol.getAtomCount() * sizeof(float)))
+                return false;
+        }
+    }
+    if (!padTo(sink, header.elementsOffset))
+        return false;
+    for (const Molecule& mol : molecules) {
+        if (!sink.write(mol.getElements(), mol.getAtomCount()))
+            return false;
+    }
+
+    // Nombres de origen (opcionales).
+    if (header.nameOffsetsOffset != 0) {
+        if (!padTo(sink, header.nameOffsetsOffset))
+            return false;
+        uint64_t nameOffset = 0;
+        for (const std::string& name : names) {
+            if (!sink.write(&nameOffset, sizeof(nameOffset)))
+                return false;
+            nameOffset += name.size();
+        }
+        if (!sink.write(&nameOffset, sizeof(nameOffset)))
+            return false;
+        for (const std::string& name : names) {
+            if (!sink.write(name.data(), name.size()))
+                return false;
+        }
+    }
+    return sink.pos == header.fileSize;
+}
+
+std::size_t getLibrarySize(const std::vector<Molecule>& molecules, const std::vector<std::string>& names) {
+    return static_cast<std::size_t>(computeLayout(molecules, names).fileSize);
+}
+
+void writeLibrary(const std::vector<Molecule>& molecules, const std::vector<std::string>& names,
+                  char* buffer) {
+    LibraryHeader header = computeLayout(molecules, names);
+    MemorySink sink = { buffer, 0 };
+    writeSections(sink, header, molecules, names);
+}
+
+bool saveLibrary(const std::string& filename, const std::vector<Molecule>& molecules,
+                 const std::vector<std::string>& names) {
+    if (!names.empty() && names.size() != molecules.size())
+        return false;
+    LibraryHeader header = computeLayout(molecules, names);
+
+    // Se escribe en un temporal y se renombra para no dejar librerías a medias.
+    std::string tmpName = filename + ".tmp." + std::to_string(getpid());
+    FILE* file = std::fopen(tmpName.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    FileSink sink = { file, 0 };
+    bool ok = writeSections(sink, header, molecules, names);
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Comprueba que la sección [offset, offset + bytes) cae dentro del fichero.
+static inline bool sectionFits(uint64_t offset, uint64_t bytes, std::size_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+bool readLibrary(const char* data, std::size_t size, std::shared_ptr<const void> owner,
+                 std::vector<Molecule>& molecules, std::vector<std::string>* names, std::string& error) {
+    if (size < sizeof(LibraryHeader)) {
+        error = "fichero demasiado pequeño para ser una librería";
+        return false;
+    }
+    LibraryHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != LIBRARY_MAGIC) {
+        error = "no es una librería .bslib (o tiene otro orden de bytes)";
+        return false;
+    }
+    if (header.version != LIBRARY_VERSION || header.headerSize != sizeof(LibraryHeader)) {
+        error = "versión de librería no soportada";
+        return false;
+    }
+    const uint64_t n = header.numMolecules;
+    const uint64_t atoms = header.numAtoms;
+    if (header.fileSize > size ||
+        !sectionFits(header.atomOffsetsOffset, (n + 1) * sizeof(uint64_t), size) ||
+        !sectionFits(header.atomCountsOffset, n * sizeof(uint32_t), size) ||
+        !sectionFits(header.xOffset, atoms * sizeof(float), size) ||
+        !sectionFits(header.yOffset, atoms * sizeof(float), size) ||
+        !sectionFits(header.zOffset, atoms * sizeof(float), size) ||
+        !sectionFits(header.elementsOffset, atoms, size)) {
+        error = "librería truncada o corrupta";
+        return false;
+    }
+
+    const uint64_t* atomOffsets = reinterpret_cast<const uint64_t*>(data + header.atomOffsetsOffset);
+    const uint32_t* atomCounts = reinterpret_cast<const uint32_t*>(data + header.atomCountsOffset);
+    const float* xs = reinterpret_cast<const float*>(data + header.xOffset);
+    const float* ys = reinterpret_cast<const float*>(data + header.yOffset);
+    const float* zs = reinterpret_cast<const float*>(data + header.zOffset);
+    const uint8_t* elements = reinterpret_cast<const uint8_t*>(data + header.elementsOffset);
+
+    // Los kernels indexan las tablas de parámetros con el código de elemento y las vistas
+    // no se copian, así que un código fuera de rango invalida la librería completa.
+    for (uint64_t a = 0; a < atoms; ++a) {
+        if (elements[a] >= NUM_ELEMENT_TYPES) {
+            error = "código de elemento no válido (" + std::to_string(elements[a]) + ") en el átomo " +
+                    std::to_string(a);
+            return false;
+        }
+    }
+
+    molecules.reserve(molecules.size() + n);
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t first = atomOffsets[i];
+        if (first > atoms || atomCounts[i] > atoms - first) {
+            error = "tabla de desplazamientos no válida";
+            return false;
+        }
+        molecules.push_back(Molecule::view(xs + first, ys + first, zs + first, elements + first,
+                                           atomCounts[i], owner));
+    }
+
+    if (names != nullptr) {
+        names->clear();
+        if (header.nameOffsetsOffset != 0 &&
+            sectionFits(header.nameOffsetsOffset, (n + 1) * sizeof(uint64_t), size)) {
+            const uint64_t* nameOffsets = reinterpret_cast<const uint64_t*>(data + header.nameOffsetsOffset);
+            const char* blob = data + header.namesOffset;
+            std::size_t blobSize = size - std::min<uint64_t>(header.namesOffset, size);
+            names->reserve(n);
+            for (uint64_t i = 0; i < n; ++i) {
+                uint64_t b = nameOffsets[i];
+                uint64_t e = nameOffsets[i + 1];
+                if (b > e || e > blobSize) {
+                    names->clear();
+                    break;
+                }
+                names->emplace_back(blob + b, blob + e);
+            }
+        }
+    }
+    return true;
+}
+
+bool openLibrary(const std::string& filename, std::vector<Molecule>& molecules,
+                 std::vector<std::string>* names, std::string& error) {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->open(filename, false)) {
+        error = filename + ": error abriendo archivo";
+        return false;
+    }
+    if (!readLibrary(file->data(), file->size(), file, molecules, names, error)) {
+        error = filename + ": " + error;
+        return false;
+    }
+    return true;
+}
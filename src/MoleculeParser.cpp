@@ -0,0 +1,218 @@
+#include "MoleculeParser.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Potencias de 10 exactas en double (hasta 10^18).
+static const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Recorta los espacios a ambos lados de [begin, end).
+static inline void trim(const char*& begin, const char*& end) {
+    while (begin < end && isBlank(*begin)) ++begin;
+    while (end > begin && isBlank(end[-1])) --end;
+}
+
+// Vía lenta: copia el campo a un buffer local y usa strtof.
+static bool parseFloatSlow(const char* begin, const char* end, float& value) {
+    char buffer[64];
+    std::size_t len = static_cast<std::size_t>(end - begin);
+    if (len == 0 || len >= sizeof(buffer))
+        return false;
+    std::memcpy(buffer, begin, len);
+    buffer[len] = '\0';
+    char* stop = nullptr;
+    value = std::strtof(buffer, &stop);
+    return stop == buffer + len;
+}
+
+bool parseFixedFloat(const char* begin, const char* end, float& value) {
+    trim(begin, end);
+    if (begin == end)
+        return false;
+
+    // Vía rápida: [signo] dígitos [. dígitos], como en las columnas de PDB y SDF.
+    const char* p = begin;
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+    bool seenDot = false;
+    for (; p < end; ++p) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            if (digits >= 18)
+                return parseFloatSlow(begin, end, value);
+            mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+            digits++;
+            if (seenDot)
+                fractionDigits++;
+        } else if (c == '.' && !seenDot) {
+            seenDot = true;
+        } else {
+            // Exponentes, "nan", etc.
+            return parseFloatSlow(begin, end, value);
+        }
+    }
+    if (digits == 0)
+        return false;
+
+    // mantissa < 10^18 y la potencia de 10 son exactas en double: la división da el
+    // double correctamente redondeado, que luego se convierte a float.
+    double result = static_cast<double>(mantissa) / POW10[fractionDigits];
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
+
+bool parseFixedInt(const char* begin, const char* end, int& value) {
+    trim(begin, end);
+    if (begin == end)
+        return false;
+    bool negative = false;
+    if (*begin == '-' || *begin == '+') {
+        negative = (*begin == '-');
+        ++begin;
+    }
+    if (begin == end)
+        return false;
+    long result = 0;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p < '0' || *p > '9' || result > 100000000L)
+            return false;
+        result = result * 10 + (*p - '0');
+    }
+    value = static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+// Final de la línea que empieza en 'begin' (sin incluir '\n').
+static inline const char* lineEnd(const char* begin, const char* end) {
+    const void* nl = std::memchr(begin, '\n', static_cast<std::size_t>(end - begin));
+    return nl != nullptr ? static_cast<const char*>(nl) : end;
+}
+
+// Campo de columnas [from, from + width) de la línea [begin, end), recortado a la línea.
+static inline void column(const char* begin, const char* end, std::size_t from, std::size_t width,
+                          const char*& fieldBegin, const char*& fieldEnd) {
+    std::size_t len = static_cast<std::size_t>(end - begin);
+    fieldBegin = begin + (from < len ? from : len);
+    fieldEnd = begin + (from + width < len ? from + width : len);
+}
+
+// Código de elemento de las columnas [from, from + width), o desconocido si la línea
+// no llega a 'minLength' caracteres.
+static inline uint8_t elementColumn(const char* begin, const char* end, std::size_t from,
+                                    std::size_t width, std::size_t minLength) {
+    if (static_cast<std::size_t>(end - begin) < minLength)
+        return ELEMENT_UNKNOWN;
+    const char* fb;
+    const char* fe;
+    column(begin, end, from, width, fb, fe);
+    trim(fb, fe);
+    return elementCode(fb, static_cast<std::size_t>(fe - fb));
+}
+
+static void recordError(ParseStatus& status, const char* message, const char* line, const char* lineEndPtr) {
+    if (status.badLines == 0) {
+        status.firstError = message;
+        status.firstError += ": \"";
+        status.firstError.append(line, static_cast<std::size_t>(lineEndPtr - line));
+        status.firstError += "\"";
+    }
+    status.badLines++;
+}
+
+ParseStatus parsePDBBuffer(const char* begin, const char* end, Molecule& mol) {
+    ParseStatus status;
+    // Las líneas PDB ocupan 80 columnas: se reserva una cota superior del número de átomos
+    // (a continuación de los que ya tenga 'mol').
+    mol.reserve(mol.getAtomCount() + static_cast<std::size_t>(end - begin) / 81 + 1);
+
+    for (const char* line = begin; line < end; ) {
+        const char* eol = lineEnd(line, end);
+        const char* next = eol < end ? eol + 1 : end;
+        std::size_t len = static_cast<std::size_t>(eol - line);
+        // Verificar que la línea comience con "ATOM" o "HETATM"
+        bool isAtom = (len >= 4 && std::memcmp(line, "ATOM", 4) == 0) ||
+                      (len >= 6 && std::memcmp(line, "HETATM", 6) == 0);
+        if (isAtom) {
+            // Coordenadas en columnas fijas según el estándar PDB (31-38, 39-46, 47-54)
+            const char *xb, *xe, *yb, *ye, *zb, *ze;
+            column(line, eol, 30, 8, xb, xe);
+            column(line, eol, 38, 8, yb, ye);
+            column(line, eol, 46, 8, zb, ze);
+            float x, y, z;
+            if (parseFixedFloat(xb, xe, x) && parseFixedFloat(yb, ye, y) && parseFixedFloat(zb, ze, z)) {
+                // Símbolo del elemento en columnas 77-78
+                mol.addAtom(x, y, z, elementColumn(line, eol, 76, 2, 78));
+                status.atoms++;
+            } else {
+                recordError(status, "coordenadas no válidas", line, eol);
+            }
+        }
+        line = next;
+    }
+    return status;
+}
+
+const char* parseSDFRecord(const char* begin, const char* end, Molecule& mol, ParseStatus& status) {
+    const char* line = begin;
+    // Omitir las 3 líneas de cabecera
+    for (int i = 0; i < 3 && line < end; ++i) {
+        const char* eol = lineEnd(line, end);
+        line = eol < end ? eol + 1 : end;
+    }
+
+    // La cuarta línea es la línea de conteo (número de átomos en las columnas 1-3)
+    int numAtoms = 0;
+    if (line >= end) {
+        recordError(status, "falta la línea de conteo", line, line);
+        return end;
+    }
+    const char* eol = lineEnd(line, end);
+    const char *cb, *ce;
+    column(line, eol, 0, 3, cb, ce);
+    if (!parseFixedInt(cb, ce, numAtoms) || numAtoms < 0) {
+        recordError(status, "número de átomos no válido", line, eol);
+        numAtoms = 0;
+    }
+    line = eol < end ? eol + 1 : end;
+
+    // Sección de átomos (V2000): X 1-10, Y 11-20, Z 21-30, elemento 32-34
+    mol.reserve(mol.getAtomCount() + static_cast<std::size_t>(numAtoms));
+    for (int i = 0; i < numAtoms && line < end; ++i) {
+        eol = lineEnd(line, end);
+        const char *xb, *xe, *yb, *ye, *zb, *ze;
+        column(line, eol, 0, 10, xb, xe);
+        column(line, eol, 10, 10, yb, ye);
+        column(line, eol, 20, 10, zb, ze);
+        float x, y, z;
+        if (parseFixedFloat(xb, xe, x) && parseFixedFloat(yb, ye, y) && parseFixedFloat(zb, ze, z)) {
+            mol.addAtom(x, y, z, elementColumn(line, eol, 31, 3, 34));
+            status.atoms++;
+        } else {
+            recordError(status, "átomo no válido", line, eol);
+        }
+        line = eol < end ? eol + 1 : end;
+    }
+
+    // Saltar el resto del registro (enlaces, propiedades) hasta "$$$$".
+    while (line < end) {
+        eol = lineEnd(line, end);
+        const char* next = eol < end ? eol + 1 : end;
+        if (eol - line >= 4 && std::memcmp(line, "$$$$", 4) == 0)
+            return next;
+        line = next;
+    }
+    return end;
+}
@@ -0,0 +1,212 @@
+#include "Octree.h"
+#include "DockingKernels.h"
+#include <algorithm>
+#include <cmath>
+
+ProteinOctree::ProteinOctree() : forceField(FORCEFIELD_UNIFORM) {}
+
+void ProteinOctree::build(const Molecule& protein, ForceField forceField) {
+    this->forceField = forceField;
+    nodes.clear();
+    const std::size_t numAtoms = protein.getAtomCount();
+    if (numAtoms == 0) {
+        x.clear(); y.clear(); z.clear(); elements.clear();
+        return;
+    }
+
+    // Cubo envolvente de la proteína (raíz del árbol).
+    const float* coords[3] = { protein.getX(), protein.getY(), protein.getZ() };
+    float center[3];
+    float half = 0.0f;
+    for (int d = 0; d < 3; ++d) {
+        const auto range = std::minmax_element(coords[d], coords[d] + numAtoms);
+        center[d] = 0.5f * (*range.first + *range.second);
+        half = std::max(half, 0.5f * (*range.second - *range.first));
+    }
+    half = std::max(half, 1e-3f);
+
+    std::vector<uint32_t> order(numAtoms);
+    for (std::size_t k = 0; k < numAtoms; ++k)
+        order[k] = static_cast<uint32_t>(k);
+    std::vector<uint32_t> scratch(numAtoms);
+    buildNode(order, scratch, protein, 0, static_cast<uint32_t>(numAtoms), center, half, 0);
+
+    // Átomos en el orden del árbol: los de cada hoja quedan contiguos.
+    x.resize(numAtoms); y.resize(numAtoms); z.resize(numAtoms); elements.resize(numAtoms);
+    const uint8_t* pe = protein.getElements();
+    for (std::size_t k = 0; k < numAtoms; ++k) {
+        x[k] = coords[0][order[k]];
+        y[k] = coords[1][order[k]];
+        z[k] = coords[2][order[k]];
+        elements[k] = pe[order[k]];
+    }
+}
+
+uint32_t ProteinOctree::buildNode(std::vector<uint32_t>& order, std::vector<uint32_t>& scratch,
+                                  const Molecule& protein, uint32_t begin, uint32_t end,
+                                  const float center[3], float half, int depth) {
+    const SeparableLJ& coefficients = separableCoefficients(forceField);
+    const float* px = protein.getX();
+    const float* py = protein.getY();
+    const float* pz = protein.getZ();
+    const uint8_t* pe = protein.getElements();
+
+    // Pseudo-átomo del subárbol.
+    float sx = 0.0f, sy = 0.0f, sz = 0.0f, sa = 0.0f, sb = 0.0f;
+    for (uint32_t k = begin; k < end; ++k) {
+        const uint32_t atom = order[k];
+        const float weight = coefficients.b[pe[atom]];
+        sx += weight * px[atom];
+        sy += weight * py[atom];
+        sz += weight * pz[atom];
+        sa += coefficients.a[pe[atom]];
+        sb += weight;
+    }
+    const uint32_t index = static_cast<uint32_t>(nodes.size());
+    Node node;
+    const float invWeight = sb > 0.0f ? 1.0f / sb : 0.0f;
+    node.x = sx * invWeight;
+    node.y = sy * invWeight;
+    node.z = sz * invWeight;
+    float radius2 = 0.0f;
+    for (uint32_t k = begin; k < end; ++k) {
+        const uint32_t atom = order[k];
+        const float dx = px[atom] - node.x;
+        const float dy = py[atom] - node.y;
+        const float dz = pz[atom] - node.z;
+        radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+    }
+    node.diameter2 = 4.0f * radius2;
+    node.a = sa;
+    node.b = sb;
+    node.begin = begin;
+    node.end = end;
+    node.skip = 0;
+    node.leaf = end - begin <= OCTREE_LEAF_ATOMS || depth >= OCTREE_MAX_DEPTH;
+    nodes.push_back(node);
+
+    if (!nodes[index].leaf) {
+        // Reparto por octantes (ordenación por conteo sobre 'scratch').
+        uint32_t counts[9] = {};
+        for (uint32_t k = begin; k < end; ++k) {
+            const uint32_t atom = order[k];
+            const int octant = (px[atom] >= center[0] ? 1 : 0) | (py[atom] >= center[1] ? 2 : 0) |
+                               (pz[atom] >= center[2] ? 4 : 0);
+            counts[octant + 1]++;
+        }
+        for (int o = 0; o < 8; ++o)
+            counts[o + 1] += counts[o];
+        uint32_t next[8];
+        std::copy(counts, counts + 8, next);
+        for (uint32_t k = begin; k < end; ++k) {
+            const uint32_t atom = order[k];
+            const int octant = (px[atom] >= center[0] ? 1 : 0) | (py[atom] >= center[1] ? 2 : 0) |
+                               (pz[atom] >= center[2] ? 4 : 0);
+            scratch[begin + next[octant]++] = atom;
+        }
+        std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+        const float childHalf = 0.5f * half;
+        for (int o = 0; o < 8; ++o) {
+            if (counts[o + 1] == counts[o])
+                continue;
+            const float childCenter[3] = {
+                center[0] + ((o & 1) ? childHalf : -childHalf),
+                center[1] + ((o & 2) ? childHalf : -childHalf),
+                center[2] + ((o & 4) ? childHalf : -childHalf)
+            };
+            buildNode(order, scratch, protein, begin + counts[o], begin + counts[o + 1], childCenter, childHalf,
+                      depth + 1);
+        }
+    }
+    nodes[index].skip = static_cast<uint32_t>(nodes.size());
+    return index;
+}
+
+// Un solo recorrido en preorden por ligando, con su esfera envolvente (centroide c, radio
+// R): un nodo está lejos de todos los átomos del ligando si diámetro < theta (d - R), con d
+// la distancia de c al nodo. Un nodo lejano aporta su pseudo-átomo frente a cada átomo del
+// ligando, A a_l / r^12 - B b_l / r^6, y se salta su subárbol; una hoja cercana añade sus
+// átomos a la lista de tramos exactos; un nodo interno cercano se abre bajando a su primer
+// hijo. Las hojas consecutivas en el orden del árbol forman un solo tramo, que se evalúa
+// contra el ligando completo con el kernel SIMD de DockingKernels.h.
+float ProteinOctree::energy(const Molecule& ligand, float theta, std::size_t* interactions) const {
+    if (interactions != nullptr)
+        *interactions = 0;
+    if (nodes.empty() || ligand.empty())
+        return 0.0f;
+
+    const SeparableLJ& coefficients = separableCoefficients(forceField);
+    const LJKernelFn kernel = getLJKernel(forceField);
+    const std::size_t numLigandAtoms = ligand.getAtomCount();
+    const float* lx = ligand.getX();
+    const float* ly = ligand.getY();
+    const float* lz = ligand.getZ();
+    const uint8_t* le = ligand.getElements();
+
+    float cx = 0.0f, cy = 0.0f, cz = 0.0f;
+    for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+        cx += lx[i];
+        cy += ly[i];
+        cz += lz[i];
+    }
+    const float invAtoms = 1.0f / static_cast<float>(numLigandAtoms);
+    cx *= invAtoms;
+    cy *= invAtoms;
+    cz *= invAtoms;
+    float radius2 = 0.0f;
+    for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+        const float dx = lx[i] - cx;
+        const float dy = ly[i] - cy;
+        const float dz = lz[i] - cz;
+        radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+    }
+    const float radius = std::sqrt(radius2);
+
+    const Node* tree = nodes.data();
+    const uint32_t numNodes = static_cast<uint32_t>(nodes.size());
+    float energy = 0.0f;
+    std::size_t partners = 0;   // Nodos lejanos y átomos de hojas frente a cada átomo del ligando
+    uint32_t runBegin = 0, runEnd = 0;
+    uint32_t n = 0;
+    while (n < numNodes) {
+        const Node& node = tree[n];
+        const float dx = cx - node.x;
+        const float dy = cy - node.y;
+        const float dz = cz - node.z;
+        const float gap = std::sqrt(dx * dx + dy * dy + dz * dz) - radius;
+        if (gap > 0.0f && node.diameter2 < theta * theta * gap * gap) {
+            for (std::size_t i = 0; i < numLigandAtoms; ++i) {
+                const float ax = lx[i] - node.x;
+                const float ay = ly[i] - node.y;
+                const float az = lz[i] - node.z;
+                const float inv2 = 1.0f / (ax * ax + ay * ay + az * az);
+                const float inv6 = inv2 * inv2 * inv2;
+                energy += inv6 * (coefficients.a[le[i]] * node.a * inv6 - coefficients.b[le[i]] * node.b);
+            }
+            partners++;
+            n = node.skip;
+        } else if (node.leaf) {
+            if (node.begin != runEnd) {
+                partners += runEnd - runBegin;
+                energy += kernel(lx, ly, lz, le, numLigandAtoms, &x[runBegin], &y[runBegin], &z[runBegin],
+                                 &elements[runBegin], runEnd - runBegin);
+                runBegin = node.begin;
+            }
+            runEnd = node.end;
+            n = node.skip;
+        } else {
+            n++;
+        }
+    }
+    energy += kernel(lx, ly, lz, le, numLigandAtoms, &x[runBegin], &y[runBegin], &z[runBegin],
+                     &elements[runBegin], runEnd - runBegin);
+    partners += runEnd - runBegin;
+    if (interactions != nullptr)
+        *interactions = partners * numLigandAtoms;
+    return energy;
+}
+
+std::size_t ProteinOctree::getBytes() const {
+    return nodes.size() * sizeof(Node) + x.size() * (3 * sizeof(float) + sizeof(uint8_t));
+}
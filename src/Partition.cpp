@@ -0,0 +1,105 @@
+#include "Partition.h"
+#include <algorithm>
+
+PairCostModel::PairCostModel(const std::vector<Molecule>& proteins, const std::vector<Molecule>& ligands,
+                             const DockingParams& params)
+    : numLigands(ligands.size()), numPairs(proteins.size() * ligands.size()) {
+    // Con corte o rejillas cada átomo del ligando visita un número acotado de átomos.
+    const bool local = params.useCutoff() || params.grid.enabled;
+
+    ligandPrefix.resize(ligands.size() + 1, 0.0);
+    for (std::size_t j = 0; j < ligands.size(); ++j)
+        ligandPrefix[j + 1] = ligandPrefix[j] + static_cast<double>(ligands[j].getAtomCount());
+
+    const double ligandAtoms = ligandPrefix.back();
+    proteinWeight.resize(proteins.size());
+    rowPrefix.resize(proteins.size() + 1, 0.0);
+    for (std::size_t i = 0; i < proteins.size(); ++i) {
+        proteinWeight[i] = local ? 1.0 : static_cast<double>(proteins[i].getAtomCount());
+        rowPrefix[i + 1] = rowPrefix[i] + proteinWeight[i] * ligandAtoms +
+                           PAIR_OVERHEAD_COST * static_cast<double>(numLigands);
+    }
+}
+
+double PairCostModel::pairCost(std::size_t proteinIndex, std::size_t ligandIndex) const {
+    return proteinWeight[proteinIndex] * (ligandPrefix[ligandIndex + 1] - ligandPrefix[ligandIndex]) +
+           PAIR_OVERHEAD_COST;
+}
+
+double PairCostModel::prefixCost(std::size_t idx) const {
+    if (numLigands == 0)
+        return 0.0;
+    if (idx >= numPairs)
+        return rowPrefix.back();
+    const std::size_t i = idx / numLigands;
+    const std::size_t j = idx % numLigands;
+    return rowPrefix[i] + proteinWeight[i] * ligandPrefix[j] + PAIR_OVERHEAD_COST * static_cast<double>(j);
+}
+
+std::size_t PairCostModel::indexAtCost(double target) const {
+    if (numPairs == 0 || target <= 0.0)
+        return 0;
+    if (target >= rowPrefix.back())
+        return numPairs;
+
+    // Fila: la última i con rowPrefix[i] < target.
+    std::size_t i = static_cast<std::size_t>(
+        std::lower_bound(rowPrefix.begin(), rowPrefix.end(), target) - rowPrefix.begin()) - 1;
+    // Columna: búsqueda binaria de la primera j con prefixCost(i, j) >= target.
+    std::size_t lo = 0;
+    std::size_t hi = numLigands;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (prefixCost(i * numLigands + mid) < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return i * numLigands + lo;
+}
+
+std::vector<std::size_t> PairCostModel::splitRange(std::size_t begin, std::size_t end, std::size_t parts) const {
+    std::vector<std::size_t> bounds(parts + 1, begin);
+    bounds[parts] = end;
+    const double first = prefixCost(begin);
+    const double cost = prefixCost(end) - first;
+    for (std::size_t k = 1; k < parts; ++k) {
+        std::size_t idx = indexAtCost(first + cost * static_cast<double>(k) / static_cast<double>(parts));
+        bounds[k] = std::min(end, std::max(bounds[k - 1], idx));
+    }
+    return bounds;
+}
+
+std::vector<PairRange> PairCostModel::splitRanges(const std::vector<PairRange>& ranges, std::size_t parts) const {
+    double cost = 0.0;
+    for (const PairRange& range : ranges)
+        cost += rangeCost(range.begin, range.end);
+
+    std::vector<PairRange> units;
+    for (const PairRange& range : ranges) {
+        if (range.begin >= range.end)
+            continue;
+        // Partes proporcionales al coste del rango, sin exceder su número de pares.
+        double share = cost > 0.0 ? rangeCost(range.begin, range.end) / cost : 0.0;
+        std::size_t rangeParts = static_cast<std::size_t>(share * static_cast<double>(parts) + 0.5);
+        rangeParts = std::min(range.end - range.begin, std::max<std::size_t>(1, rangeParts));
+        std::vector<std::size_t> bounds = splitRange(range.begin, range.end, rangeParts);
+        for (std::size_t k = 0; k < rangeParts; ++k) {
+            if (bounds[k] < bounds[k + 1])
+                units.push_back(PairRange{ bounds[k], bounds[k + 1] });
+        }
+    }
+    return units;
+}
+
+double loadImbalance(const std::vector<double>& times) {
+    if (times.empty())
+        return 1.0;
+    double maxTime = 0.0;
+    double sum = 0.0;
+    for (double t : times) {
+        maxTime = std::max(maxTime, t);
+        sum += t;
+    }
+    return sum > 0.0 ? maxTime * static_cast<double>(times.size()) / sum : 1.0;
+}
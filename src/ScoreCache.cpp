@@ -0,0 +1,206 @@
+#include "ScoreCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cabecera del fichero de la caché de scores.
+static const uint32_t SCORE_CACHE_MAGIC = 0x43535342;  // "BSSC"
+static const uint32_t SCORE_CACHE_VERSION = 1;
+static const char* SCORE_CACHE_FILE = "/scores.bssc";
+static const char* SCORE_CACHE_LOCK = "/scores.lock";
+static const uint64_t SCORE_CACHE_MIN_CAPACITY = 1024;
+
+struct ScoreCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t count;
+};
+
+struct ScoreCacheSlot {
+    uint64_t key;
+    float score;
+    uint32_t reserved;
+};
+
+static std::atomic<uint64_t> nextCacheId(1);
+
+// Comprueba la cabecera y el tamaño de una tabla proyectada.
+static bool validTable(const MappedFile& file, ScoreCacheHeader& header) {
+    if (file.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    return header.magic == SCORE_CACHE_MAGIC && header.version == SCORE_CACHE_VERSION &&
+           header.capacity > 0 && (header.capacity & (header.capacity - 1)) == 0 &&
+           file.size() == sizeof(header) + header.capacity * sizeof(ScoreCacheSlot);
+}
+
+// Inserta en 'slots' (sondeo lineal). Devuelve false si la clave ya estaba.
+static bool insertSlot(std::vector<ScoreCacheSlot>& slots, uint64_t key, float score) {
+    const uint64_t mask = slots.size() - 1;
+    for (uint64_t i = key & mask;; i = (i + 1) & mask) {
+        if (slots[i].key == key)
+            return false;
+        if (slots[i].key == 0) {
+            slots[i].key = key;
+            slots[i].score = score;
+            return true;
+        }
+    }
+}
+
+ScoreCache::ScoreCache()
+    : slots(nullptr), mask(0), entries(0), stored(0), id(nextCacheId++) {
+}
+
+ScoreCache::~ScoreCache() {
+    close();
+}
+
+bool ScoreCache::open(const std::string& directory) {
+    close();
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+        return false;
+    dir = directory;
+    ScoreCacheHeader header;
+    if (table.open(dir + SCORE_CACHE_FILE, false) && validTable(table, header)) {
+        slots = table.data() + sizeof(header);
+        mask = header.capacity - 1;
+        entries = header.count;
+    } else {
+        table.close();
+    }
+    return true;
+}
+
+bool ScoreCache::lookup(uint64_t key, float& score) const {
+    if (slots == nullptr)
+        return false;
+    const ScoreCacheSlot* table = static_cast<const ScoreCacheSlot*>(slots);
+    for (uint64_t i = key & mask;; i = (i + 1) & mask) {
+        if (table[i].key == key) {
+            score = table[i].score;
+            return true;
+        }
+        if (table[i].key == 0)
+            return false;
+    }
+}
+
+std::vector<ScoreCache::Entry>& ScoreCache::threadBuffer() {
+    // Cada hilo guarda el buffer que le corresponde en la última caché usada; 'id' cambia
+    // al cerrar, así que nunca se reutiliza un buffer ya liberado.
+    static thread_local uint64_t owner = 0;
+    static thread_local std::vector<Entry>* buffer = nullptr;
+    if (owner != id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.emplace_back(new std::vector<Entry>());
+        buffer = buffers.back().get();
+        buffer->reserve(SCORE_CACHE_BATCH);
+        owner = id;
+    }
+    return *buffer;
+}
+
+void ScoreCache::insert(uint64_t key, float score) {
+    std::vector<Entry>& buffer = threadBuffer();
+    buffer.push_back({ key, score });
+    if (buffer.size() < SCORE_CACHE_BATCH)
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.insert(queue.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+    if (queue.size() >= SCORE_CACHE_FLUSH_ENTRIES) {
+        if (!merge(queue))
+            std::cerr << "No se pudo escribir la caché de scores en " << dir << std::endl;
+        queue.clear();
+    }
+}
+
+bool ScoreCache::merge(const std::vector<Entry>& added) {
+    const std::string filename = dir + SCORE_CACHE_FILE;
+    const int lockFd = ::open((dir + SCORE_CACHE_LOCK).c_str(), O_RDWR | O_CREAT, 0644);
+    if (lockFd < 0)
+        return false;
+    flock(lockFd, LOCK_EX);
+
+    // Se parte de la tabla actual del fichero: otro proceso puede haberla ampliado
+    // después de open().
+    MappedFile current;
+    ScoreCacheHeader header;
+    const bool hasCurrent = current.open(filename, true) && validTable(current, header);
+    const ScoreCacheSlot* currentSlots =
+        hasCurrent ? reinterpret_cast<const ScoreCacheSlot*>(current.data() + sizeof(header)) : nullptr;
+    const uint64_t currentCapacity = hasCurrent ? header.capacity : 0;
+    const uint64_t currentCount = hasCurrent ? header.count : 0;
+
+    uint64_t capacity = std::max(currentCapacity, SCORE_CACHE_MIN_CAPACITY);
+    while (capacity < 2 * (currentCount + added.size()))
+        capacity *= 2;
+    std::vector<ScoreCacheSlot> merged(capacity);
+    std::memset(merged.data(), 0, capacity * sizeof(ScoreCacheSlot));
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < currentCapacity; ++i) {
+        if (currentSlots[i].key != 0)
+            count += insertSlot(merged, currentSlots[i].key, currentSlots[i].score) ? 1 : 0;
+    }
+    uint64_t inserted = 0;
+    for (const Entry& entry : added)
+        inserted += insertSlot(merged, entry.key, entry.score) ? 1 : 0;
+    count += inserted;
+    current.close();
+
+    // Se escribe en un temporal y se renombra: las proyecciones abiertas siguen viendo
+    // la tabla anterior completa.
+    std::memset(&header, 0, sizeof(header));
+    header.magic = SCORE_CACHE_MAGIC;
+    header.version = SCORE_CACHE_VERSION;
+    header.capacity = capacity;
+    header.count = count;
+    const std::string tmpName = filename + ".tmp." + std::to_string(getpid());
+    bool ok = false;
+    FILE* file = std::fopen(tmpName.c_str(), "wb");
+    if (file != nullptr) {
+        ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+             std::fwrite(merged.data(), sizeof(ScoreCacheSlot), capacity, file) == capacity;
+        ok = std::fflush(file) == 0 && ok;
+        ok = fdatasync(fileno(file)) == 0 && ok;
+        ok = (std::fclose(file) == 0) && ok;
+        if (!ok || std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+            std::remove(tmpName.c_str());
+            ok = false;
+        }
+    }
+    flock(lockFd, LOCK_UN);
+    ::close(lockFd);
+    if (ok)
+        stored += inserted;
+    return ok;
+}
+
+void ScoreCache::close() {
+    if (!isOpen())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::unique_ptr<std::vector<Entry>>& buffer : buffers)
+            queue.insert(queue.end(), buffer->begin(), buffer->end());
+        buffers.clear();
+        if (!queue.empty() && !merge(queue))
+            std::cerr << "No se pudo escribir la caché de scores en " << dir << std::endl;
+        queue.clear();
+    }
+    table.close();
+    slots = nullptr;
+    mask = 0;
+    entries = 0;
+    dir.clear();
+    id = nextCacheId++;
+}
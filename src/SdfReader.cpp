@@ -0,0 +1,195 @@
+#include "SdfReader.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Tamaño inicial del buffer de lectura.
+static const std::size_t SDF_BUFFER_BYTES = 1 << 20;
+
+std::vector<ByteRange> splitByteRanges(uint64_t fileSize, uint64_t chunkSize) {
+    std::vector<ByteRange> ranges;
+    if (chunkSize == 0)
+        chunkSize = fileSize;
+    uint64_t begin = 0;
+    do {
+        uint64_t end = (fileSize - begin > chunkSize) ? begin + chunkSize : fileSize;
+        ranges.push_back(ByteRange{ begin, end });
+        begin = end;
+    } while (begin < fileSize);
+    return ranges;
+}
+
+// Línea separadora de registros ("$$$$", con lo que venga detrás).
+static inline bool isSeparator(const char* line, std::size_t length) {
+    return length >= 4 && std::memcmp(line, "$$$$", 4) == 0;
+}
+
+static inline bool isBlankLine(const char* line, std::size_t length) {
+    for (std::size_t i = 0; i < length; ++i) {
+        if (line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+            return false;
+    }
+    return true;
+}
+
+SdfReader::SdfReader()
+    : fd(-1), head(0), tail(0), bufferOffset(0), rangeEnd(0), recordOffset(0), eof(true), done(true) {
+}
+
+SdfReader::~SdfReader() {
+    close();
+}
+
+bool SdfReader::open(const std::string& filename, uint64_t begin, uint64_t end) {
+    close();
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = filename + ": error abriendo archivo";
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    buffer.resize(SDF_BUFFER_BYTES);
+    head = tail = 0;
+    bufferOffset = 0;
+    rangeEnd = end;
+    recordOffset = 0;
+    eof = false;
+    done = (begin >= end);
+    error.clear();
+    if (!done && !synchronize(begin))
+        done = true;
+    return error.empty();
+}
+
+void SdfReader::close() {
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    eof = true;
+    done = true;
+}
+
+bool SdfReader::fill() {
+    if (eof)
+        return false;
+    if (head > 0) {
+        std::memmove(buffer.data(), buffer.data() + head, tail - head);
+        bufferOffset += head;
+        tail -= head;
+        head = 0;
+    }
+    // Sólo crece si un registro no cabe en el buffer actual.
+    if (tail == buffer.size())
+        buffer.resize(buffer.size() * 2);
+
+    ssize_t n;
+    do {
+        n = ::read(fd, buffer.data() + tail, buffer.size() - tail);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        error = std::string("error de lectura: ") + std::strerror(errno);
+        eof = true;
+        return false;
+    }
+    if (n == 0) {
+        eof = true;
+        return false;
+    }
+    tail += static_cast<std::size_t>(n);
+    return true;
+}
+
+bool SdfReader::findLineEnd(std::size_t& scan) {
+    for (;;) {
+        std::size_t available = tail - head;
+        if (scan < available) {
+            const void* nl = std::memchr(buffer.data() + head + scan, '\n', available - scan);
+            if (nl != nullptr) {
+                scan = static_cast<std::size_t>(static_cast<const char*>(nl) - (buffer.data() + head));
+                return true;
+            }
+        }
+        scan = available;
+        // fill() descarta lo consumido pero 'scan' es relativo a 'head', sigue siendo válido.
+        if (!fill())
+            return false;
+    }
+}
+
+bool SdfReader::synchronize(uint64_t begin) {
+    if (begin == 0)
+        return true;
+
+    // Se empieza un byte antes para saber si 'begin' es ya el comienzo de una línea.
+    if (lseek(fd, static_cast<off_t>(begin - 1), SEEK_SET) < 0) {
+        error = std::string("error de posicionamiento: ") + std::strerror(errno);
+        return false;
+    }
+    bufferOffset = begin - 1;
+    std::size_t scan = 0;
+    if (!findLineEnd(scan))
+        return false;
+    head += scan + 1;
+
+    // Descartar líneas hasta la primera "$$$$" que empieza dentro del rango.
+    for (;;) {
+        if (bufferOffset + head >= rangeEnd)
+            return false;
+        scan = 0;
+        bool newline = findLineEnd(scan);
+        bool separator = isSeparator(buffer.data() + head, scan);
+        head += newline ? scan + 1 : scan;
+        if (separator)
+            return true;
+        if (!newline)
+            return false;
+    }
+}
+
+bool SdfReader::next(Molecule& mol, ParseStatus& status) {
+    for (;;) {
+        if (done)
+            return false;
+        if (head == tail && !fill()) {
+            done = true;
+            return false;
+        }
+
+        // Delimitar el registro completo (hasta su "$$$$" o el final del fichero).
+        std::size_t scan = 0;
+        std::size_t length = 0;
+        bool separator = false;
+        bool blank = true;
+        uint64_t separatorOffset = 0;
+        for (;;) {
+            std::size_t lineBegin = scan;
+            bool newline = findLineEnd(scan);
+            const char* line = buffer.data() + head + lineBegin;
+            std::size_t lineLength = scan - lineBegin;
+            if (isSeparator(line, lineLength)) {
+                separator = true;
+                separatorOffset = bufferOffset + head + lineBegin;
+                length = newline ? scan + 1 : scan;
+                break;
+            }
+            blank = blank && isBlankLine(line, lineLength);
+            if (!newline) {
+                length = scan;
+                break;
+            }
+            scan++;
+        }
+
+        recordOffset = bufferOffset + head;
+        const char* begin = buffer.data() + head;
+        head += length;
+        // El registro siguiente pertenece al rango en que empieza este separador.
+        if (!separator || separatorOffset >= rangeEnd)
+            done = true;
+        if (!blank) {
+            parseSDFRecord(begin, begin + length, mol, status);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+bool traceActive = false;
+
+// Se inicializa al arrancar el programa, antes de main.
+static const std::chrono::steady_clock::time_point traceOrigin = std::chrono::steady_clock::now();
+
+// Buffer circular de un hilo: sólo lo escribe su hilo y sólo se lee al final.
+struct TraceBuffer {
+    std::vector<TraceEvent> events;
+    uint64_t written = 0;
+};
+
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> registry;
+static thread_local TraceBuffer* threadBuffer = nullptr;
+
+void startTracing() {
+    traceActive = true;
+}
+
+uint64_t traceClock() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceOrigin).count());
+}
+
+void recordTraceEvent(const char* name, const char* category, uint64_t start, uint64_t end,
+                      uint64_t begin, uint64_t finish) {
+    if (threadBuffer == nullptr) {
+        std::unique_ptr<TraceBuffer> buffer(new TraceBuffer());
+        buffer->events.resize(TRACE_BUFFER_EVENTS);
+        threadBuffer = buffer.get();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(std::move(buffer));
+    }
+    TraceBuffer& buffer = *threadBuffer;
+    buffer.events[buffer.written % TRACE_BUFFER_EVENTS] = TraceEvent{ name, category, start, end, begin, finish };
+    buffer.written++;
+}
+
+// Microsegundos (la unidad de la traza) con el desplazamiento aplicado.
+static double traceMicros(uint64_t ns, int64_t offsetNs) {
+    return (static_cast<double>(ns) + static_cast<double>(offsetNs)) / 1000.0;
+}
+
+std::string formatTraceEvents(int pid, const std::string& processName, int64_t offsetNs, uint64_t& dropped) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    dropped = 0;
+    std::string out;
+    char line[512];
+    std::snprintf(line, sizeof(line),
+                  "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, \"args\": {\"name\": \"%s\"}}",
+                  pid, processName.c_str());
+    out += line;
+
+    for (std::size_t t = 0; t < registry.size(); ++t) {
+        const TraceBuffer& buffer = *registry[t];
+        std::snprintf(line, sizeof(line),
+                      ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %zu, \"args\": {\"name\": \"thread %zu\"}}",
+                      pid, t, t);
+        out += line;
+
+        // Del más antiguo al más reciente de los que siguen en el buffer.
+        const uint64_t kept = std::min<uint64_t>(buffer.written, TRACE_BUFFER_EVENTS);
+        dropped += buffer.written - kept;
+        for (uint64_t k = buffer.written - kept; k < buffer.written; ++k) {
+            const TraceEvent& event = buffer.events[k % TRACE_BUFFER_EVENTS];
+            int n = std::snprintf(line, sizeof(line),
+                                  ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %zu, "
+                                  "\"ts\": %.3f, \"dur\": %.3f",
+                                  event.name, event.category, pid, t, traceMicros(event.start, offsetNs),
+                                  (event.end - event.start) / 1000.0);
+            out.append(line, static_cast<std::size_t>(n));
+            if (event.finish > event.begin) {
+                n = std::snprintf(line, sizeof(line), ", \"args\": {\"begin\": %llu, \"end\": %llu}",
+                                  static_cast<unsigned long long>(event.begin),
+                                  static_cast<unsigned long long>(event.finish));
+                out.append(line, static_cast<std::size_t>(n));
+            }
+            out += '}';
+        }
+    }
+    return out;
+}
+
+bool writeChromeTrace(const std::string& filename, const std::vector<std::string>& processes) {
+    FILE* out = std::fopen(filename.c_str(), "w");
+    if (out == nullptr)
+        return false;
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", out);
+    bool first = true;
+    for (const std::string& events : processes) {
+        if (events.empty())
+            continue;
+        if (!first)
+            std::fputs(",\n", out);
+        std::fwrite(events.data(), 1, events.size(), out);
+        first = false;
+    }
+    std::fputs("\n]}\n", out);
+    return std::fclose(out) == 0;
+}
@@ -1,8 +1,17 @@
 #include "Utils.h"
+#include "DataManager.h"
 #include "Docking.h"   // To use DockingResult
+#include "DockingKernels.h"
+#include "IncrementalResults.h"
+#include "Metrics.h"
+#include "Partition.h"
+#include "Trace.h"
 #include <algorithm>
+#include <cstdlib>
+#include <limits>
 #include <vector>
 #include <iostream>
+#include <sys/stat.h>
 
 Timer::Timer() {}
 
@@ -23,16 +32,18 @@ void logMessage(const std::string& msg) {
 }
 
 void analyzeDockingResults(const std::vector<float>& scores, int numProteins, int numLigands) {
+    ScopedPhase phase(PHASE_RANK);
     if (scores.empty() || numProteins <= 0 || numLigands <= 0) {
         std::cerr << "No docking results to analyze." << std::endl;
         return;
     }
     
     // Determine the pair with the optimal score (lower score = better affinity).
+    // Pairs discarded by the funnel have no score (NaN) and are skipped.
     int bestIndex = 0;
     float bestScore = scores[0];
     for (size_t idx = 1; idx < scores.size(); ++idx) {
-        if (scores[idx] < bestScore) {
+        if (scores[idx] < bestScore || !(bestScore == bestScore)) {
             bestScore = scores[idx];
             bestIndex = idx;
         }
@@ -45,36 +56,245 @@ void analyzeDockingResults(const std::vector<float>& scores, int numProteins, in
               << " with Ligand " << bestLigandIndex 
               << " (Score: " << bestScore << ")" << std::endl;
     
-    // Create a ranking of the results.
-    std::vector<DockingResult> results;
-    results.reserve(scores.size());
+    // Ranking of the top 10 results with a bounded heap (no full copy and sort).
+    HitCriteria criteria;
+    criteria.topK = 10;
+    HitCollector collector(criteria);
     for (int i = 0; i < numProteins; ++i) {
         for (int j = 0; j < numLigands; ++j) {
-            int idx = i * numLigands + j;
-            // Use explicit constructor via initializer list
-            results.push_back(DockingResult{i, j, scores[idx]});
+            collector.add(i, j, scores[static_cast<size_t>(i) * numLigands + j]);
         }
     }
-    
-    // Sort the results: lower score is better.
-    std::sort(results.begin(), results.end(), [](const DockingResult &a, const DockingResult &b) {
-        return a.score < b.score;
-    });
-    
-    // Show a ranking of the top 10 results.
+    std::vector<DockingResult> results = collector.sortedHits();
+
     std::cout << "\nTop 10 docking results:" << std::endl;
-    int top = std::min(10, static_cast<int>(results.size()));
-    for (int i = 0; i < top; i++) {
+    for (size_t i = 0; i < results.size(); i++) {
         std::cout << (i + 1) << ") Protein " << results[i].proteinIndex
                   << ", Ligand " << results[i].ligandIndex
                   << ", Score: " << results[i].score << std::endl;
     }
 }
 
-void parseArguments(int argc, char* argv[], std::string &proteinsDir, std::string &ligandsDir, bool &verbose) {
-    proteinsDir = DEFAULT_PROTEINS_DIR;
-    ligandsDir  = DEFAULT_LIGANDS_DIR;
-    verbose = false;
+void reportHits(const HitCollector& collector) {
+    ScopedPhase phase(PHASE_RANK);
+    const HitCriteria& criteria = collector.getCriteria();
+    std::vector<DockingResult> hits = collector.sortedHits();
+
+    std::cout << "\nDocking hits (";
+    if (criteria.topK > 0)
+        std::cout << "top " << criteria.topK << (criteria.useThreshold ? ", " : "");
+    if (criteria.useThreshold)
+        std::cout << "score <= " << criteria.threshold;
+    std::cout << "): " << hits.size() << " of " << collector.getScored() << " scored pairs" << std::endl;
+    for (size_t i = 0; i < hits.size(); i++) {
+        std::cout << (i + 1) << ") Protein " << hits[i].proteinIndex
+                  << ", Ligand " << hits[i].ligandIndex
+                  << ", Score: " << hits[i].score << std::endl;
+    }
+}
+
+void printLoadBalance(const std::string& workerName, const std::vector<double>& times,
+                      const std::vector<double>& costShares) {
+    for (size_t k = 0; k < times.size(); k++) {
+        std::cout << "  " << workerName << " " << k << ": " << times[k] * 1000 << " ms";
+        if (k < costShares.size())
+            std::cout << ", " << costShares[k] * 100 << "% of estimated cost";
+        std::cout << std::endl;
+    }
+    std::cout << "Load imbalance (" << workerName << "s, max/mean time): " << loadImbalance(times) << std::endl;
+}
+
+void reportMetrics(const ScreeningOptions& options, const std::string& backend) {
+    if (options.metricsFile.empty() && !options.docking.funnel.enabled() && options.docking.scoreCacheDir.empty())
+        return;
+    const double wallSeconds = metricsElapsedSeconds();
+    std::vector<MetricsSnapshot> threads = collectThreadMetrics();
+    MetricsSnapshot total;
+    for (const MetricsSnapshot& thread : threads)
+        total.add(thread);
+    if (options.docking.funnel.enabled())
+        printFunnelSummary(total);
+    if (!options.docking.scoreCacheDir.empty())
+        printScoreCacheSummary(total);
+    if (options.metricsFile.empty())
+        return;
+    printMetricsSummary(total, wallSeconds);
+    if (!writeMetricsJson(options.metricsFile, backend, { threads }, wallSeconds))
+        std::cerr << "Error writing the metrics report " << options.metricsFile << std::endl;
+}
+
+void reportApproximationError(const DockingScorer& scorer) {
+    const DockingParams& params = scorer.getParams();
+    if (!params.octree.enabled && !params.grid.enabled)
+        return;
+    const ApproximationError& error = scorer.getApproximationError();
+    if (params.octree.enabled) {
+        std::cout << "Octree (theta " << params.octree.theta << "): " << scorer.getOctreeNodeCount()
+                  << " nodes, " << scorer.getOctreeBytes() / 1024 << " KiB" << std::endl;
+    } else {
+        std::cout << "Grid maps (spacing up to " << scorer.getGridMaxSpacing() << " A): " << scorer.getGridPointCount()
+                  << " points, " << scorer.getGridBytes() / 1024 << " KiB, " << scorer.getGridMapsFromCache()
+                  << " loaded from cache" << std::endl;
+    }
+    if (error.samples == 0)
+        return;
+    std::cout << (params.octree.enabled ? "Octree" : "Grid") << " error vs exact scoring over " << error.samples << " sampled pairs: mean "
+              << error.meanRel * 100 << "%, max " << error.maxRel * 100 << "% (max absolute " << error.maxAbs << ")"
+              << std::endl;
+}
+
+void reportTrace(const ScreeningOptions& options, const std::string& backend) {
+    if (options.traceFile.empty())
+        return;
+    uint64_t dropped = 0;
+    std::string events = formatTraceEvents(0, "bioscreening " + backend, 0, dropped);
+    if (dropped > 0)
+        std::cerr << "Trace buffers overflowed: " << dropped << " oldest events dropped." << std::endl;
+    if (!writeChromeTrace(options.traceFile, { events }))
+        std::cerr << "Error writing the trace " << options.traceFile << std::endl;
+}
+
+// Reads the value that follows option 'argv[i]', exiting with an error if it is missing.
+static std::string requireValue(int argc, char* argv[], int &i) {
+    if (i + 1 >= argc) {
+        std::cerr << "Missing value for option " << argv[i] << std::endl;
+        printHelp();
+        exit(EXIT_FAILURE);
+    }
+    return argv[++i];
+}
+
+static float parseFloatOption(const std::string &option, const std::string &value) {
+    try {
+        return std::stof(value);
+    } catch (const std::exception &) {
+        std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Parses "x0,y0,z0,x1,y1,z1" into the two corners of a box.
+static void parseBoxOption(const std::string &option, const std::string &value, float boxMin[3], float boxMax[3]) {
+    float v[6];
+    std::size_t pos = 0;
+    for (int k = 0; k < 6; k++) {
+        std::size_t comma = value.find(',', pos);
+        if ((k < 5) != (comma != std::string::npos)) {
+            std::cerr << "Invalid value for " << option << " (expected x0,y0,z0,x1,y1,z1): " << value << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        v[k] = parseFloatOption(option, value.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    for (int d = 0; d < 3; d++) {
+        boxMin[d] = std::min(v[d], v[d + 3]);
+        boxMax[d] = std::max(v[d], v[d + 3]);
+    }
+}
+
+bool openCheckpoint(const ScreeningOptions& options, const std::vector<Molecule>& proteins,
+                    const std::vector<Molecule>& ligands, int writer, bool restore,
+                    Checkpoint& checkpoint) {
+    uint64_t key = checkpointKey(proteins, ligands, options.docking, options.hits);
+    // The default checkpoint of an incremental run lives inside its directory.
+    if (!options.incrementalDir.empty())
+        mkdir(options.incrementalDir.c_str(), 0755);
+    if (!checkpoint.open(options.checkpointDir, writer, key, options.resume, restore))
+        return false;
+    if (restore && options.resume) {
+        std::cout << "Resuming from checkpoint: " << checkpoint.getRestoredPairs() << " of "
+                  << proteins.size() * ligands.size() << " pairs already done" << std::endl;
+    }
+    if (restore && !options.incrementalDir.empty()) {
+        IncrementalResults previous;
+        std::vector<PairRange> ranges;
+        std::vector<float> scores;
+        std::size_t reused = 0;
+        if (previous.open(options.incrementalDir) &&
+            previous.getKey() == incrementalKey(ligands, options.docking)) {
+            reused = previous.reusablePairs(proteins, ligands, ranges, scores);
+            checkpoint.addRestored(ranges, scores);
+        }
+        std::cout << "Incremental run: " << reused << " of " << proteins.size() * ligands.size()
+                  << " pairs reused from " << options.incrementalDir << std::endl;
+    }
+    return true;
+}
+
+void screenLigandStream(const DockingScorer& scorer, std::size_t numProteins, LigandStream& stream,
+                        HitCollector& hits) {
+    #ifdef _OPENMP
+    #pragma omp parallel
+    #endif
+    {
+        HitCollector local(hits.getCriteria());
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            MoleculeBatch batch;
+            LigandBatch prepared;
+            while (stream.next(batch)) {
+                const std::size_t count = batch.molecules.size();
+                // DockingResult stores int indices; a larger library cannot be numbered.
+                if (batch.first + count > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+                    std::cerr << "Error: the ligand library exceeds " << std::numeric_limits<int>::max()
+                              << " molecules, the largest index a result can hold." << std::endl;
+                    std::exit(EXIT_FAILURE);
+                }
+                TraceScope trace("batch", "compute", batch.first, batch.first + count);
+                // Los precálculos por ligando (embudo, caché) se hacen una vez por lote.
+                scorer.prepareBatch(batch.molecules, prepared);
+                for (std::size_t i = 0; i < numProteins; ++i) {
+                    for (std::size_t k = 0; k < count; ++k)
+                        local.add(i, batch.first + k, scorer.score(i, prepared, k));
+                }
+            }
+        }
+        ScopedPhase phase(PHASE_GATHER);
+        #ifdef _OPENMP
+        #pragma omp critical
+        #endif
+        hits.merge(local);
+    }
+}
+
+void printStreamSummary(const LigandStream& stream, std::size_t loaders) {
+    std::cout << "Streamed " << stream.getMolecules() << " ligands in " << stream.getBatches() << " batches ("
+              << loaders << " loader threads, at most " << stream.getPeakQueued()
+              << " parsed batches waiting); scoring waited " << stream.getWaitSeconds() * 1000
+              << " ms for input" << std::endl;
+}
+
+// Prints "+added ~changed -removed" for the files of one input directory.
+static void printManifestChanges(const std::string& name, const ManifestChanges& changes) {
+    std::cout << " " << name << " files: +" << changes.added << " ~" << changes.changed
+              << " -" << changes.removed;
+}
+
+void saveIncrementalResults(const ScreeningOptions& options, const std::vector<Molecule>& proteins,
+                            const std::vector<Molecule>& ligands, const std::vector<float>& scores) {
+    if (options.incrementalDir.empty())
+        return;
+    IncrementalResults previous;
+    previous.open(options.incrementalDir);
+    std::vector<ManifestEntry> proteinManifest, ligandManifest;
+    if (!buildManifest(options.proteinsDir, DataManager::proteinExtensions(), previous.getProteinManifest(),
+                       proteinManifest) ||
+        !buildManifest(options.ligandsDir, DataManager::ligandExtensions(), previous.getLigandManifest(),
+                       ligandManifest) ||
+        !IncrementalResults::save(options.incrementalDir, incrementalKey(ligands, options.docking),
+                                  proteinManifest, ligandManifest, proteins, ligands, scores)) {
+        std::cerr << "Error saving the incremental results to " << options.incrementalDir << std::endl;
+        return;
+    }
+    std::cout << "Incremental results saved to " << options.incrementalDir << ":";
+    printManifestChanges("protein", compareManifests(previous.getProteinManifest(), proteinManifest));
+    std::cout << ",";
+    printManifestChanges("ligand", compareManifests(previous.getLigandManifest(), ligandManifest));
+    std::cout << std::endl;
+}
+
+void parseArguments(int argc, char* argv[], ScreeningOptions &options) {
+    options = ScreeningOptions();
     
     int dirCount = 0;
     
@@ -86,23 +306,204 @@ void parseArguments(int argc, char* argv[], std::string &proteinsDir, std::strin
             exit(EXIT_SUCCESS);
         }
         else if (arg == "-v") {
-            verbose = true;
+            options.verbose = true;
+        } else if (arg == "--cutoff") {
+            options.docking.cutoff = parseFloatOption(arg, requireValue(argc, argv, i));
+        } else if (arg == "--switch") {
+            options.docking.switchDistance = parseFloatOption(arg, requireValue(argc, argv, i));
+        } else if (arg == "--forcefield") {
+            std::string value = requireValue(argc, argv, i);
+            if (!parseForceField(value.c_str(), options.docking.forceField)) {
+                std::cerr << "Invalid value for --forcefield (expected uniform or uff): " << value << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == "--funnel-keep") {
+            options.docking.funnel.keepFraction = parseFloatOption(arg, requireValue(argc, argv, i));
+            if (!(options.docking.funnel.keepFraction > 0.0f && options.docking.funnel.keepFraction <= 1.0f)) {
+                std::cerr << "--funnel-keep must be in (0, 1]." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == "--funnel-threshold") {
+            options.docking.funnel.useThreshold = true;
+            options.docking.funnel.threshold = parseFloatOption(arg, requireValue(argc, argv, i));
+        } else if (arg == "--funnel-cluster") {
+            options.docking.funnel.clusterSize = parseFloatOption(arg, requireValue(argc, argv, i));
+            if (options.docking.funnel.clusterSize <= 0.0f) {
+                std::cerr << "--funnel-cluster must be positive." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == "--octree") {
+            options.docking.octree.enabled = true;
+            options.docking.octree.theta = parseFloatOption(arg, requireValue(argc, argv, i));
+            if (!(options.docking.octree.theta >= 0.0f)) {
+                std::cerr << "--octree must be >= 0." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == "--score-cache") {
+            options.docking.scoreCacheDir = requireValue(argc, argv, i);
+        } else if (arg == "--grid") {
+            options.docking.grid.enabled = true;
+        } else if (arg == "--grid-spacing") {
+            options.docking.grid.enabled = true;
+            options.docking.grid.spacing = parseFloatOption(arg, requireValue(argc, argv, i));
+            if (options.docking.grid.spacing <= 0.0f) {
+                std::cerr << "--grid-spacing must be positive." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == "--grid-box") {
+            options.docking.grid.enabled = true;
+            options.docking.grid.hasBox = true;
+            parseBoxOption(arg, requireValue(argc, argv, i), options.docking.grid.boxMin, options.docking.grid.boxMax);
+        } else if (arg == "--dynamic") {
+            options.dynamicSchedule = true;
+        } else if (arg == "--tiled") {
+            options.tiled = true;
+        } else if (arg == "--top") {
+            std::string value = requireValue(argc, argv, i);
+            long k = std::strtol(value.c_str(), nullptr, 10);
+            if (k <= 0) {
+                std::cerr << "--top must be a positive integer." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            options.hits.topK = static_cast<std::size_t>(k);
+        } else if (arg == "--threshold") {
+            options.hits.useThreshold = true;
+            options.hits.threshold = parseFloatOption(arg, requireValue(argc, argv, i));
+        } else if (arg == "--grid-cache") {
+            options.docking.grid.enabled = true;
+            options.docking.grid.cacheDir = requireValue(argc, argv, i);
+        } else if (arg == "--checkpoint") {
+            options.checkpointDir = requireValue(argc, argv, i);
+        } else if (arg == "--resume") {
+            options.resume = true;
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "--stream-loaders") {
+            std::string value = requireValue(argc, argv, i);
+            long loaders = std::strtol(value.c_str(), nullptr, 10);
+            if (loaders <= 0) {
+                std::cerr << "--stream-loaders must be a positive integer." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            options.stream = true;
+            options.streamLoaders = static_cast<std::size_t>(loaders);
+        } else if (arg == "--incremental") {
+            options.incrementalDir = requireValue(argc, argv, i);
+        } else if (arg == "--metrics") {
+            options.metricsFile = requireValue(argc, argv, i);
+        } else if (arg == "--trace") {
+            options.traceFile = requireValue(argc, argv, i);
         } else {
             if (dirCount == 0) {
-                proteinsDir = arg;
+                options.proteinsDir = arg;
                 dirCount++;
             } else if (dirCount == 1) {
-                ligandsDir = arg;
+                options.ligandsDir = arg;
                 dirCount++;
             }
         }
     }
 
-    if(verbose){
+    if (options.stream) {
+        if (!options.hits.enabled()) {
+            std::cerr << "--stream keeps no score matrix; it requires --top or --threshold." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (!options.checkpointDir.empty() || options.resume) {
+            std::cerr << "--stream cannot be combined with --checkpoint or --resume." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (options.docking.funnel.keepFraction > 0.0f) {
+            std::cerr << "--stream cannot use --funnel-keep (the cut needs the whole library);"
+                      << " use --funnel-threshold." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!options.incrementalDir.empty()) {
+        if (options.hits.enabled()) {
+            std::cerr << "--incremental keeps the full score matrix; it cannot be combined with --top or --threshold."
+                      << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        // The delta runs checkpointed, next to the results it completes.
+        if (options.checkpointDir.empty())
+            options.checkpointDir = options.incrementalDir + "/checkpoint";
+    }
+    if (options.resume && options.checkpointDir.empty()) {
+        std::cerr << "--resume requires --checkpoint DIR." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (options.docking.octree.enabled && (options.docking.useCutoff() || options.docking.grid.enabled)) {
+        std::cerr << "--octree cannot be combined with --cutoff or --grid." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (!options.traceFile.empty())
+        startTracing();
+
+    if(options.verbose){
         std::cout << "Current configuration:" << std::endl;
-        std::cout << " Proteins path: " << proteinsDir << std::endl;
-        std::cout << " Ligands path: " << ligandsDir << std::endl;
-        std::cout << " Verbose mode: " << (verbose ? "enabled" : "disabled") << std::endl;
+        std::cout << " Proteins path: " << options.proteinsDir << std::endl;
+        std::cout << " Ligands path: " << options.ligandsDir << std::endl;
+        std::cout << " Verbose mode: " << (options.verbose ? "enabled" : "disabled") << std::endl;
+        std::cout << " SIMD kernel: " << getLJKernelName() << std::endl;
+        std::cout << " LJ parameters: " << forceFieldName(options.docking.forceField) << std::endl;
+        if (options.docking.funnel.enabled()) {
+            const FunnelParams& funnel = options.docking.funnel;
+            std::cout << " Funnel: coarse model with " << funnel.clusterSize << " A clusters, keeping";
+            if (funnel.keepFraction > 0.0f)
+                std::cout << " the best " << funnel.keepFraction * 100 << "% per protein";
+            if (funnel.useThreshold)
+                std::cout << (funnel.keepFraction > 0.0f ? " and" : "") << " estimates <= " << funnel.threshold;
+            std::cout << std::endl;
+        }
+        if (options.docking.useCutoff()) {
+            std::cout << " Cutoff: " << options.docking.cutoff << " A (switching from "
+                      << options.docking.effectiveSwitchDistance() << " A)" << std::endl;
+        } else {
+            std::cout << " Cutoff: disabled (all atom pairs)" << std::endl;
+        }
+        if (options.docking.octree.enabled) {
+            std::cout << " Octree: opening angle " << options.docking.octree.theta << " ("
+                      << OCTREE_LEAF_ATOMS << " atoms per leaf)" << std::endl;
+        }
+        if (options.docking.grid.enabled) {
+            std::cout << " Grid maps: spacing ";
+            if (options.docking.grid.spacing > 0.0f)
+                std::cout << options.docking.grid.spacing << " A";
+            else
+                std::cout << "default (" << defaultGridSpacing(options.docking.forceField) << " A or more)";
+            std::cout << ", box " << (options.docking.grid.hasBox ? "user-defined" : "protein bounding box plus margin")
+                      << ", cache " << (options.docking.grid.cacheDir.empty() ? "disabled" : options.docking.grid.cacheDir)
+                      << std::endl;
+        }
+        if (!options.docking.scoreCacheDir.empty())
+            std::cout << " Score cache: " << options.docking.scoreCacheDir << std::endl;
+        if (options.dynamicSchedule)
+            std::cout << " Work distribution: dynamic (MPI backends)" << std::endl;
+        if (options.tiled)
+            std::cout << " Tiled execution: enabled (OpenMP backend)" << std::endl;
+        if (!options.checkpointDir.empty()) {
+            std::cout << " Checkpoint: " << options.checkpointDir
+                      << (options.resume ? " (resuming)" : "") << std::endl;
+        }
+        if (options.stream) {
+            std::cout << " Ligand streaming: " << options.streamLoaders << " loader threads, "
+                      << DEFAULT_STREAM_QUEUE_BATCHES << " parsed batches queued at most" << std::endl;
+        }
+        if (!options.incrementalDir.empty())
+            std::cout << " Incremental results: " << options.incrementalDir << std::endl;
+        if (!options.metricsFile.empty())
+            std::cout << " Metrics report: " << options.metricsFile << std::endl;
+        if (!options.traceFile.empty())
+            std::cout << " Trace: " << options.traceFile << std::endl;
+        if (options.hits.enabled()) {
+            std::cout << " Hit collection:";
+            if (options.hits.topK > 0)
+                std::cout << " top " << options.hits.topK;
+            if (options.hits.useThreshold)
+                std::cout << " score <= " << options.hits.threshold;
+            std::cout << " (no full score matrix)" << std::endl;
+        }
         std::cout << std::endl;
     }
 }
@@ -112,6 +513,42 @@ void printHelp() {
     std::cout << "Options:" << std::endl;
     std::cout << " -h, --help Displays this help and exits." << std::endl;
     std::cout << " -v Enables verbose mode and prints docking analysis." << std::endl;
+    std::cout << " --cutoff R Only scores atom pairs closer than R angstroms (cell list)." << std::endl;
+    std::cout << " --switch R_ON Start of the smoothing region before the cutoff (default: cutoff - "
+              << DEFAULT_SWITCH_WIDTH << ")." << std::endl;
+    std::cout << " --forcefield NAME LJ parameters: uniform (sigma = epsilon = 1, default) or uff"
+              << " (per-element UFF parameters)." << std::endl;
+    std::cout << " --funnel-keep F Coarse first pass; only the best fraction F (0-1] of the ligands of each"
+              << " protein gets full scoring." << std::endl;
+    std::cout << " --funnel-threshold E Coarse first pass; only pairs with an estimate <= E get full scoring."
+              << std::endl;
+    std::cout << " --funnel-cluster S Edge in angstroms of the cells that group atoms in the coarse model (default: "
+              << DEFAULT_FUNNEL_CLUSTER_SIZE << ")." << std::endl;
+    std::cout << " --octree THETA Approximate scoring: protein atoms are grouped in an octree and distant"
+              << " nodes (diameter/distance < THETA) count as one interaction; 0 is exact." << std::endl;
+    std::cout << " --grid Scores ligands with precomputed per-protein affinity grids (trilinear lookup)." << std::endl;
+    std::cout << " --grid-spacing S Grid spacing in angstroms (default: " << GRID_SPACING_PER_SIGMA
+              << " x the smallest sigma of the force field, coarser if a map would exceed " << GRID_MAX_DEFAULT_POINTS
+              << " points)." << std::endl;
+    std::cout << " --grid-box x0,y0,z0,x1,y1,z1 Grid bounding box (default: each protein's bounding box plus a margin)."
+              << std::endl;
+    std::cout << " --grid-cache DIR Stores and reuses the grid maps in DIR." << std::endl;
+    std::cout << " --score-cache DIR Reuses the scores of protein/ligand pairs already computed with the same"
+              << " parameters (persistent table in DIR, shared across runs)." << std::endl;
+    std::cout << " --dynamic Ranks pull cost-balanced work units from a shared counter; results stream to rank 0 (MPI backends)." << std::endl;
+    std::cout << " --tiled Cache-blocked protein x ligand tiles sized from the detected caches (OpenMP backend)." << std::endl;
+    std::cout << " --top K Keeps only the K best protein-ligand pairs (bounded per-worker heaps)." << std::endl;
+    std::cout << " --threshold E Keeps only the pairs with score <= E." << std::endl;
+    std::cout << " --checkpoint DIR Appends completed work units and their results to DIR in the background (CPU backends)." << std::endl;
+    std::cout << " --resume Skips the work already recorded in the --checkpoint directory." << std::endl;
+    std::cout << " --stream Loads the ligands in batches through a bounded queue while they are scored;"
+              << " memory does not grow with the library (requires --top or --threshold; CPU backends)." << std::endl;
+    std::cout << " --stream-loaders N Parser threads that feed --stream (default: " << DEFAULT_STREAM_LOADERS
+              << ")." << std::endl;
+    std::cout << " --incremental DIR Keeps a manifest of the input files and the score matrix in DIR; the next"
+              << " run only scores the pairs of new or changed proteins and ligands (CPU backends, full matrix only)." << std::endl;
+    std::cout << " --metrics FILE Writes per-phase times, counters and rates (per thread and rank) to FILE as JSON." << std::endl;
+    std::cout << " --trace FILE Records a timeline of phases, work units, file parses and MPI calls per thread and rank (Chrome/Perfetto JSON)." << std::endl;
     std::cout << "If no paths are specified, the following defaults will be used:" << std::endl;
     std::cout << " Proteins: " << DEFAULT_PROTEINS_DIR << std::endl;
     std::cout << " Ligands: " << DEFAULT_LIGANDS_DIR << std::endl;
@@ -19,11 +19,15 @@ __global__ void dockingKernelSubset(
     int numProteins,
     int numLigands,
     const int* proteinAtomCounts,    // Número de átomos por proteína
-    const int* proteinAtomOffsets,   // Offset (índice inicial) de cada proteína en el array de átomos
-    const float* proteinAtoms,       // Arreglo aplanado: [x, y, z, …] de todas las proteínas
+    const int* proteinAtomOffsets,   // Offset (índice inicial) de cada proteína en los arrays de átomos
+    const float* proteinX,           // Coordenadas SoA aplanadas de todas las proteínas
+    const float* proteinY,
+    const float* proteinZ,
     const int* ligandAtomCounts,     // Número de átomos por ligando
-    const int* ligandAtomOffsets,    // Offsets en el arreglo de átomos de ligandos
-    const float* ligandAtoms,        // Arreglo aplanado de coordenadas para ligandos
+    const int* ligandAtomOffsets,    // Offsets en los arrays de átomos de ligandos
+    const float* ligandX,            // Coordenadas SoA aplanadas de los ligandos
+    const float* ligandY,
+    const float* ligandZ,
     float* scores,                   // Array de resultados locales (tamaño = gpu_count)
     int start,                       // Índice global de inicio (dentro del total de evaluaciones)
     int end                          // Índice global final (no inclusivo)
@@ -43,15 +47,13 @@ __global__ void dockingKernelSubset(
     int lOffset = ligandAtomOffsets[j];
 
     for (int a = 0; a < pCount; a++) {
-        int pAtomIdx = (pOffset + a) * 3;
-        float px = proteinAtoms[pAtomIdx];
-        float py = proteinAtoms[pAtomIdx + 1];
-        float pz = proteinAtoms[pAtomIdx + 2];
+        float px = proteinX[pOffset + a];
+        float py = proteinY[pOffset + a];
+        float pz = proteinZ[pOffset + a];
         for (int b = 0; b < lCount; b++) {
-            int lAtomIdx = (lOffset + b) * 3;
-            float lx = ligandAtoms[lAtomIdx];
-            float ly = ligandAtoms[lAtomIdx + 1];
-            float lz = ligandAtoms[lAtomIdx + 2];
+            float lx = ligandX[lOffset + b];
+            float ly = ligandY[lOffset + b];
+            float lz = ligandZ[lOffset + b];
             float dx = px - lx;
             float dy = py - ly;
             float dz = pz - lz;
@@ -101,67 +103,42 @@ void hybridDockingOpenmpCuda(const std::vector<Molecule>& proteins,
     }
 
     // --- PARTE GPU: Preparar datos ---
-    // Se requiere aplanar la información de las moléculas para transferirla a la GPU.
-    std::vector<int> h_proteinAtomCounts(numProteins);
-    std::vector<int> h_proteinAtomOffsets(numProteins);
-    int totalProteinAtoms = 0;
-    for (int i = 0; i < numProteins; i++) {
-        h_proteinAtomCounts[i] = proteins[i].getAtoms().size();
-        h_proteinAtomOffsets[i] = totalProteinAtoms;
-        totalProteinAtoms += proteins[i].getAtoms().size();
-    }
-    std::vector<float> h_proteinAtoms(totalProteinAtoms * 3);
-    int idxAtom = 0;
-    for (int i = 0; i < numProteins; i++) {
-        const std::vector<Atom>& atoms = proteins[i].getAtoms();
-        for (size_t j = 0; j < atoms.size(); j++) {
-            h_proteinAtoms[idxAtom++] = atoms[j].x;
-            h_proteinAtoms[idxAtom++] = atoms[j].y;
-            h_proteinAtoms[idxAtom++] = atoms[j].z;
-        }
-    }
-
-    std::vector<int> h_ligandAtomCounts(numLigands);
-    std::vector<int> h_ligandAtomOffsets(numLigands);
-    int totalLigandAtoms = 0;
-    for (int i = 0; i < numLigands; i++) {
-        h_ligandAtomCounts[i] = ligands[i].getAtoms().size();
-        h_ligandAtomOffsets[i] = totalLigandAtoms;
-        totalLigandAtoms += ligands[i].getAtoms().size();
-    }
-    std::vector<float> h_ligandAtoms(totalLigandAtoms * 3);
-    idxAtom = 0;
-    for (int i = 0; i < numLigands; i++) {
-        const std::vector<Atom>& atoms = ligands[i].getAtoms();
-        for (size_t j = 0; j < atoms.size(); j++) {
-            h_ligandAtoms[idxAtom++] = atoms[j].x;
-            h_ligandAtoms[idxAtom++] = atoms[j].y;
-            h_ligandAtoms[idxAtom++] = atoms[j].z;
-        }
-    }
+    // Se reutiliza la disposición SoA aplanada de Molecule.h (counts, offsets, x, y, z).
+    FlatMolecules flatProteins = flattenMolecules(proteins);
+    FlatMolecules flatLigands = flattenMolecules(ligands);
+    int totalProteinAtoms = flatProteins.x.size();
+    int totalLigandAtoms = flatLigands.x.size();
 
     // --- PARTE GPU: Reservar y transferir memoria en el dispositivo ---
     int *d_proteinAtomCounts, *d_proteinAtomOffsets;
-    float *d_proteinAtoms;
+    float *d_proteinX, *d_proteinY, *d_proteinZ;
     int *d_ligandAtomCounts, *d_ligandAtomOffsets;
-    float *d_ligandAtoms;
+    float *d_ligandX, *d_ligandY, *d_ligandZ;
     float *d_gpu_scores;  // Array para almacenar los resultados GPU (tamaño = gpu_count)
 
     cudaMalloc((void**)&d_proteinAtomCounts, numProteins * sizeof(int));
     cudaMalloc((void**)&d_proteinAtomOffsets, numProteins * sizeof(int));
-    cudaMalloc((void**)&d_proteinAtoms, totalProteinAtoms * 3 * sizeof(float));
+    cudaMalloc((void**)&d_proteinX, totalProteinAtoms * sizeof(float));
+    cudaMalloc((void**)&d_proteinY, totalProteinAtoms * sizeof(float));
+    cudaMalloc((void**)&d_proteinZ, totalProteinAtoms * sizeof(float));
     cudaMalloc((void**)&d_ligandAtomCounts, numLigands * sizeof(int));
     cudaMalloc((void**)&d_ligandAtomOffsets, numLigands * sizeof(int));
-    cudaMalloc((void**)&d_ligandAtoms, totalLigandAtoms * 3 * sizeof(float));
+    cudaMalloc((void**)&d_ligandX, totalLigandAtoms * sizeof(float));
+    cudaMalloc((void**)&d_ligandY, totalLigandAtoms * sizeof(float));
+    cudaMalloc((void**)&d_ligandZ, totalLigandAtoms * sizeof(float));
     cudaMalloc((void**)&d_gpu_scores, gpu_count * sizeof(float));
 
-    cudaMemcpy(d_proteinAtomCounts, h_proteinAtomCounts.data(), numProteins * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_proteinAtomOffsets, h_proteinAtomOffsets.data(), numProteins * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_proteinAtoms, h_proteinAtoms.data(), totalProteinAtoms * 3 * sizeof(float), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinAtomCounts, flatProteins.counts.data(), numProteins * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinAtomOffsets, flatProteins.offsets.data(), numProteins * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinX, flatProteins.x.data(), totalProteinAtoms * sizeof(float), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinY, flatProteins.y.data(), totalProteinAtoms * sizeof(float), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinZ, flatProteins.z.data(), totalProteinAtoms * sizeof(float), cudaMemcpyHostToDevice);
 
-    cudaMemcpy(d_ligandAtomCounts, h_ligandAtomCounts.data(), numLigands * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_ligandAtomOffsets, h_ligandAtomOffsets.data(), numLigands * sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy(d_ligandAtoms, h_ligandAtoms.data(), totalLigandAtoms * 3 * sizeof(float), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandAtomCounts, flatLigands.counts.data(), numLigands * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandAtomOffsets, flatLigands.offsets.data(), numLigands * sizeof(int), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandX, flatLigands.x.data(), totalLigandAtoms * sizeof(float), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandY, flatLigands.y.data(), totalLigandAtoms * sizeof(float), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandZ, flatLigands.z.data(), totalLigandAtoms * sizeof(float), cudaMemcpyHostToDevice);
 
     // --- PARTE GPU: Lanzar el kernel para el subrango [cpu_count, total) ---
     int blockSize = 256;
@@ -169,8 +146,8 @@ void hybridDockingOpenmpCuda(const std::vector<Molecule>& proteins,
     int start = cpu_count;  // primer índice global a procesar en GPU
     int end = total;        // último índice (no inclusivo)
     dockingKernelSubset<<<gridSize, blockSize>>>(numProteins, numLigands,
-         d_proteinAtomCounts, d_proteinAtomOffsets, d_proteinAtoms,
-         d_ligandAtomCounts, d_ligandAtomOffsets, d_ligandAtoms,
+         d_proteinAtomCounts, d_proteinAtomOffsets, d_proteinX, d_proteinY, d_proteinZ,
+         d_ligandAtomCounts, d_ligandAtomOffsets, d_ligandX, d_ligandY, d_ligandZ,
          d_gpu_scores, start, end);
     cudaDeviceSynchronize();
 
@@ -181,10 +158,14 @@ void hybridDockingOpenmpCuda(const std::vector<Molecule>& proteins,
     // Liberar memoria en el dispositivo.
     cudaFree(d_proteinAtomCounts);
     cudaFree(d_proteinAtomOffsets);
-    cudaFree(d_proteinAtoms);
+    cudaFree(d_proteinX);
+    cudaFree(d_proteinY);
+    cudaFree(d_proteinZ);
     cudaFree(d_ligandAtomCounts);
     cudaFree(d_ligandAtomOffsets);
-    cudaFree(d_ligandAtoms);
+    cudaFree(d_ligandX);
+    cudaFree(d_ligandY);
+    cudaFree(d_ligandZ);
     cudaFree(d_gpu_scores);
 
     // --- COMBINAR RESULTADOS ---
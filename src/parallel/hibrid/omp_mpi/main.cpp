@@ -6,24 +6,109 @@
 #include "Molecule.h"
 #include "Docking.h"
 #include "Utils.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Partition.h"
+#include "MpiCommon.h"
+#include "NodeShared.h"
 #include <mpi.h>
 #include <omp.h>
 
+// Dynamic variant: the rank pulls cost-balanced work units from the shared
+// MPI_Fetch_and_op counter and its OpenMP threads share each unit, so ranks with more
+// cores pull more units. Score chunks stream back to rank 0 with non-blocking sends.
+// MPI is only called from the master thread, outside the parallel regions. With a
+// checkpoint, only the pending pairs are split into units and every finished unit is
+// recorded (its scores by rank 0, or its hits by the rank that computed it).
+static std::vector<float> hybrid_docking_dynamic(const std::vector<Molecule>& ligands,
+                                                 const PairCostModel& model,
+                                                 const DockingScorer& scorer,
+                                                 HitCollector* hits,
+                                                 Checkpoint* checkpoint) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    size_t total = model.getNumPairs();
+
+    HitCollector rankHits(hits != nullptr ? hits->getCriteria() : HitCriteria());
+    std::vector<float> scores(rank == 0 && hits == nullptr ? total : 0);
+    std::vector<PairRange> completed = restoreCompleted(checkpoint, hits == nullptr ? scores.data() : nullptr,
+                                                        hits != nullptr ? &rankHits : nullptr);
+    size_t numUnits = checkpoint != nullptr ? checkpointUnits(size) : size * DYNAMIC_UNITS_PER_RANK;
+    std::vector<PairRange> units = model.splitRanges(pendingRanges(completed, total), std::min(total, numUnits));
+
+    std::vector<double> threadTimes(omp_get_max_threads(), 0.0);
+    double cost = 0.0;
+    DynamicStats stats = runDynamicSchedule(units, hits == nullptr,
+        [&](size_t begin, size_t end, float* out) {
+            cost += model.rangeCost(begin, end);
+            HitCollector unitHits(rankHits.getCriteria());
+            #pragma omp parallel
+            {
+                double threadStart = omp_get_wtime();
+                HitCollector local(rankHits.getCriteria());
+                {
+                    ScopedPhase phase(PHASE_COMPUTE);
+                    TraceScope trace("unit", "compute", begin, end);
+                    #pragma omp for schedule(dynamic, 16) nowait
+                    for (size_t idx = begin; idx < end; ++idx) {
+                        size_t i = idx / ligands.size();
+                        size_t j = idx % ligands.size();
+                        float score = scorer.score(i, ligands[j]);
+                        if (out != nullptr)
+                            out[idx - begin] = score;
+                        else
+                            local.add(i, j, score);
+                    }
+                }
+                threadTimes[omp_get_thread_num()] += omp_get_wtime() - threadStart;
+                if (out == nullptr) {
+                    ScopedPhase phase(PHASE_GATHER);
+                    #pragma omp critical
+                    unitHits.merge(local);
+                }
+            }
+            if (out == nullptr && checkpoint != nullptr)
+                checkpoint->recordHits(PairRange{ begin, end }, unitHits);
+            rankHits.merge(unitHits);
+        }, scores,
+        [&](const PairRange& unit, const float* unitScores) {
+            if (checkpoint != nullptr)
+                checkpoint->recordScores(unit, unitScores);
+        });
+
+    std::cout << "Process " << rank << " processed " << stats.units << " work units in "
+              << stats.seconds * 1000 << " ms, thread imbalance (max/mean): "
+              << loadImbalance(threadTimes) << std::endl;
+    reportRankBalance(stats.seconds, model.totalCost() > 0.0 ? cost / model.totalCost() : 0.0);
+    if (hits != nullptr)
+        *hits = gatherHits(rankHits);
+    return scores;
+}
+
+// Returns the score matrix on rank 0 or, if 'hits' is given, collects only the hits
+// there (each thread keeps its own bounded collector). A checkpoint implies the dynamic
+// schedule.
 std::vector<float> hybrid_docking(const std::vector<Molecule>& proteins, 
-                                  const std::vector<Molecule>& ligands) {
+                                  const std::vector<Molecule>& ligands,
+                                  const DockingParams& params,
+                                  bool dynamicSchedule,
+                                  HitCollector* hits,
+                                  Checkpoint* checkpoint) {
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
     size_t total = proteins.size() * ligands.size();
 
-    // Distribuir trabajo entre procesos MPI
-    size_t chunk     = total / size;
-    size_t remainder = total % size;
-    size_t start = rank * chunk + (rank < remainder ? rank : remainder);
-    size_t end   = start + chunk + (rank < remainder ? 1 : 0);
+    PairCostModel model(proteins, ligands, params);
+
+    // Distribuir trabajo entre procesos MPI: rangos contiguos de coste estimado similar
+    std::vector<size_t> rankBounds = model.splitRange(0, total, size);
+    size_t start = rankBounds[rank];
+    size_t end   = rankBounds[rank + 1];
     
-    std::vector<float> localScores(end - start);
+    std::vector<float> localScores(hits == nullptr ? end - start : 0);
     
     #pragma omp parallel
     {
@@ -36,19 +121,62 @@ std::vector<float> hybrid_docking(const std::vector<Molecule>& proteins,
     
     double t1 = omp_get_wtime();
 
-    // Docking paralelo
-    #pragma omp parallel for schedule(static)
-    for (size_t idx = start; idx < end; ++idx) {
-        size_t i = idx / ligands.size();
-        size_t j = idx % ligands.size();
-        localScores[idx - start] = performDocking(proteins[i], ligands[j]);
+    DockingScorer scorer(proteins, params, ligands);
+    if (rank == 0)
+        reportApproximationError(scorer);
+
+    if (dynamicSchedule || checkpoint != nullptr)
+        return hybrid_docking_dynamic(ligands, model, scorer, hits, checkpoint);
+
+    // Docking paralelo: el rango del proceso se vuelve a dividir por coste entre los hilos.
+    // En modo de hits cada hilo usa su colector, que se mezcla en el proceso y luego en el 0.
+    HitCollector rankHits(hits != nullptr ? hits->getCriteria() : HitCriteria());
+    std::vector<size_t> bounds;
+    std::vector<double> threadTimes;
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            bounds = model.splitRange(start, end, omp_get_num_threads());
+            threadTimes.resize(omp_get_num_threads());
+        }
+        const int t = omp_get_thread_num();
+        double threadStart = omp_get_wtime();
+        HitCollector local(rankHits.getCriteria());
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            TraceScope trace("chunk", "compute", bounds[t], bounds[t + 1]);
+            for (size_t idx = bounds[t]; idx < bounds[t + 1]; ++idx) {
+                size_t i = idx / ligands.size();
+                size_t j = idx % ligands.size();
+                if (hits != nullptr)
+                    local.add(i, j, scorer.score(i, ligands[j]));
+                else
+                    localScores[idx - start] = scorer.score(i, ligands[j]);
+            }
+        }
+        threadTimes[t] = omp_get_wtime() - threadStart;
+        if (hits != nullptr) {
+            ScopedPhase phase(PHASE_GATHER);
+            #pragma omp critical
+            rankHits.merge(local);
+        }
     }
     
     double t2 = omp_get_wtime();
     std::cout << "Process " << rank << " local execution time: " 
-              << (t2 - t1)*1000 << " ms" << std::endl;
+              << (t2 - t1)*1000 << " ms, thread imbalance (max/mean): "
+              << loadImbalance(threadTimes) << std::endl;
+    reportRankBalance(t2 - t1, model.totalCost() > 0.0 ? model.rangeCost(start, end) / model.totalCost() : 0.0);
+
+    if (hits != nullptr) {
+        *hits = gatherHits(rankHits);
+        return std::vector<float>();
+    }
 
     // Recopilar resultados
+    ScopedPhase phase(PHASE_GATHER);
+    TraceScope trace("MPI_Gatherv", "mpi");
     std::vector<float> scores;
     if (rank == 0) {
         scores.resize(total);
@@ -73,43 +201,104 @@ std::vector<float> hybrid_docking(const std::vector<Molecule>& proteins,
     return scores;
 }
 
+// Streaming run: every rank streams its byte-balanced share of the ligand files through
+// a bounded queue and scores each batch against all proteins as it arrives; only the
+// hits reach rank 0.
+static void stream_docking(const std::vector<Molecule>& proteins, const ScreeningOptions& options) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        std::cout << "Executing streaming docking with MPI + OpenMP..." << std::endl;
+    DockingScorer scorer(proteins, options.docking);
+    if (rank == 0)
+        reportApproximationError(scorer);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t1 = MPI_Wtime();
+    HitCollector hits = streamRankLigands(options, scorer, proteins.size());
+    {
+        TraceScope trace("MPI_Barrier", "mpi");
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    double t2 = MPI_Wtime();
+    scorer.flushScoreCache();
+    if (rank == 0) {
+        std::cout << "Execution time: " << (t2 - t1) * 1000 << " ms" << std::endl;
+        reportHits(hits);
+    }
+    reportRankMetrics(options, "omp_mpi");
+    reportRankTrace(options);
+}
+
 int main(int argc, char* argv[]) {
     MPI_Init(&argc, &argv);
 
-    std::string proteinsDir;
-    std::string ligandsDir;
-    bool verbose;
-
-    parseArguments(argc, argv, proteinsDir, ligandsDir, verbose);
+    ScreeningOptions options;
+    parseArguments(argc, argv, options);
 
     DataManager dataManager;
     std::vector<Molecule> proteins, ligands;
 
-    if (!dataManager.loadProteins(proteinsDir, proteins)) {
+    // Every rank parses a disjoint share of the files; every rank on a node reads the
+    // assembled data in place from a node-shared window.
+    NodeSharedMolecules shared;
+    if (!shared.load(dataManager, options.proteinsDir, true, proteins)) {
         std::cerr << "Error loading proteins." << std::endl;
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
-    if (!dataManager.loadLigands(ligandsDir, ligands)) {
+    if (options.stream) {
+        stream_docking(proteins, options);
+        proteins.clear();
+        shared.release();
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+    if (!shared.load(dataManager, options.ligandsDir, false, ligands)) {
         std::cerr << "Error loading ligands." << std::endl;
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
+    if (options.verbose && shared.getNodeRank() == 0) {
+        std::cout << "Node-shared molecule data: " << shared.getSharedBytes() / 1024 << " KB, shared by "
+                  << shared.getNodeSize() << " ranks; files parsed in shares across all ranks" << std::endl;
+    }
+
+    Checkpoint checkpoint;
+    const bool useCheckpoint = !options.checkpointDir.empty();
+    if (useCheckpoint)
+        openRankCheckpoints(options, proteins, ligands, checkpoint);
 
     double t1, t2;
     MPI_Barrier(MPI_COMM_WORLD);
     t1 = MPI_Wtime();
 
-    std::vector<float> scores = hybrid_docking(proteins, ligands);
+    HitCollector hits(options.hits);
+    std::vector<float> scores = hybrid_docking(proteins, ligands, options.docking, options.dynamicSchedule,
+                                               options.hits.enabled() ? &hits : nullptr,
+                                               useCheckpoint ? &checkpoint : nullptr);
+    checkpoint.close();
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    {
+        TraceScope trace("MPI_Barrier", "mpi");
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
     t2 = MPI_Wtime();
 
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    if (rank == 0)
+    if (rank == 0) {
         std::cout << "Execution time: " << (t2 - t1) * 1000 << " ms" << std::endl;
-    if (rank == 0 && verbose)
+        saveIncrementalResults(options, proteins, ligands, scores);
+    }
+    if (rank == 0 && options.hits.enabled())
+        reportHits(hits);
+    else if (rank == 0 && options.verbose)
         analyzeDockingResults(scores, proteins.size(), ligands.size());
+    reportRankMetrics(options, "omp_mpi");
+    reportRankTrace(options);
 
+    // The molecules are views on the node-shared windows, which must go before MPI_Finalize.
+    proteins.clear();
+    ligands.clear();
+    shared.release();
     MPI_Finalize();
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,377 @@
+#include "MpiCommon.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Utils.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+// Etiqueta de los mensajes de resultados del reparto dinámico.
+static const int RESULT_TAG = 1001;
+
+// Cabecera de cada mensaje de resultados: índice de la unidad (seguido de sus scores).
+static const std::size_t RESULT_HEADER_BYTES = sizeof(uint64_t);
+
+HitCollector gatherHits(const HitCollector& local) {
+    ScopedPhase phase(PHASE_GATHER);
+    TraceScope trace("MPI_Gatherv", "mpi");
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    const std::vector<DockingResult>& localHits = local.getHits();
+    int localBytes = static_cast<int>(localHits.size() * sizeof(DockingResult));
+    unsigned long long localScored = local.getScored();
+    std::vector<int> recvBytes(size);
+    std::vector<unsigned long long> scored(size);
+    MPI_Gather(&localBytes, 1, MPI_INT, recvBytes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Gather(&localScored, 1, MPI_UNSIGNED_LONG_LONG, scored.data(), 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    std::vector<int> displs(size, 0);
+    std::vector<DockingResult> all;
+    if (rank == 0) {
+        for (int i = 1; i < size; ++i) {
+            displs[i] = displs[i - 1] + recvBytes[i - 1];
+        }
+        all.resize((displs[size - 1] + recvBytes[size - 1]) / sizeof(DockingResult));
+    }
+    MPI_Gatherv(localHits.data(), localBytes, MPI_BYTE,
+                all.data(), recvBytes.data(), displs.data(), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    HitCollector hits(local.getCriteria());
+    if (rank == 0) {
+        for (int i = 0; i < size; ++i) {
+            const DockingResult* begin = all.data() + displs[i] / sizeof(DockingResult);
+            hits.merge(begin, begin + recvBytes[i] / sizeof(DockingResult), scored[i]);
+        }
+    }
+    return hits;
+}
+
+HitCollector streamRankLigands(const ScreeningOptions& options, const DockingScorer& scorer,
+                               std::size_t numProteins) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    LigandStream stream;
+    int ok = stream.open(options.ligandsDir, options.streamLoaders, DEFAULT_STREAM_QUEUE_BATCHES,
+                         static_cast<std::size_t>(rank), static_cast<std::size_t>(size)) ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!ok) {
+        std::cerr << "Error cargando los ligandos" << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    double start = MPI_Wtime();
+    HitCollector local(options.hits);
+    screenLigandStream(scorer, numProteins, stream, local);
+    stream.close();
+    const double seconds = MPI_Wtime() - start;
+
+    // Posición del fragmento de este proceso en la librería completa y parte que le tocó.
+    unsigned long long count = stream.getMolecules(), before = 0, total = 0;
+    MPI_Exscan(&count, &before, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0)
+        before = 0;
+    MPI_Allreduce(&count, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    // Los índices de DockingResult son int: una librería mayor no se puede numerar.
+    if (total > static_cast<unsigned long long>(std::numeric_limits<int>::max())) {
+        if (rank == 0) {
+            std::cerr << "Error: la librería tiene " << total << " ligandos; los resultados admiten como mucho "
+                      << std::numeric_limits<int>::max() << std::endl;
+        }
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    reportRankBalance(seconds, total > 0 ? static_cast<double>(count) / total : 0.0);
+
+    unsigned long long batches = stream.getBatches(), totalBatches = 0;
+    double wait = stream.getWaitSeconds(), maxWait = 0.0;
+    MPI_Reduce(&batches, &totalBatches, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&wait, &maxWait, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        std::cout << "Streamed " << total << " ligands in " << totalBatches << " batches across " << size
+                  << " ranks (" << options.streamLoaders << " loader threads each); scoring waited up to "
+                  << maxWait * 1000 << " ms for input" << std::endl;
+    }
+
+    std::vector<DockingResult> shifted(local.getHits());
+    for (DockingResult& hit : shifted)
+        hit.ligandIndex += static_cast<int>(before);
+    HitCollector rankHits(options.hits);
+    rankHits.merge(shifted.data(), shifted.data() + shifted.size(), local.getScored());
+    return gatherHits(rankHits);
+}
+
+void reportRankBalance(double seconds, double costShare) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    std::vector<double> times(size);
+    std::vector<double> shares(size);
+    MPI_Gather(&seconds, 1, MPI_DOUBLE, times.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Gather(&costShare, 1, MPI_DOUBLE, shares.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank == 0)
+        printLoadBalance("rank", times, shares);
+}
+
+WorkCounter::WorkCounter(MPI_Comm comm) : comm(comm), value(nullptr) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Aint bytes = (rank == 0) ? sizeof(long) : 0;
+    MPI_Win_allocate(bytes, sizeof(long), MPI_INFO_NULL, comm, &value, &win);
+    if (rank == 0)
+        *value = 0;
+    // El valor inicial debe estar escrito antes de que nadie lo incremente.
+    MPI_Barrier(comm);
+    MPI_Win_lock_all(0, win);
+}
+
+WorkCounter::~WorkCounter() {
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+}
+
+long WorkCounter::next() {
+    TraceScope trace("MPI_Fetch_and_op", "mpi");
+    const long one = 1;
+    long unit = 0;
+    MPI_Fetch_and_op(&one, &unit, MPI_LONG, 0, 0, MPI_SUM, win);
+    MPI_Win_flush(0, win);
+    return unit;
+}
+
+// Recibe un mensaje de resultados (bloqueante o no) y copia sus scores a su sitio.
+// Devuelve false si 'blocking' es false y no había ningún mensaje pendiente.
+static bool receiveUnit(const std::vector<PairRange>& units, std::vector<float>& scores,
+                        std::vector<char>& buffer, bool blocking,
+                        const std::function<void(const PairRange&, const float*)>& completed) {
+    TraceScope trace(blocking ? "MPI_Recv" : "MPI_Iprobe", "mpi");
+    MPI_Status status;
+    if (blocking) {
+        MPI_Probe(MPI_ANY_SOURCE, RESULT_TAG, MPI_COMM_WORLD, &status);
+    } else {
+        int pending = 0;
+        MPI_Iprobe(MPI_ANY_SOURCE, RESULT_TAG, MPI_COMM_WORLD, &pending, &status);
+        if (!pending)
+            return false;
+    }
+    int bytes = 0;
+    MPI_Get_count(&status, MPI_BYTE, &bytes);
+    buffer.resize(bytes);
+    MPI_Recv(buffer.data(), bytes, MPI_BYTE, status.MPI_SOURCE, RESULT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    uint64_t unit;
+    std::memcpy(&unit, buffer.data(), sizeof(unit));
+    std::memcpy(scores.data() + units[unit].begin, buffer.data() + RESULT_HEADER_BYTES,
+                bytes - RESULT_HEADER_BYTES);
+    if (completed)
+        completed(units[unit], scores.data() + units[unit].begin);
+    return true;
+}
+
+DynamicStats runDynamicSchedule(const std::vector<PairRange>& units, bool streamScores,
+                                const std::function<void(std::size_t, std::size_t, float*)>& compute,
+                                std::vector<float>& scores,
+                                const std::function<void(const PairRange&, const float*)>& completed) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    const std::size_t numUnits = units.size();
+
+    DynamicStats stats;
+    double start = MPI_Wtime();
+    {
+        WorkCounter counter(MPI_COMM_WORLD);
+
+        // Doble buffer de envío: se calcula una unidad mientras la anterior viaja.
+        std::vector<char> sendBuffers[2];
+        MPI_Request requests[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+        int slot = 0;
+        std::vector<char> recvBuffer;
+        std::size_t receivedUnits = 0;
+
+        for (;;) {
+            long next = counter.next();
+            if (next < 0 || static_cast<std::size_t>(next) >= numUnits)
+                break;
+            const std::size_t unit = static_cast<std::size_t>(next);
+            const std::size_t begin = units[unit].begin;
+            const std::size_t end = units[unit].end;
+            stats.units++;
+
+            if (!streamScores) {
+                compute(begin, end, nullptr);
+            } else if (rank == 0) {
+                compute(begin, end, scores.data() + begin);
+                if (completed)
+                    completed(units[unit], scores.data() + begin);
+                // Recoger los resultados que ya han llegado sin bloquear el cálculo.
+                while (receiveUnit(units, scores, recvBuffer, false, completed))
+                    receivedUnits++;
+            } else {
+                {
+                    TraceScope trace("MPI_Wait", "mpi");
+                    MPI_Wait(&requests[slot], MPI_STATUS_IGNORE);
+                }
+                std::vector<char>& buffer = sendBuffers[slot];
+                buffer.resize(RESULT_HEADER_BYTES + (end - begin) * sizeof(float));
+                uint64_t header = unit;
+                std::memcpy(buffer.data(), &header, sizeof(header));
+                compute(begin, end, reinterpret_cast<float*>(buffer.data() + RESULT_HEADER_BYTES));
+                MPI_Isend(buffer.data(), static_cast<int>(buffer.size()), MPI_BYTE, 0, RESULT_TAG,
+                          MPI_COMM_WORLD, &requests[slot]);
+                slot ^= 1;
+            }
+        }
+        stats.seconds = MPI_Wtime() - start;
+
+        if (streamScores) {
+            ScopedPhase phase(PHASE_GATHER);
+            if (rank == 0) {
+                // El contador está agotado: las unidades que no ha calculado el proceso 0
+                // las han calculado (o están terminando) los demás.
+                while (receivedUnits < numUnits - stats.units) {
+                    receiveUnit(units, scores, recvBuffer, true, completed);
+                    receivedUnits++;
+                }
+            }
+            TraceScope trace("MPI_Waitall", "mpi");
+            MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+        }
+    }
+    return stats;
+}
+
+// Difunde desde el proceso 0 una lista de rangos.
+static void broadcastRanges(std::vector<PairRange>& ranges) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    unsigned long long count = ranges.size();
+    MPI_Bcast(&count, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    std::vector<unsigned long long> flat(2 * count);
+    if (rank == 0) {
+        for (std::size_t k = 0; k < count; ++k) {
+            flat[2 * k] = ranges[k].begin;
+            flat[2 * k + 1] = ranges[k].end;
+        }
+    }
+    MPI_Bcast(flat.data(), static_cast<int>(flat.size()), MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    ranges.resize(count);
+    for (std::size_t k = 0; k < count; ++k)
+        ranges[k] = PairRange{ static_cast<std::size_t>(flat[2 * k]), static_cast<std::size_t>(flat[2 * k + 1]) };
+}
+
+void openRankCheckpoints(const ScreeningOptions& options, const std::vector<Molecule>& proteins,
+                         const std::vector<Molecule>& ligands, Checkpoint& checkpoint) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int ok = (rank != 0) || openCheckpoint(options, proteins, ligands, 0, true, checkpoint);
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (ok && rank != 0)
+        ok = openCheckpoint(options, proteins, ligands, rank, false, checkpoint);
+    if (!ok) {
+        std::cerr << "Error abriendo el checkpoint" << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+}
+
+std::vector<PairRange> restoreCompleted(Checkpoint* checkpoint, float* scores, HitCollector* hits) {
+    std::vector<PairRange> completed;
+    if (checkpoint == nullptr)
+        return completed;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0) {
+        completed = checkpoint->getCompleted();
+        checkpoint->restore(scores, hits);
+    }
+    broadcastRanges(completed);
+    return completed;
+}
+
+void reportRankMetrics(const ScreeningOptions& options, const std::string& backend) {
+    if (options.metricsFile.empty() && !options.docking.funnel.enabled() && options.docking.scoreCacheDir.empty())
+        return;
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    const double wallSeconds = metricsElapsedSeconds();
+
+    // Los registros de cada hilo se envían como bytes (todos los procesos comparten la
+    // representación, como en los checkpoints).
+    std::vector<MetricsSnapshot> threads = collectThreadMetrics();
+    int localBytes = static_cast<int>(threads.size() * sizeof(MetricsSnapshot));
+    std::vector<int> recvBytes(size);
+    MPI_Gather(&localBytes, 1, MPI_INT, recvBytes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::vector<int> displs(size, 0);
+    std::vector<MetricsSnapshot> all;
+    if (rank == 0) {
+        for (int r = 1; r < size; ++r)
+            displs[r] = displs[r - 1] + recvBytes[r - 1];
+        all.resize((displs[size - 1] + recvBytes[size - 1]) / sizeof(MetricsSnapshot));
+    }
+    MPI_Gatherv(threads.data(), localBytes, MPI_BYTE, all.data(), recvBytes.data(), displs.data(), MPI_BYTE,
+                0, MPI_COMM_WORLD);
+    if (rank != 0)
+        return;
+
+    std::vector<std::vector<MetricsSnapshot>> ranks(size);
+    MetricsSnapshot total;
+    for (int r = 0; r < size; ++r) {
+        const MetricsSnapshot* begin = all.data() + displs[r] / sizeof(MetricsSnapshot);
+        ranks[r].assign(begin, begin + recvBytes[r] / sizeof(MetricsSnapshot));
+        for (const MetricsSnapshot& thread : ranks[r])
+            total.add(thread);
+    }
+    if (options.docking.funnel.enabled())
+        printFunnelSummary(total);
+    if (!options.docking.scoreCacheDir.empty())
+        printScoreCacheSummary(total);
+    if (options.metricsFile.empty())
+        return;
+    printMetricsSummary(total, wallSeconds);
+    if (!writeMetricsJson(options.metricsFile, backend, ranks, wallSeconds))
+        std::cerr << "Error escribiendo el informe de métricas " << options.metricsFile << std::endl;
+}
+
+void reportRankTrace(const ScreeningOptions& options) {
+    if (options.traceFile.empty())
+        return;
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Al salir de la barrera todos los relojes marcan (casi) el mismo instante: cada
+    // proceso desplaza sus eventos para que el suyo coincida con el del proceso 0.
+    MPI_Barrier(MPI_COMM_WORLD);
+    long long now = static_cast<long long>(traceClock());
+    long long reference = now;
+    MPI_Bcast(&reference, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    uint64_t dropped = 0;
+    std::string events = formatTraceEvents(rank, "rank " + std::to_string(rank), reference - now, dropped);
+    if (dropped > 0)
+        std::cerr << "Proceso " << rank << ": " << dropped << " eventos de traza perdidos por desbordamiento" << std::endl;
+
+    int localBytes = static_cast<int>(events.size());
+    std::vector<int> recvBytes(size);
+    MPI_Gather(&localBytes, 1, MPI_INT, recvBytes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::vector<int> displs(size, 0);
+    std::string all;
+    if (rank == 0) {
+        for (int r = 1; r < size; ++r)
+            displs[r] = displs[r - 1] + recvBytes[r - 1];
+        all.resize(displs[size - 1] + recvBytes[size - 1]);
+    }
+    MPI_Gatherv(events.data(), localBytes, MPI_CHAR, &all[0], recvBytes.data(), displs.data(), MPI_CHAR,
+                0, MPI_COMM_WORLD);
+    if (rank != 0)
+        return;
+
+    std::vector<std::string> processes;
+    for (int r = 0; r < size; ++r)
+        processes.push_back(all.substr(displs[r], recvBytes[r]));
+    if (!writeChromeTrace(options.traceFile, processes))
+        std::cerr << "Error escribiendo la traza " << options.traceFile << std::endl;
+}
@@ -0,0 +1,162 @@
+#include "NodeShared.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "MoleculeLibrary.h"
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+NodeSharedMolecules::NodeSharedMolecules()
+    : nodeComm(MPI_COMM_NULL), leaderComm(MPI_COMM_NULL), nodeRank(0), nodeSize(1),
+      leaderIndex(0), shardBase(0), sharedBytes(0) {
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
+
+    // Comunicador de los procesos 0 de cada nodo y primer fragmento de cada nodo: los
+    // procesos de un nodo parsean fragmentos consecutivos.
+    MPI_Comm_split(MPI_COMM_WORLD, nodeRank == 0 ? 0 : MPI_UNDEFINED, 0, &leaderComm);
+    unsigned long long base = 0;
+    if (nodeRank == 0) {
+        unsigned long long size = static_cast<unsigned long long>(nodeSize);
+        MPI_Comm_rank(leaderComm, &leaderIndex);
+        MPI_Exscan(&size, &base, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, leaderComm);
+        if (leaderIndex == 0)
+            base = 0;
+    }
+    MPI_Bcast(&base, 1, MPI_UNSIGNED_LONG_LONG, 0, nodeComm);
+    shardBase = static_cast<std::size_t>(base);
+}
+
+NodeSharedMolecules::~NodeSharedMolecules() {
+    release();
+}
+
+// Redondea al múltiplo de LIBRARY_ALIGNMENT: cada fragmento empieza alineado en la ventana.
+static uint64_t alignBlock(uint64_t bytes) {
+    return (bytes + LIBRARY_ALIGNMENT - 1) / LIBRARY_ALIGNMENT * LIBRARY_ALIGNMENT;
+}
+
+bool NodeSharedMolecules::load(DataManager& dataManager, const std::string& path, bool proteins,
+                               std::vector<Molecule>& molecules) {
+    // Cada proceso parsea el fragmento 'shardBase + nodeRank' de los ficheros.
+    int worldSize;
+    MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
+    std::vector<Molecule> parsed;
+    dataManager.setShard(shardBase + nodeRank, worldSize);
+    int ok = proteins ? dataManager.loadProteins(path, parsed) : dataManager.loadLigands(path, parsed);
+    dataManager.setShard(0, 1);
+    const std::vector<std::string>& names = dataManager.getLastReport().sources;
+
+    // Tamaño empaquetado de cada fragmento (en bloques de LIBRARY_ALIGNMENT bytes).
+    unsigned long long localBlocks = (ok && !parsed.empty()) ? alignBlock(getLibrarySize(parsed, names)) / LIBRARY_ALIGNMENT : 0;
+    std::vector<unsigned long long> nodeBlocks(nodeSize);
+    {
+        // Aquí esperan los procesos que terminan de parsear antes que los demás.
+        TraceScope trace("MPI_Allreduce", "mpi");
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    }
+    if (!ok)
+        return false;
+    MPI_Allgather(&localBlocks, 1, MPI_UNSIGNED_LONG_LONG, nodeBlocks.data(), 1, MPI_UNSIGNED_LONG_LONG, nodeComm);
+
+    // Bloques de cada nodo y desplazamiento de cada fragmento en la ventana. Los fragmentos
+    // de un nodo son consecutivos, así que cada nodo aporta un único tramo contiguo.
+    unsigned long long thisNode = 0;
+    for (unsigned long long blocks : nodeBlocks)
+        thisNode += blocks;
+    std::vector<int> leaderBlocks, leaderDispls;
+    std::vector<unsigned long long> shardOffsets;
+    unsigned long long totalBlocks = 0;
+    if (nodeRank == 0) {
+        int leaders;
+        MPI_Comm_size(leaderComm, &leaders);
+        std::vector<unsigned long long> all(leaders);
+        MPI_Allgather(&thisNode, 1, MPI_UNSIGNED_LONG_LONG, all.data(), 1, MPI_UNSIGNED_LONG_LONG, leaderComm);
+        for (int l = 0; l < leaders; ++l) {
+            leaderDispls.push_back(static_cast<int>(totalBlocks));
+            leaderBlocks.push_back(static_cast<int>(all[l]));
+            totalBlocks += all[l];
+        }
+    }
+    MPI_Bcast(&totalBlocks, 1, MPI_UNSIGNED_LONG_LONG, 0, nodeComm);
+    unsigned long long nodeOffset = (nodeRank == 0) ? static_cast<unsigned long long>(leaderDispls[leaderIndex]) : 0;
+    MPI_Bcast(&nodeOffset, 1, MPI_UNSIGNED_LONG_LONG, 0, nodeComm);
+    if (totalBlocks > static_cast<unsigned long long>(std::numeric_limits<int>::max())) {
+        std::cerr << "Los datos compartidos superan el máximo de bloques de MPI_Allgatherv" << std::endl;
+        return false;
+    }
+
+    // Sólo el proceso 0 del nodo aporta memoria a la ventana.
+    const std::size_t bytes = static_cast<std::size_t>(totalBlocks) * LIBRARY_ALIGNMENT;
+    char* base = nullptr;
+    MPI_Win win;
+    MPI_Aint localBytes = (nodeRank == 0) ? static_cast<MPI_Aint>(bytes) : 0;
+    MPI_Win_allocate_shared(localBytes, 1, MPI_INFO_NULL, nodeComm, &base, &win);
+    windows.push_back(win);
+    sharedBytes += bytes;
+    if (nodeRank != 0) {
+        MPI_Aint size;
+        int dispUnit;
+        MPI_Win_shared_query(win, 0, &size, &dispUnit, &base);
+    }
+
+    // Cada proceso escribe su fragmento en su sitio de la ventana del nodo.
+    MPI_Win_fence(0, win);
+    unsigned long long offset = nodeOffset;
+    for (int r = 0; r < nodeRank; ++r)
+        offset += nodeBlocks[r];
+    if (localBlocks > 0) {
+        ScopedPhase phase(PHASE_FLATTEN);
+        writeLibrary(parsed, names, base + offset * LIBRARY_ALIGNMENT);
+    }
+    std::vector<Molecule>().swap(parsed);
+    MPI_Win_fence(0, win);
+
+    // Los procesos 0 de cada nodo intercambian los tramos de sus nodos.
+    if (nodeRank == 0) {
+        ScopedPhase phase(PHASE_GATHER);
+        TraceScope trace("MPI_Allgatherv", "mpi");
+        MPI_Datatype block;
+        MPI_Type_contiguous(static_cast<int>(LIBRARY_ALIGNMENT), MPI_BYTE, &block);
+        MPI_Type_commit(&block);
+        MPI_Allgatherv(MPI_IN_PLACE, 0, block, base, leaderBlocks.data(), leaderDispls.data(), block, leaderComm);
+        MPI_Type_free(&block);
+    }
+    // La ventana completa debe estar escrita antes de que los demás la lean.
+    MPI_Win_fence(0, win);
+
+    // Todos los fragmentos, en orden, recorriendo la ventana; la libera release(), así
+    // que las vistas no necesitan propietario.
+    std::size_t position = 0;
+    while (position < bytes) {
+        LibraryHeader header;
+        std::memcpy(&header, base + position, sizeof(header));
+        std::string error;
+        if (!readLibrary(base + position, static_cast<std::size_t>(header.fileSize), nullptr,
+                         molecules, nullptr, error)) {
+            std::cerr << "Error leyendo los datos compartidos del nodo: " << error << std::endl;
+            return false;
+        }
+        position += alignBlock(header.fileSize);
+    }
+    std::size_t count = molecules.size();
+    if (count == 0 && nodeRank == 0 && shardBase == 0)
+        std::cerr << "No se cargó ninguna molécula de " << path << std::endl;
+    return count > 0;
+}
+
+void NodeSharedMolecules::release() {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (finalized)
+        return;
+    for (MPI_Win& win : windows)
+        MPI_Win_free(&win);
+    windows.clear();
+    sharedBytes = 0;
+    if (leaderComm != MPI_COMM_NULL)
+        MPI_Comm_free(&leaderComm);
+    if (nodeComm != MPI_COMM_NULL)
+        MPI_Comm_free(&nodeComm);
+}
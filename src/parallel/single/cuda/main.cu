@@ -8,26 +8,24 @@
 // Se incluyen las implementaciones existentes para manejo de datos y moléculas.
 // Se asume que DataManager, Molecule, Atom, Docking y Utils se han implementado en CPU.
 #include "DataManager.h"   // Funciones de carga de proteínas y ligandos
-#include "Molecule.h"      // Definición de Molecule y Atom (struct con x, y, z y element)
+#include "Molecule.h"      // Definición de Molecule (SoA) y FlatMolecules
 #include "Docking.h"       // Versión secuencial (opcional para comparar)
 #include "Utils.h"         // parseArguments, Timer, analyzeDockingResults, etc.
+#include "Metrics.h"       // Fases y contadores del informe --metrics
 
 using namespace std;
 
-//-----------------------------------------------------------------------------
-// Estructura que usaremos en device para almacenar las coordenadas de un átomo.
-// Se omite información adicional (por ejemplo, el elemento) que no se usa en el cálculo.
-struct AtomGPU {
-    float x, y, z;
-};
-
 //-----------------------------------------------------------------------------
 // Kernel CUDA que ejecuta el docking entre cada proteína y ligando, sabiendo que
 // cada molécula tiene un número constante de átomos.
 // Los parámetros atomsPerProtein y atomsPerLigand son valores conocidos.
 __global__
-void dockingKernelConstant(const AtomGPU* proteinAtoms,
-                           const AtomGPU* ligandAtoms,
+void dockingKernelConstant(const float* proteinX,
+                           const float* proteinY,
+                           const float* proteinZ,
+                           const float* ligandX,
+                           const float* ligandY,
+                           const float* ligandZ,
                            float* scores,
                            int numProteins, int numLigands,
                            int atomsPerProtein, int atomsPerLigand)
@@ -50,12 +48,13 @@ void dockingKernelConstant(const AtomGPU* proteinAtoms,
     
     // Cálculo del potencial de Lennard-Jones para cada par de átomos de la pareja (ligando, proteína)
     for (int i = 0; i < atomsPerLigand; i++) {
-        AtomGPU aL = ligandAtoms[ligandOffset + i];
+        float lx = ligandX[ligandOffset + i];
+        float ly = ligandY[ligandOffset + i];
+        float lz = ligandZ[ligandOffset + i];
         for (int j = 0; j < atomsPerProtein; j++) {
-            AtomGPU aP = proteinAtoms[proteinOffset + j];
-            float dx = aL.x - aP.x;
-            float dy = aL.y - aP.y;
-            float dz = aL.z - aP.z;
+            float dx = lx - proteinX[proteinOffset + j];
+            float dy = ly - proteinY[proteinOffset + j];
+            float dz = lz - proteinZ[proteinOffset + j];
             float r2 = dx * dx + dy * dy + dz * dz;
             if (r2 < 1e-6f)
                 continue;
@@ -79,21 +78,43 @@ int main(int argc, char* argv[])
     const int ATOMS_PER_LIGAND  = 100;
     
     // Variables de entrada (directorios, modo verbose, etc.)
-    string proteinsDir, ligandsDir;
-    bool verbose = false;
-    
-    parseArguments(argc, argv, proteinsDir, ligandsDir, verbose);
+    ScreeningOptions options;
+    parseArguments(argc, argv, options);
+    if (options.docking.useCutoff()) {
+         cerr << "Aviso: el kernel CUDA evalúa todas las parejas de átomos; se ignora --cutoff." << endl;
+    }
+    if (options.docking.forceField != FORCEFIELD_UNIFORM) {
+         cerr << "Aviso: el kernel CUDA usa parámetros LJ uniformes; se ignora --forcefield." << endl;
+    }
+    if (options.docking.grid.enabled) {
+         cerr << "Aviso: el kernel CUDA evalúa todas las parejas de átomos; se ignora --grid." << endl;
+    }
+    if (options.docking.funnel.enabled()) {
+         cerr << "Aviso: el backend CUDA puntúa todos los pares; se ignora el embudo (--funnel-*)." << endl;
+    }
+    if (options.docking.octree.enabled) {
+         cerr << "Aviso: el kernel CUDA evalúa todas las parejas de átomos; se ignora --octree." << endl;
+    }
+    if (!options.docking.scoreCacheDir.empty()) {
+         cerr << "Aviso: el kernel CUDA puntúa todos los pares en un lanzamiento; se ignora --score-cache." << endl;
+    }
+    if (!options.incrementalDir.empty()) {
+         cerr << "Aviso: el backend CUDA no admite el cribado incremental; se ignora --incremental." << endl;
+    }
+    if (options.stream) {
+         cerr << "Aviso: el backend CUDA copia todos los ligandos a la GPU de una vez; se ignora --stream." << endl;
+    }
     
     // Carga de moléculas usando DataManager (implementado en CPU)
     DataManager dataManager;
     vector<Molecule> proteins;
     vector<Molecule> ligands;
     
-    if (!dataManager.loadProteins(proteinsDir, proteins)) {
+    if (!dataManager.loadProteins(options.proteinsDir, proteins)) {
         cerr << "Error loading proteins." << endl;
         exit(EXIT_FAILURE);
     }
-    if (!dataManager.loadLigands(ligandsDir, ligands)) {
+    if (!dataManager.loadLigands(options.ligandsDir, ligands)) {
         cerr << "Error loading ligands." << endl;
         exit(EXIT_FAILURE);
     }
@@ -104,54 +125,41 @@ int main(int argc, char* argv[])
     
     // Se valida que cada proteína y ligando tenga el número de átomos esperado:
     for (const auto &protein : proteins) {
-         assert(protein.getAtoms().size() == ATOMS_PER_PROTEIN);
+         assert(protein.getAtomCount() == ATOMS_PER_PROTEIN);
     }
     for (const auto &ligand : ligands) {
-         assert(ligand.getAtoms().size() == ATOMS_PER_LIGAND);
-    }
-    
-    // Se construyen arreglos aplanados de átomos para proteínas y ligandos.
-    // Cada proteína ocupará un bloque de ATOMS_PER_PROTEIN y similarmente para ligandos.
-    vector<AtomGPU> flatProteinAtoms(numProteins * ATOMS_PER_PROTEIN);
-    vector<AtomGPU> flatLigandAtoms(numLigands * ATOMS_PER_LIGAND);
-    
-    // Transferir datos de proteínas a un arreglo lineal
-    for (int i = 0; i < numProteins; i++) {
-         const vector<Atom>& atoms = proteins[i].getAtoms();
-         for (int j = 0; j < ATOMS_PER_PROTEIN; j++) {
-             flatProteinAtoms[i * ATOMS_PER_PROTEIN + j].x = atoms[j].x;
-             flatProteinAtoms[i * ATOMS_PER_PROTEIN + j].y = atoms[j].y;
-             flatProteinAtoms[i * ATOMS_PER_PROTEIN + j].z = atoms[j].z;
-         }
-    }
-    
-    // Transferir datos de ligandos a un arreglo lineal
-    for (int i = 0; i < numLigands; i++) {
-         const vector<Atom>& atoms = ligands[i].getAtoms();
-         for (int j = 0; j < ATOMS_PER_LIGAND; j++) {
-             flatLigandAtoms[i * ATOMS_PER_LIGAND + j].x = atoms[j].x;
-             flatLigandAtoms[i * ATOMS_PER_LIGAND + j].y = atoms[j].y;
-             flatLigandAtoms[i * ATOMS_PER_LIGAND + j].z = atoms[j].z;
-         }
+         assert(ligand.getAtomCount() == ATOMS_PER_LIGAND);
     }
     
-    // Reservar memoria en la GPU para los átomos aplanados y para el vector de scores
-    AtomGPU *d_proteinAtoms, *d_ligandAtoms;
+    // Se usa la disposición SoA aplanada de Molecule.h: cada proteína ocupa un bloque
+    // contiguo de ATOMS_PER_PROTEIN átomos en x[], y[] y z[] (y similarmente para ligandos).
+    Timer flattenTimer;
+    flattenTimer.start();
+    FlatMolecules flatProteins = flattenMolecules(proteins);
+    FlatMolecules flatLigands  = flattenMolecules(ligands);
+    flattenTimer.stop();
+    addMetricPhase(PHASE_FLATTEN, flattenTimer.elapsedMilliseconds() / 1000.0);
+    
+    // Reservar memoria en la GPU para las coordenadas aplanadas y para el vector de scores
+    float *d_proteinX, *d_proteinY, *d_proteinZ;
+    float *d_ligandX, *d_ligandY, *d_ligandZ;
     float* d_scores;
-    size_t sizeProteinAtoms = flatProteinAtoms.size() * sizeof(AtomGPU);
-    size_t sizeLigandAtoms  = flatLigandAtoms.size() * sizeof(AtomGPU);
-    size_t sizeScores       = totalDockings * sizeof(float);
+    size_t sizeProteinCoords = flatProteins.x.size() * sizeof(float);
+    size_t sizeLigandCoords  = flatLigands.x.size() * sizeof(float);
+    size_t sizeScores        = totalDockings * sizeof(float);
+    
+    float** deviceArrays[] = { &d_proteinX, &d_proteinY, &d_proteinZ,
+                               &d_ligandX, &d_ligandY, &d_ligandZ };
+    size_t deviceSizes[] = { sizeProteinCoords, sizeProteinCoords, sizeProteinCoords,
+                             sizeLigandCoords, sizeLigandCoords, sizeLigandCoords };
     
     cudaError_t err;
-    err = cudaMalloc((void**)&d_proteinAtoms, sizeProteinAtoms);
-    if (err != cudaSuccess) {
-         cerr << "Error allocando memoria para d_proteinAtoms: " << cudaGetErrorString(err) << endl;
-         exit(EXIT_FAILURE);
-    }
-    err = cudaMalloc((void**)&d_ligandAtoms, sizeLigandAtoms);
-    if (err != cudaSuccess) {
-         cerr << "Error allocando memoria para d_ligandAtoms: " << cudaGetErrorString(err) << endl;
-         exit(EXIT_FAILURE);
+    for (int k = 0; k < 6; k++) {
+         err = cudaMalloc((void**)deviceArrays[k], deviceSizes[k]);
+         if (err != cudaSuccess) {
+              cerr << "Error allocando memoria para las coordenadas: " << cudaGetErrorString(err) << endl;
+              exit(EXIT_FAILURE);
+         }
     }
     err = cudaMalloc((void**)&d_scores, sizeScores);
     if (err != cudaSuccess) {
@@ -160,8 +168,12 @@ int main(int argc, char* argv[])
     }
     
     // Transferir datos desde host a device
-    cudaMemcpy(d_proteinAtoms, flatProteinAtoms.data(), sizeProteinAtoms, cudaMemcpyHostToDevice);
-    cudaMemcpy(d_ligandAtoms, flatLigandAtoms.data(), sizeLigandAtoms, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinX, flatProteins.x.data(), sizeProteinCoords, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinY, flatProteins.y.data(), sizeProteinCoords, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_proteinZ, flatProteins.z.data(), sizeProteinCoords, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandX, flatLigands.x.data(), sizeLigandCoords, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandY, flatLigands.y.data(), sizeLigandCoords, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ligandZ, flatLigands.z.data(), sizeLigandCoords, cudaMemcpyHostToDevice);
     
     // Configurar los parámetros para el lanzamiento del kernel: cada hilo calcula una combinación proteína-ligando
     int threadsPerBlock = 256;
@@ -175,8 +187,12 @@ int main(int argc, char* argv[])
     cudaEventCreate(&stop);
     
     cudaEventRecord(start);
-    dockingKernelConstant<<<blocksPerGrid, threadsPerBlock>>>(d_proteinAtoms,
-                                                              d_ligandAtoms,
+    dockingKernelConstant<<<blocksPerGrid, threadsPerBlock>>>(d_proteinX,
+                                                              d_proteinY,
+                                                              d_proteinZ,
+                                                              d_ligandX,
+                                                              d_ligandY,
+                                                              d_ligandZ,
                                                               d_scores,
                                                               numProteins,
                                                               numLigands,
@@ -188,18 +204,38 @@ int main(int argc, char* argv[])
     float milliseconds = 0;
     cudaEventElapsedTime(&milliseconds, start, stop);
     cout << "Tiempo de ejecución (kernel GPU): " << milliseconds << " ms" << endl;
-    
-    // Copiar resultados (scores) desde la GPU al host
+    // El kernel se mide con eventos CUDA; su tiempo se registra como la fase de cálculo.
+    addMetricPhase(PHASE_COMPUTE, milliseconds / 1000.0);
+    addMetricCounter(COUNTER_PAIRS, static_cast<uint64_t>(totalDockings));
+    addMetricCounter(COUNTER_INTERACTIONS,
+                     static_cast<uint64_t>(totalDockings) * ATOMS_PER_PROTEIN * ATOMS_PER_LIGAND);
+    addMetricCounter(COUNTER_EQUIVALENT_INTERACTIONS,
+                     static_cast<uint64_t>(totalDockings) * ATOMS_PER_PROTEIN * ATOMS_PER_LIGAND);
+    
+    // Copiar resultados (scores) desde la GPU al host. Con --top/--threshold la matriz
+    // completa ya está en el host, así que los hits se filtran sobre ella.
     vector<float> scores(totalDockings);
-    cudaMemcpy(scores.data(), d_scores, sizeScores, cudaMemcpyDeviceToHost);
+    HitCollector hits(options.hits);
+    {
+         ScopedPhase phase(PHASE_GATHER);
+         cudaMemcpy(scores.data(), d_scores, sizeScores, cudaMemcpyDeviceToHost);
+         if (options.hits.enabled()) {
+              for (int i = 0; i < numProteins; i++)
+                   for (int j = 0; j < numLigands; j++)
+                        hits.add(i, j, scores[static_cast<size_t>(i) * numLigands + j]);
+         }
+    }
     
     // (Opcional) Análisis de resultados
-    if (verbose)
+    if (options.hits.enabled())
+         reportHits(hits);
+    else if (options.verbose)
          analyzeDockingResults(scores, numProteins, numLigands);
+    reportMetrics(options, "cuda");
     
     // Liberar memoria en la GPU y destruir eventos
-    cudaFree(d_proteinAtoms);
-    cudaFree(d_ligandAtoms);
+    for (int k = 0; k < 6; k++)
+         cudaFree(*deviceArrays[k]);
     cudaFree(d_scores);
     cudaEventDestroy(start);
     cudaEventDestroy(stop);
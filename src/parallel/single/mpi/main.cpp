@@ -6,11 +6,80 @@
 #include "Molecule.h"
 #include "Docking.h"
 #include "Utils.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Partition.h"
+#include "MpiCommon.h"
+#include "NodeShared.h"
 #include <mpi.h>
 
+// Returns the estimated cost share of [start, end).
+static double costShare(const PairCostModel& model, size_t start, size_t end) {
+    return model.totalCost() > 0.0 ? model.rangeCost(start, end) / model.totalCost() : 0.0;
+}
+
+// Dynamic variant: every rank, rank 0 included, pulls cost-balanced work units from a
+// shared MPI_Fetch_and_op counter, and score chunks stream back to rank 0 with
+// non-blocking sends that overlap the next unit. With a checkpoint, only the pending
+// pairs are split into units and every finished unit is recorded: its scores by rank 0
+// as they arrive, or the hits of a per-unit collector by the rank that computed it.
+static void mpi_docking_dynamic(const std::vector<Molecule>& ligands,
+                                const PairCostModel& model,
+                                const DockingScorer& scorer,
+                                std::vector<float>& scores,
+                                HitCollector* hits,
+                                Checkpoint* checkpoint) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    size_t total = model.getNumPairs();
+
+    HitCollector local(hits != nullptr ? hits->getCriteria() : HitCriteria());
+    if (rank == 0 && hits == nullptr)
+        scores.resize(total);
+    std::vector<PairRange> completed = restoreCompleted(checkpoint, hits == nullptr ? scores.data() : nullptr,
+                                                        hits != nullptr ? &local : nullptr);
+    size_t numUnits = checkpoint != nullptr ? checkpointUnits(size) : size * DYNAMIC_UNITS_PER_RANK;
+    std::vector<PairRange> units = model.splitRanges(pendingRanges(completed, total), std::min(total, numUnits));
+
+    double cost = 0.0;
+    DynamicStats stats = runDynamicSchedule(units, hits == nullptr,
+        [&](size_t begin, size_t end, float* out) {
+            ScopedPhase phase(PHASE_COMPUTE);
+            TraceScope trace("unit", "compute", begin, end);
+            cost += model.rangeCost(begin, end);
+            HitCollector unitHits(local.getCriteria());
+            for (size_t idx = begin; idx < end; ++idx) {
+                size_t i = idx / ligands.size();
+                size_t j = idx % ligands.size();
+                float score = scorer.score(i, ligands[j]);
+                if (out != nullptr)
+                    out[idx - begin] = score;
+                else
+                    unitHits.add(i, j, score);
+            }
+            if (out == nullptr && checkpoint != nullptr)
+                checkpoint->recordHits(PairRange{ begin, end }, unitHits);
+            local.merge(unitHits);
+        }, scores,
+        [&](const PairRange& unit, const float* unitScores) {
+            if (checkpoint != nullptr)
+                checkpoint->recordScores(unit, unitScores);
+        });
+    reportRankBalance(stats.seconds, model.totalCost() > 0.0 ? cost / model.totalCost() : 0.0);
+    if (hits != nullptr)
+        *hits = gatherHits(local);
+}
+
+// Fills 'scores' on rank 0 or, if 'hits' is given, collects only the hits there.
+// A checkpoint implies the dynamic schedule.
 void mpi_docking(const std::vector<Molecule>& proteins,
                  const std::vector<Molecule>& ligands,
-                 std::vector<float>& scores) {
+                 const DockingParams& params,
+                 bool dynamicSchedule,
+                 std::vector<float>& scores,
+                 HitCollector* hits,
+                 Checkpoint* checkpoint) {
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
@@ -18,23 +87,58 @@ void mpi_docking(const std::vector<Molecule>& proteins,
     if (rank == 0) {
         std::cout << "Executing docking with MPI..." << std::endl;
         std::cout << "Total number of processes: " << size << std::endl;
+        if (dynamicSchedule || checkpoint != nullptr)
+            std::cout << "Dynamic work distribution (shared counter, streamed results)" << std::endl;
     }
 
     size_t total = proteins.size() * ligands.size();
-    size_t chunk = total / size;
-    size_t remainder = total % size;
 
-    // Calculate the range of indices to process per process
-    size_t start = rank * chunk + (rank < remainder ? rank : remainder);
-    size_t end = start + chunk + (rank < remainder ? 1 : 0);
+    PairCostModel model(proteins, ligands, params);
+    DockingScorer scorer(proteins, params, ligands);
+    if (rank == 0)
+        reportApproximationError(scorer);
+    if (dynamicSchedule || checkpoint != nullptr) {
+        mpi_docking_dynamic(ligands, model, scorer, scores, hits, checkpoint);
+        return;
+    }
+
+    // Contiguous range of indices per process with a similar estimated cost
+    std::vector<size_t> bounds = model.splitRange(0, total, size);
+    size_t start = bounds[rank];
+    size_t end = bounds[rank + 1];
+    double computeStart = MPI_Wtime();
+
+    // Streaming hit mode: only the bounded local hits are sent to rank 0.
+    if (hits != nullptr) {
+        HitCollector local(hits->getCriteria());
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            TraceScope trace("chunk", "compute", start, end);
+            for (size_t idx = start; idx < end; ++idx) {
+                size_t i = idx / ligands.size();
+                size_t j = idx % ligands.size();
+                local.add(i, j, scorer.score(i, ligands[j]));
+            }
+        }
+        reportRankBalance(MPI_Wtime() - computeStart, costShare(model, start, end));
+        *hits = gatherHits(local);
+        return;
+    }
 
     std::vector<float> localScores(end - start);
-    for (size_t idx = start; idx < end; ++idx) {
-        size_t i = idx / ligands.size();
-        size_t j = idx % ligands.size();
-        localScores[idx - start] = performDocking(proteins[i], ligands[j]);
+    {
+        ScopedPhase phase(PHASE_COMPUTE);
+        TraceScope trace("chunk", "compute", start, end);
+        for (size_t idx = start; idx < end; ++idx) {
+            size_t i = idx / ligands.size();
+            size_t j = idx % ligands.size();
+            localScores[idx - start] = scorer.score(i, ligands[j]);
+        }
     }
+    reportRankBalance(MPI_Wtime() - computeStart, costShare(model, start, end));
 
+    ScopedPhase phase(PHASE_GATHER);
+    TraceScope trace("MPI_Gatherv", "mpi");
     // Process 0 reserves space to store all results
     if (rank == 0) {
         scores.resize(total);
@@ -57,46 +161,106 @@ void mpi_docking(const std::vector<Molecule>& proteins,
                 scores.data(), recvCounts.data(), displs.data(), MPI_FLOAT, 0, MPI_COMM_WORLD);
 }
 
+// Streaming run: every rank streams its byte-balanced share of the ligand files through
+// a bounded queue and scores each batch against all proteins as it arrives; only the
+// hits reach rank 0.
+static void stream_docking(const std::vector<Molecule>& proteins, const ScreeningOptions& options) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        std::cout << "Executing streaming docking with MPI..." << std::endl;
+    DockingScorer scorer(proteins, options.docking);
+    if (rank == 0)
+        reportApproximationError(scorer);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t1 = MPI_Wtime();
+    HitCollector hits = streamRankLigands(options, scorer, proteins.size());
+    {
+        TraceScope trace("MPI_Barrier", "mpi");
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    double t2 = MPI_Wtime();
+    scorer.flushScoreCache();
+    if (rank == 0) {
+        std::cout << "Execution time: " << (t2 - t1) * 1000 << " ms" << std::endl;
+        reportHits(hits);
+    }
+    reportRankMetrics(options, "mpi");
+    reportRankTrace(options);
+}
+
 int main(int argc, char* argv[]) {
 
     MPI_Init(&argc, &argv);
 
-    std::string proteinsDir;
-    std::string ligandsDir;
-    bool verbose;
-    
-    parseArguments(argc, argv, proteinsDir, ligandsDir, verbose);
+    ScreeningOptions options;
+    parseArguments(argc, argv, options);
 
     DataManager dataManager;
     std::vector<Molecule> proteins;
     std::vector<Molecule> ligands;
 
-    if (!dataManager.loadProteins(proteinsDir, proteins)) {
+    // Every rank parses a disjoint share of the files; every rank on a node reads the
+    // assembled data in place from a node-shared window.
+    NodeSharedMolecules shared;
+    if (!shared.load(dataManager, options.proteinsDir, true, proteins)) {
         std::cerr << "Error loading proteins." << std::endl;
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
-    if (!dataManager.loadLigands(ligandsDir, ligands)) {
+    if (options.stream) {
+        stream_docking(proteins, options);
+        proteins.clear();
+        shared.release();
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+    if (!shared.load(dataManager, options.ligandsDir, false, ligands)) {
         std::cerr << "Error loading ligands." << std::endl;
         MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     }
+    if (options.verbose && shared.getNodeRank() == 0) {
+        std::cout << "Node-shared molecule data: " << shared.getSharedBytes() / 1024 << " KB, shared by "
+                  << shared.getNodeSize() << " ranks; files parsed in shares across all ranks" << std::endl;
+    }
+
+    Checkpoint checkpoint;
+    const bool useCheckpoint = !options.checkpointDir.empty();
+    if (useCheckpoint)
+        openRankCheckpoints(options, proteins, ligands, checkpoint);
 
     double t1, t2;
     MPI_Barrier(MPI_COMM_WORLD);
     t1 = MPI_Wtime();
     
     std::vector<float> scores;
-    mpi_docking(proteins, ligands, scores);
+    HitCollector hits(options.hits);
+    mpi_docking(proteins, ligands, options.docking, options.dynamicSchedule, scores, options.hits.enabled() ? &hits : nullptr,
+                useCheckpoint ? &checkpoint : nullptr);
+    checkpoint.close();
     
-    MPI_Barrier(MPI_COMM_WORLD);
+    {
+        TraceScope trace("MPI_Barrier", "mpi");
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
     t2 = MPI_Wtime();
 
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    if (rank == 0)
+    if (rank == 0) {
         std::cout << "Execution time: " << (t2 - t1) * 1000 << " ms" << std::endl;
-    if (rank == 0 && verbose)
+        saveIncrementalResults(options, proteins, ligands, scores);
+    }
+    if (rank == 0 && options.hits.enabled())
+        reportHits(hits);
+    else if (rank == 0 && options.verbose)
         analyzeDockingResults(scores, proteins.size(), ligands.size());
+    reportRankMetrics(options, "mpi");
+    reportRankTrace(options);
     
+    // The molecules are views on the node-shared windows, which must go before MPI_Finalize.
+    proteins.clear();
+    ligands.clear();
+    shared.release();
     MPI_Finalize();
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -6,63 +6,364 @@
 #include "Molecule.h"
 #include "Docking.h"
 #include "Utils.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "CacheInfo.h"
+#include "Partition.h"
 #include <omp.h>
 
+// Prints the throughput of a docking run in protein-ligand pairs per second.
+static void reportThroughput(size_t pairs, double seconds) {
+    if (seconds > 0.0)
+        std::cout << "Throughput: " << static_cast<double>(pairs) / seconds << " pairs/s" << std::endl;
+}
+
+// Prints the per-thread time and estimated cost share of a cost-partitioned run.
+static void reportThreadBalance(const PairCostModel& model, const std::vector<size_t>& bounds,
+                                const std::vector<double>& times) {
+    std::vector<double> shares(times.size());
+    for (size_t t = 0; t < times.size(); ++t)
+        shares[t] = model.totalCost() > 0.0 ? model.rangeCost(bounds[t], bounds[t + 1]) / model.totalCost() : 0.0;
+    printLoadBalance("thread", times, shares);
+}
+
 std::vector<float> omp_docking(const std::vector<Molecule>& proteins, 
-                               const std::vector<Molecule>& ligands) {
+                               const std::vector<Molecule>& ligands,
+                               const DockingParams& params) {
     size_t total = proteins.size() * ligands.size();
     std::vector<float> scores(total);
     
     double t1 = omp_get_wtime();
 
+    DockingScorer scorer(proteins, params, ligands);
+    reportApproximationError(scorer);
+    PairCostModel model(proteins, ligands, params);
+    std::vector<size_t> bounds;
+    std::vector<double> times;
+
     #pragma omp parallel 
     {
-        #pragma omp master
+        // Each thread gets a contiguous range of pairs with a similar estimated cost.
+        #pragma omp single
         {
             std::cout << "Running docking with OpenMP with " 
                     << omp_get_num_threads() << " active threads..." << std::endl;
+            bounds = model.splitRange(0, total, omp_get_num_threads());
+            times.resize(omp_get_num_threads());
         }
         
-        #pragma omp for schedule(static) collapse(2)
-        for (size_t i = 0; i < proteins.size(); ++i) {
-            for (size_t j = 0; j < ligands.size(); ++j) {
-                size_t idx = i * ligands.size() + j;
-                scores[idx] = performDocking(proteins[i], ligands[j]);
+        const int t = omp_get_thread_num();
+        double start = omp_get_wtime();
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            TraceScope trace("chunk", "compute", bounds[t], bounds[t + 1]);
+            for (size_t idx = bounds[t]; idx < bounds[t + 1]; ++idx) {
+                scores[idx] = scorer.score(idx / ligands.size(), ligands[idx % ligands.size()]);
             }
         }
+        times[t] = omp_get_wtime() - start;
     }
     double t2 = omp_get_wtime();
     std::cout << "Execution time: " << (t2 - t1)*1000 << " ms" << std::endl;
+    reportThroughput(total, t2 - t1);
+    reportThreadBalance(model, bounds, times);
 
     return scores;
 }
 
+// Same loop as omp_docking, but each thread keeps its own bounded HitCollector and the
+// collectors are merged at the end, so memory stays O(K * threads).
+HitCollector omp_docking_hits(const std::vector<Molecule>& proteins,
+                              const std::vector<Molecule>& ligands,
+                              const DockingParams& params,
+                              const HitCriteria& criteria) {
+    HitCollector hits(criteria);
+
+    double t1 = omp_get_wtime();
+
+    DockingScorer scorer(proteins, params, ligands);
+    reportApproximationError(scorer);
+    PairCostModel model(proteins, ligands, params);
+    std::vector<size_t> bounds;
+    std::vector<double> times;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            std::cout << "Running docking with OpenMP with "
+                    << omp_get_num_threads() << " active threads (streaming hits)..." << std::endl;
+            bounds = model.splitRange(0, model.getNumPairs(), omp_get_num_threads());
+            times.resize(omp_get_num_threads());
+        }
+
+        const int t = omp_get_thread_num();
+        double start = omp_get_wtime();
+        HitCollector local(criteria);
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            TraceScope trace("chunk", "compute", bounds[t], bounds[t + 1]);
+            for (size_t idx = bounds[t]; idx < bounds[t + 1]; ++idx) {
+                size_t i = idx / ligands.size();
+                size_t j = idx % ligands.size();
+                local.add(i, j, scorer.score(i, ligands[j]));
+            }
+        }
+        times[t] = omp_get_wtime() - start;
+        {
+            ScopedPhase phase(PHASE_GATHER);
+            #pragma omp critical
+            hits.merge(local);
+        }
+    }
+    double t2 = omp_get_wtime();
+    std::cout << "Execution time: " << (t2 - t1)*1000 << " ms" << std::endl;
+    reportThroughput(proteins.size() * ligands.size(), t2 - t1);
+    reportThreadBalance(model, bounds, times);
+
+    return hits;
+}
+
+// Cache-blocked variant: the work is split into (protein, ligand batch) tiles. Inside a
+// tile, each block of protein atoms stays in L1 while it is scored against the whole
+// batch, whose coordinates stay in L2. Tile sizes come from the detected cache sizes.
+// Fills 'hits' if given (per-thread collectors), otherwise returns the score matrix.
+std::vector<float> omp_docking_tiled(const std::vector<Molecule>& proteins,
+                                     const std::vector<Molecule>& ligands,
+                                     const DockingParams& params,
+                                     HitCollector* hits) {
+    size_t total = proteins.size() * ligands.size();
+    std::vector<float> scores(hits == nullptr ? total : 0);
+
+    size_t ligandAtoms = 0;
+    for (const Molecule& ligand : ligands)
+        ligandAtoms += ligand.getAtomCount();
+    const CacheSizes& caches = getCacheSizes();
+    const TileSizes tiles = chooseTileSizes(caches, ligands.empty() ? 1 : ligandAtoms / ligands.size());
+    const size_t numBatches = (ligands.size() + tiles.ligands - 1) / tiles.ligands;
+
+    double t1 = omp_get_wtime();
+
+    DockingScorer scorer(proteins, params, ligands);
+    reportApproximationError(scorer);
+    std::vector<double> times;
+
+    #pragma omp parallel
+    {
+        #pragma omp master
+        {
+            std::cout << "Running tiled docking with OpenMP with "
+                    << omp_get_num_threads() << " active threads..." << std::endl;
+            std::cout << "Tiles: " << tiles.proteinAtoms << " protein atoms x " << tiles.ligands
+                      << " ligands (" << describeCacheSizes(caches) << ")" << std::endl;
+        }
+
+        #pragma omp single
+        times.resize(omp_get_num_threads());
+
+        double start = omp_get_wtime();
+        HitCollector local(hits != nullptr ? hits->getCriteria() : HitCriteria());
+        std::vector<float> batchScores(hits != nullptr ? tiles.ligands : 0);
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            #pragma omp for schedule(dynamic) collapse(2) nowait
+            for (size_t i = 0; i < proteins.size(); ++i) {
+                for (size_t b = 0; b < numBatches; ++b) {
+                    size_t first = b * tiles.ligands;
+                    size_t last = std::min(first + tiles.ligands, ligands.size());
+                    TraceScope trace("tile", "compute", i * ligands.size() + first, i * ligands.size() + last);
+                    if (hits == nullptr) {
+                        scorer.scoreBatch(i, ligands, first, last, tiles.proteinAtoms,
+                                          scores.data() + i * ligands.size() + first);
+                        continue;
+                    }
+                    scorer.scoreBatch(i, ligands, first, last, tiles.proteinAtoms, batchScores.data());
+                    for (size_t j = first; j < last; ++j)
+                        local.add(i, j, batchScores[j - first]);
+                }
+            }
+        }
+        times[omp_get_thread_num()] = omp_get_wtime() - start;
+        if (hits != nullptr) {
+            ScopedPhase phase(PHASE_GATHER);
+            #pragma omp critical
+            hits->merge(local);
+        }
+    }
+    double t2 = omp_get_wtime();
+    std::cout << "Execution time: " << (t2 - t1)*1000 << " ms" << std::endl;
+    reportThroughput(total, t2 - t1);
+    // Tiles are handed out dynamically, so there is no static cost share to report.
+    printLoadBalance("thread", times, std::vector<double>());
+
+    return scores;
+}
+
+// Checkpointed run: the pending pairs are split into cost-balanced units that threads
+// take dynamically. Every finished unit (its scores, or the hits of a per-unit
+// collector) is queued to the checkpoint, whose writer thread does the I/O.
+static void omp_docking_checkpointed(const std::vector<Molecule>& proteins,
+                                     const std::vector<Molecule>& ligands,
+                                     const ScreeningOptions& options,
+                                     std::vector<float>& scores,
+                                     HitCollector& hits) {
+    Checkpoint checkpoint;
+    if (!openCheckpoint(options, proteins, ligands, 0, true, checkpoint)) {
+        std::cerr << "Error opening the checkpoint." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t total = proteins.size() * ligands.size();
+    const bool keepHits = options.hits.enabled();
+    if (!keepHits)
+        scores.resize(total);
+    checkpoint.restore(keepHits ? nullptr : scores.data(), keepHits ? &hits : nullptr);
+
+    double t1 = omp_get_wtime();
+
+    DockingScorer scorer(proteins, options.docking, ligands);
+    reportApproximationError(scorer);
+    PairCostModel model(proteins, ligands, options.docking);
+    std::vector<PairRange> units = model.splitRanges(pendingRanges(checkpoint.getCompleted(), total),
+                                                     checkpointUnits(omp_get_max_threads()));
+    size_t pairs = 0;
+    for (const PairRange& unit : units)
+        pairs += unit.end - unit.begin;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        std::cout << "Running checkpointed docking with OpenMP with " << omp_get_num_threads()
+                  << " active threads (" << units.size() << " work units)..." << std::endl;
+
+        HitCollector local(options.hits);
+        {
+            ScopedPhase phase(PHASE_COMPUTE);
+            #pragma omp for schedule(dynamic) nowait
+            for (size_t u = 0; u < units.size(); ++u) {
+                const PairRange& unit = units[u];
+                TraceScope trace("unit", "compute", unit.begin, unit.end);
+                HitCollector unitHits(options.hits);
+                for (size_t idx = unit.begin; idx < unit.end; ++idx) {
+                    size_t i = idx / ligands.size();
+                    size_t j = idx % ligands.size();
+                    float score = scorer.score(i, ligands[j]);
+                    if (keepHits)
+                        unitHits.add(i, j, score);
+                    else
+                        scores[idx] = score;
+                }
+                if (keepHits) {
+                    checkpoint.recordHits(unit, unitHits);
+                    local.merge(unitHits);
+                } else {
+                    checkpoint.recordScores(unit, scores.data() + unit.begin);
+                }
+            }
+        }
+        if (keepHits) {
+            ScopedPhase phase(PHASE_GATHER);
+            #pragma omp critical
+            hits.merge(local);
+        }
+    }
+    double t2 = omp_get_wtime();
+    checkpoint.close();
+    std::cout << "Execution time: " << (t2 - t1)*1000 << " ms" << std::endl;
+    reportThroughput(pairs, t2 - t1);
+}
+
+// Streaming run: loader threads parse the ligands in batches into a bounded queue and
+// every OpenMP thread takes the next batch and scores it against all proteins, so the
+// library never has to fit in memory and parsing overlaps scoring.
+static void omp_docking_stream(const std::vector<Molecule>& proteins, const ScreeningOptions& options) {
+    double t1 = omp_get_wtime();
+    DockingScorer scorer(proteins, options.docking);
+    reportApproximationError(scorer);
+    LigandStream stream;
+    if (!stream.open(options.ligandsDir, options.streamLoaders, DEFAULT_STREAM_QUEUE_BATCHES)) {
+        std::cerr << "Error loading ligands." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::cout << "Running streaming docking with OpenMP with " << omp_get_max_threads() << " threads and "
+              << options.streamLoaders << " loader threads..." << std::endl;
+    HitCollector hits(options.hits);
+    screenLigandStream(scorer, proteins.size(), stream, hits);
+    stream.close();
+    double t2 = omp_get_wtime();
+    std::cout << "Execution time: " << (t2 - t1)*1000 << " ms" << std::endl;
+    reportThroughput(proteins.size() * stream.getMolecules(), t2 - t1);
+    printStreamSummary(stream, options.streamLoaders);
+    reportHits(hits);
+}
 
 int main(int argc, char* argv[]) {
 
-    std::string proteinsDir;
-    std::string ligandsDir;
-    bool verbose;
-    
-    parseArguments(argc, argv, proteinsDir, ligandsDir, verbose);
+    ScreeningOptions options;
+    parseArguments(argc, argv, options);
 
     DataManager dataManager;
     std::vector<Molecule> proteins;
     std::vector<Molecule> ligands;
 
-    if (!dataManager.loadProteins(proteinsDir, proteins)) {
+    if (!dataManager.loadProteins(options.proteinsDir, proteins)) {
         std::cerr << "Error loading proteins." << std::endl;
         exit(EXIT_FAILURE);
     }
-    if (!dataManager.loadLigands(ligandsDir, ligands)) {
+    if (options.stream) {
+        if (options.tiled)
+            std::cout << "--tiled is not used with --stream." << std::endl;
+        omp_docking_stream(proteins, options);
+        reportMetrics(options, "omp");
+        reportTrace(options, "omp");
+        exit(EXIT_SUCCESS);
+    }
+    if (!dataManager.loadLigands(options.ligandsDir, ligands)) {
         std::cerr << "Error loading ligands." << std::endl;
         exit(EXIT_FAILURE);
     }
 
-    std::vector<float> scores = omp_docking(proteins, ligands);
+    if (!options.checkpointDir.empty()) {
+        if (options.tiled)
+            std::cout << "--tiled is not used with --checkpoint." << std::endl;
+        HitCollector hits(options.hits);
+        std::vector<float> scores;
+        omp_docking_checkpointed(proteins, ligands, options, scores, hits);
+        saveIncrementalResults(options, proteins, ligands, scores);
+        if (options.hits.enabled())
+            reportHits(hits);
+        else if (options.verbose)
+            analyzeDockingResults(scores, proteins.size(), ligands.size());
+        reportMetrics(options, "omp");
+        reportTrace(options, "omp");
+        exit(EXIT_SUCCESS);
+    }
+
+    if (options.tiled) {
+        HitCollector hits(options.hits);
+        std::vector<float> scores = omp_docking_tiled(proteins, ligands, options.docking,
+                                                      options.hits.enabled() ? &hits : nullptr);
+        if (options.hits.enabled())
+            reportHits(hits);
+        else if (options.verbose)
+            analyzeDockingResults(scores, proteins.size(), ligands.size());
+        reportMetrics(options, "omp");
+        reportTrace(options, "omp");
+        exit(EXIT_SUCCESS);
+    }
+
+    if (options.hits.enabled()) {
+        reportHits(omp_docking_hits(proteins, ligands, options.docking, options.hits));
+        reportMetrics(options, "omp");
+        reportTrace(options, "omp");
+        exit(EXIT_SUCCESS);
+    }
+
+    std::vector<float> scores = omp_docking(proteins, ligands, options.docking);
 
-    if(verbose)
+    if(options.verbose)
         analyzeDockingResults(scores, proteins.size(), ligands.size());
+    reportMetrics(options, "omp");
+    reportTrace(options, "omp");
     
     exit(EXIT_SUCCESS);
 }
\ No newline at end of file
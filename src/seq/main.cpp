@@ -6,24 +6,96 @@
 #include "Molecule.h"
 #include "Docking.h"
 #include "Utils.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Partition.h"
+
+// Checkpointed run: the pending pairs are scored in cost-balanced units and every
+// finished unit is queued to the checkpoint, which writes it in the background.
+static void sequential_docking_checkpointed(const std::vector<Molecule>& proteins,
+                                            const std::vector<Molecule>& ligands,
+                                            const DockingScorer& scorer,
+                                            const ScreeningOptions& options,
+                                            std::vector<float>& scores,
+                                            HitCollector& hits) {
+    Checkpoint checkpoint;
+    if (!openCheckpoint(options, proteins, ligands, 0, true, checkpoint)) {
+        std::cerr << "Error opening the checkpoint." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t total = proteins.size() * ligands.size();
+    const bool keepHits = options.hits.enabled();
+    if (!keepHits)
+        scores.resize(total);
+    checkpoint.restore(keepHits ? nullptr : scores.data(), keepHits ? &hits : nullptr);
+
+    PairCostModel model(proteins, ligands, options.docking);
+    for (const PairRange& unit : model.splitRanges(pendingRanges(checkpoint.getCompleted(), total),
+                                                   checkpointUnits(1))) {
+        TraceScope trace("unit", "compute", unit.begin, unit.end);
+        HitCollector unitHits(options.hits);
+        for (size_t idx = unit.begin; idx < unit.end; ++idx) {
+            size_t i = idx / ligands.size();
+            size_t j = idx % ligands.size();
+            float score = scorer.score(i, ligands[j]);
+            if (keepHits)
+                unitHits.add(i, j, score);
+            else
+                scores[idx] = score;
+        }
+        if (keepHits) {
+            checkpoint.recordHits(unit, unitHits);
+            hits.merge(unitHits);
+        } else {
+            checkpoint.recordScores(unit, scores.data() + unit.begin);
+        }
+    }
+    checkpoint.close();
+}
+
+// Streaming run: loader threads parse the ligands in batches while this thread scores
+// each batch against every protein; only the hits are kept.
+static void sequential_docking_stream(const std::vector<Molecule>& proteins, const ScreeningOptions& options) {
+    Timer timer;
+    timer.start();
+    std::cout << "Sequential Mode (streaming ligands)" << std::endl;
+    DockingScorer scorer(proteins, options.docking);
+    reportApproximationError(scorer);
+    LigandStream stream;
+    if (!stream.open(options.ligandsDir, options.streamLoaders, DEFAULT_STREAM_QUEUE_BATCHES)) {
+        std::cerr << "Error loading ligands." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    HitCollector hits(options.hits);
+    screenLigandStream(scorer, proteins.size(), stream, hits);
+    stream.close();
+    timer.stop();
+    std::cout << "Execution time: " << timer.elapsedMilliseconds() << " ms" << std::endl;
+    scorer.flushScoreCache();
+    printStreamSummary(stream, options.streamLoaders);
+    reportHits(hits);
+    reportMetrics(options, "seq");
+    reportTrace(options, "seq");
+}
 
 int main(int argc, char* argv[]) {
 
-    std::string proteinsDir;
-    std::string ligandsDir;
-    bool verbose;
-    
-    parseArguments(argc, argv, proteinsDir, ligandsDir, verbose);
+    ScreeningOptions options;
+    parseArguments(argc, argv, options);
 
     DataManager dataManager;
     std::vector<Molecule> proteins;
     std::vector<Molecule> ligands;
 
-    if (!dataManager.loadProteins(proteinsDir, proteins)) {
+    if (!dataManager.loadProteins(options.proteinsDir, proteins)) {
         std::cerr << "Error loading proteins." << std::endl;
         exit(EXIT_FAILURE);
     }
-    if (!dataManager.loadLigands(ligandsDir, ligands)) {
+    if (options.stream) {
+        sequential_docking_stream(proteins, options);
+        exit(EXIT_SUCCESS);
+    }
+    if (!dataManager.loadLigands(options.ligandsDir, ligands)) {
         std::cerr << "Error loading ligands." << std::endl;
         exit(EXIT_FAILURE);
     }
@@ -32,19 +104,45 @@ int main(int argc, char* argv[]) {
     timer.start();
 
     std::cout << "Sequential Mode" << std::endl;
+    DockingScorer scorer(proteins, options.docking, ligands);
+    reportApproximationError(scorer);
     std::vector<float> scores;
-    for (const auto &protein : proteins) {
-        for (const auto &ligand : ligands) {
-            float score = performDocking(protein, ligand);
-            scores.push_back(score);
+    HitCollector hits(options.hits);
+    {
+        ScopedPhase phase(PHASE_COMPUTE);
+        if (!options.checkpointDir.empty()) {
+            sequential_docking_checkpointed(proteins, ligands, scorer, options, scores, hits);
+        } else if (options.hits.enabled()) {
+            // Only the hits are kept: the score matrix is never allocated.
+            for (size_t i = 0; i < proteins.size(); ++i) {
+                TraceScope trace("protein", "compute", i * ligands.size(), (i + 1) * ligands.size());
+                for (size_t j = 0; j < ligands.size(); ++j) {
+                    hits.add(i, j, scorer.score(i, ligands[j]));
+                }
+            }
+        } else {
+            scores.reserve(proteins.size() * ligands.size());
+            for (size_t i = 0; i < proteins.size(); ++i) {
+                TraceScope trace("protein", "compute", i * ligands.size(), (i + 1) * ligands.size());
+                for (const auto &ligand : ligands) {
+                    float score = scorer.score(i, ligand);
+                    scores.push_back(score);
+                }
+            }
         }
     }
 
     timer.stop();
     std::cout << "Execution time: " << timer.elapsedMilliseconds() << " ms" << std::endl;
+    scorer.flushScoreCache();
+    saveIncrementalResults(options, proteins, ligands, scores);
 
-    if(verbose)
+    if (options.hits.enabled())
+        reportHits(hits);
+    else if(options.verbose)
         analyzeDockingResults(scores, proteins.size(), ligands.size());
+    reportMetrics(options, "seq");
+    reportTrace(options, "seq");
     
     exit(EXIT_SUCCESS);
 }
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double secondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// Two-sided 95% critical values of Student's t for 1..30 degrees of freedom.
+static const double T_95[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+BenchStats summarizeSamples(std::vector<double> samples) {
+    BenchStats stats;
+    stats.samples = samples.size();
+    if (samples.empty())
+        return stats;
+    std::sort(samples.begin(), samples.end());
+    const std::size_t n = samples.size();
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.median = (n % 2 == 1) ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    double sum = 0.0;
+    for (double value : samples)
+        sum += value;
+    stats.mean = sum / n;
+    if (n > 1) {
+        double squares = 0.0;
+        for (double value : samples)
+            squares += (value - stats.mean) * (value - stats.mean);
+        stats.stddev = std::sqrt(squares / (n - 1));
+        const double t = (n - 1 <= 30) ? T_95[n - 2] : 1.96;
+        stats.ci95 = t * stats.stddev / std::sqrt(static_cast<double>(n));
+    }
+    return stats;
+}
+
+BenchResult runBenchmark(const BenchConfig& config, const std::string& group, const std::string& name,
+                         double work, const std::string& workUnit, const std::function<void()>& body) {
+    BenchResult result;
+    result.group = group;
+    result.name = name;
+
+    // Warmup (at least one iteration, which also gives a first estimate of its cost).
+    BenchClock::time_point start = BenchClock::now();
+    for (int w = 0; w < std::max(1, config.warmup); ++w)
+        body();
+    double perIteration = secondsSince(start) / std::max(1, config.warmup);
+
+    // Iterations per sample so that a sample is long enough for the clock.
+    std::size_t iterations = 1;
+    if (perIteration > 0.0 && perIteration < config.minSampleSeconds)
+        iterations = static_cast<std::size_t>(std::ceil(config.minSampleSeconds / perIteration));
+    result.iterationsPerSample = iterations;
+
+    std::vector<double> times, rates;
+    for (int r = 0; r < config.repetitions; ++r) {
+        start = BenchClock::now();
+        for (std::size_t it = 0; it < iterations; ++it)
+            body();
+        double seconds = secondsSince(start) / iterations;
+        times.push_back(seconds);
+        rates.push_back(seconds > 0.0 ? work / seconds : 0.0);
+    }
+    result.metrics.push_back(BenchMetric{ "time", "s", summarizeSamples(times) });
+    result.metrics.push_back(BenchMetric{ "throughput", workUnit + "/s", summarizeSamples(rates) });
+    return result;
+}
+
+// Runs 'command' and returns its standard output; 'ok' is false if it failed.
+static std::string runCommand(const std::string& command, bool& ok) {
+    std::string output;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        ok = false;
+        return output;
+    }
+    char buffer[4096];
+    std::size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+        output.append(buffer, n);
+    ok = (pclose(pipe) == 0);
+    return output;
+}
+
+// Last "Execution time: X ms" reported by a run, in seconds (< 0 if there is none).
+static double reportedSeconds(const std::string& output) {
+    static const char* marker = "Execution time: ";
+    std::size_t pos = output.rfind(marker);
+    if (pos == std::string::npos)
+        return -1.0;
+    return std::strtod(output.c_str() + pos + std::strlen(marker), nullptr) / 1000.0;
+}
+
+bool runCommandBenchmark(const BenchConfig& config, const std::string& group, const std::string& name,
+                         const std::string& command, BenchResult& result) {
+    result = BenchResult();
+    result.group = group;
+    result.name = name;
+
+    std::vector<double> wall, reported;
+    for (int r = 0; r < config.warmup + config.repetitions; ++r) {
+        bool ok;
+        BenchClock::time_point start = BenchClock::now();
+        std::string output = runCommand(command, ok);
+        double seconds = secondsSince(start);
+        if (!ok) {
+            std::cerr << "Command failed: " << command << std::endl;
+            return false;
+        }
+        if (r < config.warmup)
+            continue;
+        wall.push_back(seconds);
+        double inner = reportedSeconds(output);
+        if (inner >= 0.0)
+            reported.push_back(inner);
+    }
+    result.metrics.push_back(BenchMetric{ "wall_time", "s", summarizeSamples(wall) });
+    if (reported.size() == wall.size())
+        result.metrics.push_back(BenchMetric{ "execution_time", "s", summarizeSamples(reported) });
+    return true;
+}
+
+void printBenchResult(const BenchResult& result) {
+    std::cout << result.group << "/" << result.name << ":";
+    for (const BenchMetric& metric : result.metrics) {
+        const BenchStats& s = metric.stats;
+        std::cout << "  " << metric.name << " " << s.mean << " +- " << s.ci95 << " " << metric.unit
+                  << " (median " << s.median << ", n=" << s.samples << ")";
+    }
+    std::cout << std::endl;
+}
+
+static void writeJsonString(FILE* out, const std::string& value) {
+    std::fputc('"', out);
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            std::fprintf(out, "\\%c", c);
+        else if (static_cast<unsigned char>(c) < 0x20)
+            std::fprintf(out, "\\u%04x", static_cast<unsigned char>(c));
+        else
+            std::fputc(c, out);
+    }
+    std::fputc('"', out);
+}
+
+static void writeJsonNumber(FILE* out, double value) {
+    if (std::isfinite(value))
+        std::fprintf(out, "%.9g", value);
+    else
+        std::fputs("null", out);
+}
+
+bool writeBenchJson(const std::string& filename, const BenchConfig& config,
+                    const std::vector<std::pair<std::string, std::string>>& metadata,
+                    const std::vector<BenchResult>& results) {
+    FILE* out = std::fopen(filename.c_str(), "w");
+    if (out == nullptr)
+        return false;
+
+    std::fputs("{\n  \"schema\": 1,\n  \"metadata\": {", out);
+    for (std::size_t i = 0; i < metadata.size(); ++i) {
+        std::fputs(i == 0 ? "\n    " : ",\n    ", out);
+        writeJsonString(out, metadata[i].first);
+        std::fputs(": ", out);
+        writeJsonString(out, metadata[i].second);
+    }
+    std::fprintf(out, "\n  },\n  \"config\": {\"warmup\": %d, \"repetitions\": %d, \"min_sample_seconds\": ",
+                 config.warmup, config.repetitions);
+    writeJsonNumber(out, config.minSampleSeconds);
+    std::fputs("},\n  \"results\": [", out);
+
+    for (std::size_t r = 0; r < results.size(); ++r) {
+        const BenchResult& result = results[r];
+        std::fputs(r == 0 ? "\n    {\"group\": " : ",\n    {\"group\": ", out);
+        writeJsonString(out, result.group);
+        std::fputs(", \"name\": ", out);
+        writeJsonString(out, result.name);
+        std::fputs(", \"params\": {", out);
+        for (std::size_t p = 0; p < result.params.size(); ++p) {
+            if (p > 0)
+                std::fputs(", ", out);
+            writeJsonString(out, result.params[p].first);
+            std::fputs(": ", out);
+            writeJsonNumber(out, result.params[p].second);
+        }
+        std::fprintf(out, "}, \"iterations_per_sample\": %zu, \"metrics\": [", result.iterationsPerSample);
+        for (std::size_t m = 0; m < result.metrics.size(); ++m) {
+            const BenchMetric& metric = result.metrics[m];
+            std::fputs(m == 0 ? "\n      {\"name\": " : ",\n      {\"name\": ", out);
+            writeJsonString(out, metric.name);
+            std::fputs(", \"unit\": ", out);
+            writeJsonString(out, metric.unit);
+            std::fprintf(out, ", \"samples\": %zu", metric.stats.samples);
+            const std::pair<const char*, double> fields[] = {
+                { "mean", metric.stats.mean }, { "median", metric.stats.median },
+                { "min", metric.stats.min }, { "max", metric.stats.max },
+                { "stddev", metric.stats.stddev }, { "ci95", metric.stats.ci95 }
+            };
+            for (const auto& field : fields) {
+                std::fprintf(out, ", \"%s\": ", field.first);
+                writeJsonNumber(out, field.second);
+            }
+            std::fputc('}', out);
+        }
+        std::fputs("]}", out);
+    }
+    std::fputs("\n  ]\n}\n", out);
+    return std::fclose(out) == 0;
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include <omp.h>
+#include "Benchmark.h"
+#include "DataManager.h"
+#include "Docking.h"
+#include "DockingKernels.h"
+#include "Molecule.h"
+#include "MoleculeParser.h"
+#include "Utils.h"
+
+// Micro- and macro-benchmarks of bioscreening with machine-readable (JSON) output:
+// performDocking over atom-count sweeps, PDB/SDF parsing throughput, the ranking of
+// analyzeDockingResults, loading of real data and end-to-end runs of any backend.
+
+struct BenchOptions {
+    BenchConfig config;
+    std::string jsonFile = "bench.json";
+    std::string filter;
+    std::string label;
+    bool quick = false;
+    bool micro = true;
+    std::string proteinsPath;
+    std::string ligandsPath;
+    std::vector<std::pair<std::string, std::string>> commands;   // name, command
+};
+
+static void printBenchHelp(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --reps N            measured samples per benchmark (default 10)\n"
+              << "  --warmup N          discarded samples before measuring (default 2)\n"
+              << "  --min-time S        minimum duration of a micro-benchmark sample in seconds (default 0.05)\n"
+              << "  --json FILE         output file (default bench.json)\n"
+              << "  --filter TEXT       only runs the benchmarks whose group/name contains TEXT\n"
+              << "  --label TEXT        label stored in the metadata (e.g. a commit id)\n"
+              << "  --quick             smaller sweeps\n"
+              << "  --no-micro          skips the micro-benchmarks\n"
+              << "  --data P L          also measures loading the proteins P and ligands L\n"
+              << "  --e2e NAME=COMMAND  end-to-end benchmark of a shell command (repeatable)\n";
+}
+
+static bool parseBenchArguments(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            printBenchHelp(argv[0]);
+            exit(EXIT_SUCCESS);
+        } else if (arg == "--reps" && hasValue) {
+            options.config.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options.config.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--min-time" && hasValue) {
+            options.config.minSampleSeconds = std::atof(argv[++i]);
+        } else if (arg == "--json" && hasValue) {
+            options.jsonFile = argv[++i];
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--label" && hasValue) {
+            options.label = argv[++i];
+        } else if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--no-micro") {
+            options.micro = false;
+        } else if (arg == "--data" && i + 2 < argc) {
+            options.proteinsPath = argv[++i];
+            options.ligandsPath = argv[++i];
+        } else if (arg == "--e2e" && hasValue) {
+            std::string spec = argv[++i];
+            std::size_t eq = spec.find('=');
+            if (eq == std::string::npos || eq == 0) {
+                std::cerr << "--e2e expects NAME=COMMAND: " << spec << std::endl;
+                return false;
+            }
+            options.commands.push_back(std::make_pair(spec.substr(0, eq), spec.substr(eq + 1)));
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool selected(const BenchOptions& options, const std::string& group, const std::string& name) {
+    return options.filter.empty() || (group + "/" + name).find(options.filter) != std::string::npos;
+}
+
+// Random molecule with 'atoms' atoms in a cube of side 'size' (fixed seed: every run
+// measures the same data).
+static Molecule randomMolecule(std::size_t atoms, float size, std::mt19937& rng) {
+    static const uint8_t elements[] = { ELEMENT_C, ELEMENT_N, ELEMENT_O, ELEMENT_H, ELEMENT_S };
+    std::uniform_real_distribution<float> coord(-0.5f * size, 0.5f * size);
+    Molecule mol;
+    mol.reserve(atoms);
+    for (std::size_t a = 0; a < atoms; ++a)
+        mol.addAtom(coord(rng), coord(rng), coord(rng), elements[a % 5]);
+    return mol;
+}
+
+// PDB text with 'atoms' ATOM lines (same layout as generate_dataset.py).
+static std::string syntheticPDB(std::size_t atoms, std::mt19937& rng) {
+    std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+    std::string text = "HEADER    GENERATED PROTEIN\n";
+    char line[96];
+    for (std::size_t a = 0; a < atoms; ++a) {
+        std::snprintf(line, sizeof(line), "ATOM  %5zu  CA  ALA A   1    %8.3f%8.3f%8.3f  1.00  0.00           C \n",
+                      (a % 99999) + 1, coord(rng), coord(rng), coord(rng));
+        text += line;
+    }
+    text += "TER\nEND\n";
+    return text;
+}
+
+// SDF text with 'records' V2000 records of 'atoms' atoms each.
+static std::string syntheticSDF(std::size_t records, std::size_t atoms, std::mt19937& rng) {
+    static const char* elements[] = { "C", "N", "O", "H", "S" };
+    std::uniform_real_distribution<float> coord(-50.0f, 50.0f);
+    std::string text;
+    char line[96];
+    for (std::size_t r = 0; r < records; ++r) {
+        text += "Generated Ligand\nProgrammatically generated\nComment line\n";
+        std::snprintf(line, sizeof(line), "%3zu  0  0  0  0  0            999 V2000\n", atoms);
+        text += line;
+        for (std::size_t a = 0; a < atoms; ++a) {
+            std::snprintf(line, sizeof(line), "%10.4f%10.4f%10.4f %-3s\n", coord(rng), coord(rng), coord(rng),
+                          elements[a % 5]);
+            text += line;
+        }
+        text += "M  END\n$$$$\n";
+    }
+    return text;
+}
+
+static void benchDocking(const BenchOptions& options, std::vector<BenchResult>& results) {
+    std::vector<std::size_t> proteinSizes = { 64, 256, 1024, 4096 };
+    std::vector<std::size_t> ligandSizes = { 16, 32, 64 };
+    if (options.quick) {
+        proteinSizes = { 256, 1024 };
+        ligandSizes = { 32 };
+    }
+    std::mt19937 rng(12345);
+    for (std::size_t proteinAtoms : proteinSizes) {
+        Molecule protein = randomMolecule(proteinAtoms, 40.0f, rng);
+        for (std::size_t ligandAtoms : ligandSizes) {
+            const std::string name = "p" + std::to_string(proteinAtoms) + "_l" + std::to_string(ligandAtoms);
+            if (!selected(options, "performDocking", name))
+                continue;
+            Molecule ligand = randomMolecule(ligandAtoms, 10.0f, rng);
+            volatile float sink = 0.0f;
+            BenchResult result = runBenchmark(options.config, "performDocking", name,
+                                              static_cast<double>(proteinAtoms * ligandAtoms), "atom_pairs",
+                                              [&]() { sink = sink + performDocking(protein, ligand); });
+            result.params = { { "protein_atoms", static_cast<double>(proteinAtoms) },
+                              { "ligand_atoms", static_cast<double>(ligandAtoms) } };
+            printBenchResult(result);
+            results.push_back(result);
+        }
+    }
+}
+
+static void benchParsing(const BenchOptions& options, std::vector<BenchResult>& results) {
+    std::mt19937 rng(54321);
+    const std::size_t pdbAtoms = options.quick ? 10000 : 100000;
+    if (selected(options, "parsePDB", "atoms" + std::to_string(pdbAtoms))) {
+        const std::string pdb = syntheticPDB(pdbAtoms, rng);
+        BenchResult result = runBenchmark(options.config, "parsePDB", "atoms" + std::to_string(pdbAtoms),
+                                          pdb.size() / 1.0e6, "MB", [&]() {
+            Molecule mol;
+            parsePDBBuffer(pdb.data(), pdb.data() + pdb.size(), mol);
+        });
+        result.params = { { "atoms", static_cast<double>(pdbAtoms) }, { "bytes", static_cast<double>(pdb.size()) } };
+        printBenchResult(result);
+        results.push_back(result);
+    }
+
+    const std::size_t records = options.quick ? 500 : 5000;
+    const std::size_t atoms = 40;
+    const std::string sdfName = "records" + std::to_string(records) + "_atoms" + std::to_string(atoms);
+    if (selected(options, "parseSDF", sdfName)) {
+        const std::string sdf = syntheticSDF(records, atoms, rng);
+        BenchResult result = runBenchmark(options.config, "parseSDF", sdfName, sdf.size() / 1.0e6, "MB", [&]() {
+            const char* pos = sdf.data();
+            const char* end = sdf.data() + sdf.size();
+            ParseStatus status;
+            while (pos < end) {
+                Molecule mol;
+                pos = parseSDFRecord(pos, end, mol, status);
+            }
+        });
+        result.params = { { "records", static_cast<double>(records) }, { "atoms_per_record", static_cast<double>(atoms) },
+                          { "bytes", static_cast<double>(sdf.size()) } };
+        printBenchResult(result);
+        results.push_back(result);
+    }
+}
+
+static void benchRanking(const BenchOptions& options, std::vector<BenchResult>& results) {
+    const int proteins = options.quick ? 50 : 200;
+    const int ligands = options.quick ? 1000 : 5000;
+    const std::string name = std::to_string(proteins) + "x" + std::to_string(ligands);
+    if (!selected(options, "analyzeDockingResults", name))
+        return;
+    std::mt19937 rng(777);
+    std::normal_distribution<float> score(0.0f, 1.0f);
+    std::vector<float> scores(static_cast<std::size_t>(proteins) * ligands);
+    for (float& s : scores)
+        s = score(rng);
+
+    // The report itself is not measured: standard output goes nowhere meanwhile.
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cout.rdbuf(discarded.rdbuf());
+    BenchResult result = runBenchmark(options.config, "analyzeDockingResults", name,
+                                      static_cast<double>(scores.size()), "scores", [&]() {
+        analyzeDockingResults(scores, proteins, ligands);
+        discarded.str(std::string());
+    });
+    std::cout.rdbuf(previous);
+    result.params = { { "proteins", static_cast<double>(proteins) }, { "ligands", static_cast<double>(ligands) } };
+    printBenchResult(result);
+    results.push_back(result);
+}
+
+static void benchLoading(const BenchOptions& options, std::vector<BenchResult>& results) {
+    const std::pair<std::string, bool> inputs[] = { { options.proteinsPath, true }, { options.ligandsPath, false } };
+    for (const auto& input : inputs) {
+        const std::string name = input.second ? "proteins" : "ligands";
+        if (!selected(options, "load", name))
+            continue;
+        DataManager dataManager;
+        std::size_t atoms = 0;
+        BenchResult result = runBenchmark(options.config, "load", name, 0.0, "atoms", [&]() {
+            std::vector<Molecule> molecules;
+            if (input.second)
+                dataManager.loadProteins(input.first, molecules);
+            else
+                dataManager.loadLigands(input.first, molecules);
+            atoms = 0;
+            for (const Molecule& mol : molecules)
+                atoms += mol.getAtomCount();
+        });
+        // The amount of work is only known after loading: rescale the throughput.
+        for (BenchMetric& metric : result.metrics) {
+            if (metric.name != "throughput")
+                continue;
+            const BenchStats& time = result.metrics[0].stats;
+            metric.stats = BenchStats();
+            metric.stats.samples = time.samples;
+            metric.stats.mean = time.mean > 0.0 ? atoms / time.mean : 0.0;
+            metric.stats.median = time.median > 0.0 ? atoms / time.median : 0.0;
+            metric.stats.min = time.max > 0.0 ? atoms / time.max : 0.0;
+            metric.stats.max = time.min > 0.0 ? atoms / time.min : 0.0;
+        }
+        result.params = { { "atoms", static_cast<double>(atoms) },
+                          { "files", static_cast<double>(dataManager.getLastReport().filesFound) } };
+        printBenchResult(result);
+        results.push_back(result);
+    }
+}
+
+static std::string currentTimestamp() {
+    char buffer[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buffer;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseBenchArguments(argc, argv, options)) {
+        printBenchHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchResult> results;
+    if (options.micro) {
+        benchDocking(options, results);
+        benchParsing(options, results);
+        benchRanking(options, results);
+    }
+    if (!options.proteinsPath.empty())
+        benchLoading(options, results);
+    for (const auto& command : options.commands) {
+        if (!selected(options, "e2e", command.first))
+            continue;
+        BenchResult result;
+        if (!runCommandBenchmark(options.config, "e2e", command.first, command.second, result))
+            return EXIT_FAILURE;
+        printBenchResult(result);
+        results.push_back(result);
+    }
+
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    std::vector<std::pair<std::string, std::string>> metadata = {
+        { "timestamp", currentTimestamp() },
+        { "label", options.label },
+        { "host", host },
+        { "compiler", __VERSION__ },
+        { "simd_kernel", getLJKernelName() },
+        { "cpus", std::to_string(sysconf(_SC_NPROCESSORS_ONLN)) },
+        { "omp_max_threads", std::to_string(omp_get_max_threads()) }
+    };
+    for (const auto& command : options.commands)
+        metadata.push_back(std::make_pair("command." + command.first, command.second));
+
+    if (!writeBenchJson(options.jsonFile, options.config, metadata, results)) {
+        std::cerr << "Error writing " << options.jsonFile << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << results.size() << " results to " << options.jsonFile << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "DataManager.h"
+#include "Molecule.h"
+#include "MoleculeLibrary.h"
+#include "Utils.h"
+
+// Converts a directory (or file) of PDB/SDF molecules into a binary .bslib library
+// that bioscreening can memory-map without parsing.
+static void printConvertHelp(const char* program) {
+    std::cout << "Usage: " << program << " --proteins|--ligands <input_path> <output" << LIBRARY_EXTENSION << ">\n"
+              << "  --proteins   load .pdb files (as the proteins argument does)\n"
+              << "  --ligands    load .pdb and .sdf files (as the ligands argument does)\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 4 || (std::string(argv[1]) != "--proteins" && std::string(argv[1]) != "--ligands")) {
+        printConvertHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const bool proteins = std::string(argv[1]) == "--proteins";
+    const std::string input = argv[2];
+    const std::string output = argv[3];
+
+    Timer timer;
+    timer.start();
+    DataManager dataManager;
+    std::vector<Molecule> molecules;
+    bool loaded = proteins ? dataManager.loadProteins(input, molecules)
+                           : dataManager.loadLigands(input, molecules);
+    if (!loaded) {
+        std::cerr << "Error loading molecules from " << input << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const LoadReport& report = dataManager.getLastReport();
+    if (!saveLibrary(output, molecules, report.sources)) {
+        std::cerr << "Error writing library " << output << std::endl;
+        return EXIT_FAILURE;
+    }
+    timer.stop();
+
+    std::size_t atoms = 0;
+    for (const Molecule& mol : molecules)
+        atoms += mol.getAtomCount();
+    std::cout << "Wrote " << molecules.size() << " molecules (" << atoms << " atoms, "
+              << getLibrarySize(molecules, report.sources) << " bytes) to " << output
+              << " in " << timer.elapsedMilliseconds() << " ms." << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#!/bin/bash
+# Script para ejecutar la suite de benchmarks y guardar los resultados en JSON.
+# Uso: ./tests/bench.sh [repeticiones] [fichero_json]
+#   repeticiones -> (opcional) muestras medidas por benchmark (default: 10)
+#   fichero_json -> (opcional) fichero de salida (default: bench.json)
+# Las variables PROTEINS y LIGANDS eligen los datos de las pruebas de extremo a extremo
+# (default: los directorios por defecto de bioscreening) y NP el número de procesos MPI.
+
+REPS=${1:-10}
+JSON=${2:-bench.json}
+PROTEINS=${PROTEINS:-data/proteins}
+LIGANDS=${LIGANDS:-data/ligands}
+NP=${NP:-4}
+
+# Compilamos la suite y cada backend disponible con un nombre propio. compile.sh
+# siempre genera ./bioscreening: el que hubiera se aparta y se restaura al terminar.
+./compile.sh 7 || exit 1
+backup=""
+if [ -e bioscreening ]; then
+    backup=$(mktemp bioscreening.bench.XXXXXX) || exit 1
+    mv -f bioscreening "$backup"
+fi
+restore_build() {
+    rm -f bioscreening
+    if [ -n "$backup" ]; then
+        mv -f "$backup" bioscreening
+    fi
+}
+trap restore_build EXIT
+e2e_args=()
+for option in 1 2 3 5; do
+    case $option in
+        1) name=seq ;;
+        2) name=omp ;;
+        3) name=mpi ;;
+        5) name=omp_mpi ;;
+    esac
+    rm -f bioscreening
+    ./compile.sh $option > /dev/null 2>&1
+    if [ ! -x bioscreening ]; then
+        echo "No se pudo compilar la versión $name; se omite."
+        continue
+    fi
+    mv bioscreening "bioscreening_$name"
+    if [ $option -eq 3 ] || [ $option -eq 5 ]; then
+        command="mpirun -np $NP ./bioscreening_$name $PROTEINS $LIGANDS"
+    else
+        command="./bioscreening_$name $PROTEINS $LIGANDS"
+    fi
+    e2e_args+=(--e2e "$name=$command")
+done
+
+# Microbenchmarks, carga de los datos y ejecuciones de extremo a extremo
+./bioscreening_bench --reps "$REPS" --json "$JSON" --label "$(git rev-parse --short HEAD 2>/dev/null)" \
+    --data "$PROTEINS" "$LIGANDS" "${e2e_args[@]}"